@@ -0,0 +1,46 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "maths.h"
+#include "frustum.h"
+
+// Bounding volume hierarchy over spheres. Items are referenced by their index
+// in the caller's arrays; spheres with a radius of zero or less are inactive and
+// never reported. Every node owns a contiguous range of `items`, so a subtree fully
+// inside a query is emitted without visiting its leaves.
+
+#define BVH_LEAF_SIZE 8
+#define BVH_MAX_DEPTH 64
+
+typedef struct {
+    vec3     min, max;          // Empty (min > max) when no active item is below
+    uint32_t first, count;      // Range in Bvh.items
+    uint32_t left;              // Right child is left + 1; 0 marks a leaf
+} BvhNode;
+
+typedef struct {
+    BvhNode  *nodes;
+    size_t    node_count, node_capacity;
+
+    uint32_t *items;            // Item ids in leaf order
+    float    *x, *y, *z, *radius; // Spheres gathered into leaf order by the last refit
+    size_t    count, capacity;
+
+    float     built_cost;       // Summed node surface area right after the build
+} Bvh;
+
+// Rebuilds when the item count changed or refitting has bloated the tree;
+// otherwise only recomputes node bounds bottom-up. Arrays are indexed by item id.
+void   bvh_update(Bvh *bvh, const float *x, const float *y, const float *z, const float *radius, size_t count);
+void   bvh_build(Bvh *bvh, const float *x, const float *y, const float *z, const float *radius, size_t count);
+void   bvh_free(Bvh *bvh);
+
+// Writes the FrustumResult of every item the frustum touches into
+// out_result[item]; untouched items are left as they were.
+void   bvh_query_frustum(const Bvh *bvh, const Frustum *f, uint8_t *out_result);
+// Ids of items whose sphere overlaps the query sphere, in tree order
+size_t bvh_query_sphere(const Bvh *bvh, vec3 center, float radius, uint32_t *out, size_t max_out);
+
+#endif
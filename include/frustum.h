@@ -0,0 +1,26 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <stddef.h>
+#include "maths.h"
+
+typedef enum { FRUSTUM_OUTSIDE = 0, FRUSTUM_INTERSECT = 1, FRUSTUM_INSIDE = 2 } FrustumResult;
+
+// Normalised planes (left, right, bottom, top, near, far) in the space the
+// source matrix maps from; a point is inside when dot(n, p) + d >= 0 for all.
+typedef struct { vec4 planes[6]; } Frustum;
+
+void frustum_from_matrix(Frustum *f, mat4 m);
+
+FrustumResult frustum_test_sphere(const Frustum *f, vec3 center, float radius);
+// Box given in local space, placed by `model` (rotation, scale, translation)
+FrustumResult frustum_test_obb(const Frustum *f, const mat4 *model, BoundingBox local);
+// Axis-aligned box in the frustum's space
+FrustumResult frustum_test_aabb(const Frustum *f, vec3 min, vec3 max);
+
+// Classifies `count` spheres stored SoA, 8 per iteration. Writes a
+// FrustumResult per sphere; a radius of zero or less always reports outside.
+void frustum_cull_spheres(const Frustum *f, const float *x, const float *y, const float *z,
+                          const float *radius, size_t count, uint8_t *out);
+
+#endif
@@ -4,6 +4,7 @@
 #include <math.h>
 #include <string.h> 
 #include <stdint.h>
+#include "simd.h"
 
 /* --- Macros --- */
 #define MIN(a,b) ((a)<(b)?(a):(b))
@@ -94,14 +95,16 @@ static inline mat4 mat4_rotate_z(float angle) {
     return m;
 }
 
-// Matrix Multiplication (A * B)
+// Matrix Multiplication (A * B): column c of the result is A's columns
+// weighted by column c of B, four rows at a time
 static inline mat4 mat4_mul(mat4 a, mat4 b) {
-    mat4 res = {0};
-    for(int c=0; c<4; c++) {
-        for(int r=0; r<4; r++) {
-            res.m[c][r] = a.m[0][r]*b.m[c][0] + a.m[1][r]*b.m[c][1] + 
-                          a.m[2][r]*b.m[c][2] + a.m[3][r]*b.m[c][3];
-        }
+    f32x4 a0 = f32x4_load(a.m[0]), a1 = f32x4_load(a.m[1]);
+    f32x4 a2 = f32x4_load(a.m[2]), a3 = f32x4_load(a.m[3]);
+    mat4 res;
+    for (int c = 0; c < 4; c++) {
+        f32x4 col = a0 * f32x4_splat(b.m[c][0]) + a1 * f32x4_splat(b.m[c][1]) +
+                    a2 * f32x4_splat(b.m[c][2]) + a3 * f32x4_splat(b.m[c][3]);
+        f32x4_store(res.m[c], col);
     }
     return res;
 }
@@ -129,6 +132,18 @@ static inline mat4 mat4_perspective(float fov_rad, float aspect, float znear, fl
     return m;
 }
 
+// Maps view space [l, r] x [b, t] x [-n, -f] to the same clip cube as mat4_perspective
+static inline mat4 mat4_ortho(float l, float r, float b, float t, float znear, float zfar) {
+    mat4 m = mat4_identity();
+    m.m[0][0] = 2.0f / (r - l);
+    m.m[1][1] = 2.0f / (t - b);
+    m.m[2][2] = -2.0f / (zfar - znear);
+    m.m[3][0] = -(r + l) / (r - l);
+    m.m[3][1] = -(t + b) / (t - b);
+    m.m[3][2] = -(zfar + znear) / (zfar - znear);
+    return m;
+}
+
 static inline mat4 mat4_lookat(vec3 eye, vec3 center, vec3 up) {
     vec3 f = vec3_norm(vec3_sub(center, eye)); // Forward
     vec3 s = vec3_norm(vec3_cross(f, up));     // Right
@@ -196,6 +211,35 @@ static inline uint32_t blend_colors(uint32_t src, uint32_t dst) {
     return (r << 24) | (g << 16) | (b << 8) | 0xFF;
 }
 
+// Scalar R11G11B10 packing, bit-identical to f32x8_to_r11g11b10 in simd.h
+static inline uint32_t float_to_small(float v, int mantissa_bits, float max) {
+    v = v > 0.0f ? MIN(v, max) : 0.0f;
+    uint32_t u;
+    memcpy(&u, &v, sizeof(u));
+    if (u < (113u << 23)) return 0;
+    return (u - (112u << 23) + (1u << (22 - mantissa_bits))) >> (23 - mantissa_bits);
+}
+static inline float small_to_float(uint32_t s, int mantissa_bits) {
+    if (s == 0) return 0.0f;
+    uint32_t u = (s << (23 - mantissa_bits)) + (112u << 23);
+    float v;
+    memcpy(&v, &u, sizeof(v));
+    return v;
+}
+
+static inline uint32_t vec3_to_r11g11b10(vec3 v) {
+    return float_to_small(v.x, 6, R11_MAX) | float_to_small(v.y, 6, R11_MAX) << 11 | float_to_small(v.z, 5, B10_MAX) << 22;
+}
+static inline vec3 r11g11b10_to_vec3(uint32_t c) {
+    return (vec3){ small_to_float(c & 0x7FFu, 6), small_to_float((c >> 11) & 0x7FFu, 6), small_to_float(c >> 22, 5) };
+}
+
+// blend_colors for R11G11B10, with the alpha passed separately
+static inline uint32_t blend_r11g11b10(uint32_t src, float alpha, uint32_t dst) {
+    vec3 s = r11g11b10_to_vec3(src), d = r11g11b10_to_vec3(dst);
+    return vec3_to_r11g11b10(vec3_add(vec3_mul(s, alpha), vec3_mul(d, 1.0f - alpha)));
+}
+
 typedef struct {
     vec3 position;
     vec3 rotation; // Euler angles in radians (X, Y, Z)
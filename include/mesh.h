@@ -15,7 +15,26 @@ typedef struct {
     uint32_t color;         
 } Vertex;
 
-typedef struct { Vertex v[3]; uint32_t draw_id; } Triangle;
+typedef struct {
+    Vertex   v[3];
+    uint32_t draw_id;
+    uint32_t prim_id;           // Index of the triangle in its mesh
+} Triangle;
+
+// --- Meshlets: runs of consecutive triangles culled as a unit ---
+#define MESHLET_MAX_VERTICES  64
+#define MESHLET_MAX_TRIANGLES 124
+
+typedef struct {
+    vec3     center;            // Bounding sphere (object space)
+    float    radius;
+    vec3     cone_axis;         // Every triangle normal lies within the cone
+    float    cone_cutoff;       // >= 1 when the cone is too wide to ever reject
+    uint32_t index_offset;      // First index in mesh->indices
+    uint32_t triangle_count;
+    uint32_t vertex_offset;     // Into mesh->meshlet_vertices
+    uint32_t vertex_count;
+} Meshlet;
 
 typedef struct {
     float *p_x, *p_y, *p_z;    
@@ -25,13 +44,62 @@ typedef struct {
     uint32_t *indices;         
     size_t vertex_count;
     size_t index_count;
+
+    // Object-space bounds, kept current by load_mesh and mesh_center_origin
+    BoundingBox bounds;
+    float       bounds_radius;   // Sphere around bounds.center
+
+    // Built by mesh_build_meshlets when an OBJ is parsed, and stored in its cache file
+    Meshlet  *meshlets;
+    uint32_t *meshlet_vertices;   // Unique vertex indices per meshlet
+    size_t    meshlet_count;
+
+    // Set when the arrays point into a memory-mapped cache file
+    void  *mapping;
+    size_t mapping_size;
 } Mesh;
 
 Mesh load_mesh(const char *filename);
 void free_mesh(Mesh *mesh);
 
+// Parses an OBJ directly, bypassing the cache (n-gons are fan triangulated).
+// Large files are split across threads automatically; the parallel variant
+// forces it (thread_count <= 0 picks the core count).
+Mesh mesh_parse_obj(const char *filename);
+Mesh mesh_parse_obj_parallel(const char *filename, int thread_count);
+
+// --- Binary Cache (<file>.meshbin next to the OBJ) ---
+// Load returns 0 on a valid hit; the cache is stale once the OBJ size or mtime changes.
+int  mesh_cache_load(const char *obj_path, Mesh *out_mesh);
+int  mesh_cache_write(const char *obj_path, const Mesh *mesh);
+
+// --- Meshlets (greedy vertex-sharing clusters; the index buffer is reordered to match) ---
+void mesh_build_meshlets(Mesh *mesh);
+void mesh_free_meshlets(Mesh *mesh);
+
+// --- Simplification (QEM edge collapse) ---
+#define MESH_MAX_LODS          6
+#define MESH_LOD_MIN_TRIANGLES 32
+
+// Coarser versions of a mesh, each about half the triangles of the previous.
+// rms_error[i] estimates the surface deviation of levels[i] in object-space
+// units: the area-weighted RMS distance to the original planes, summed over
+// the levels. It is not a bound; single vertices can stray further.
+typedef struct {
+    Mesh  levels[MESH_MAX_LODS];
+    float rms_error[MESH_MAX_LODS];
+    int   count;
+} MeshLODChain;
+
+// out_rms_error: the largest RMS error of any collapse made
+Mesh mesh_simplify(const Mesh *mesh, size_t target_index_count, float *out_rms_error);
+int  mesh_build_lods(const Mesh *mesh, MeshLODChain *chain);
+void mesh_free_lods(MeshLODChain *chain);
+
 // --- Geometry Helpers ---
 BoundingBox mesh_calculate_bounds(const Mesh *mesh);
+void mesh_update_bounds(Mesh *mesh);
+void mesh_calculate_normals(Mesh *mesh);
 void mesh_center_origin(Mesh *mesh);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,29 @@
+#ifndef POSTFX_H
+#define POSTFX_H
+
+#include "renderer.h"
+
+// Post-processing kernels for renderer_add_post_pass. Each works on 8 pixels
+// at a time with f32x8 channels; the stage to register it with is noted.
+
+// POST_TILE. Exposure, then saturation around Rec. 709 luma, then contrast
+// around mid grey; vignette darkens the corners by that fraction.
+typedef struct {
+    float exposure, saturation, contrast, vignette;
+} PostGrade;
+
+// POST_HALO. Unsharp mask over the 4 nearest neighbours; 0 leaves the image as is.
+typedef struct {
+    float amount;
+} PostSharpen;
+
+// POST_HALO. Adds the 5x5 box average of what exceeds `threshold`, scaled by `intensity`.
+typedef struct {
+    float threshold, intensity;
+} PostBloom;
+
+void post_grade(const uint32_t *src, uint32_t *dst, int width, int height, TileRange rect, void *params);
+void post_sharpen(const uint32_t *src, uint32_t *dst, int width, int height, TileRange rect, void *params);
+void post_bloom(const uint32_t *src, uint32_t *dst, int width, int height, TileRange rect, void *params);
+
+#endif
@@ -5,23 +5,108 @@
 #include <stdatomic.h>
 #include <pthread.h>
 #include "mesh.h"
+#include "stats.h"
+#include "trace.h"
 
 typedef void (*VertexShader)(int index, const Mesh *mesh, Vertex *out_vertex, void *uniforms);
-typedef uint32_t (*FragmentShader)(Triangle *t, float b0, float b1, float b2, void *uniforms);
+typedef uint32_t (*FragmentShader)(Triangle *t, float b0, float b1, float b2, void *uniforms);  // NULL draws depth only
+
+// --- Batched shading ---
+// Fragments of one draw call are collected as 2x2 quads and shaded together,
+// so shaders loop over lights once per batch with SIMD across pixels.
+#define FRAGMENT_BATCH       64                     // Pixels; a multiple of 4 and of SIMD_WIDTH
+#define FRAGMENT_BATCH_QUADS (FRAGMENT_BATCH / 4)
+
+// SoA and quad-major: pixel 4q+i is lane i of quad q, lanes ordered (x, y),
+// (x+1, y), (x, y+1), (x+1, y+1). Every lane holds perspective-correct
+// attributes, including helper lanes outside `mask` that extrapolate the
+// triangle's planes so derivatives stay defined. `count` is padded to a
+// multiple of SIMD_WIDTH with copies of the last quad that are never written.
+typedef struct {
+    int       count;
+    uint64_t  mask;                                 // Bit i: pixel i passed coverage and depth and will be written
+    Triangle *tri[FRAGMENT_BATCH_QUADS];
+    int       x[FRAGMENT_BATCH_QUADS], y[FRAGMENT_BATCH_QUADS];   // Top-left pixel of each quad
+    _Alignas(32) float b0[FRAGMENT_BATCH];          // Screen-space barycentrics, as passed to a FragmentShader
+    _Alignas(32) float b1[FRAGMENT_BATCH];
+    _Alignas(32) float b2[FRAGMENT_BATCH];
+    _Alignas(32) float z[FRAGMENT_BATCH];           // Depth as tested and written
+    _Alignas(32) float w[FRAGMENT_BATCH];           // Clip-space w
+    _Alignas(32) float world_x[FRAGMENT_BATCH], world_y[FRAGMENT_BATCH], world_z[FRAGMENT_BATCH];
+    _Alignas(32) float nx[FRAGMENT_BATCH], ny[FRAGMENT_BATCH], nz[FRAGMENT_BATCH];   // Not renormalised
+    _Alignas(32) float u[FRAGMENT_BATCH], v[FRAGMENT_BATCH];
+} FragmentBatch;
+
+// Writes out_colors[i] for every pixel in b->mask; other entries are ignored
+typedef void (*BatchShader)(const FragmentBatch *b, void *uniforms, uint32_t *out_colors);
+
+// Coarse derivatives of attribute `a` at pixel i: one value per quad, like ddx/ddy on GPUs
+static inline float batch_ddx(const float *a, int i) { i &= ~3; return a[i + 1] - a[i]; }
+static inline float batch_ddy(const float *a, int i) { i &= ~3; return a[i + 2] - a[i]; }
+// The SIMD_WIDTH-bit slice of the mask starting at pixel i
+static inline uint32_t batch_mask8(const FragmentBatch *b, int i) { return (uint32_t)(b->mask >> i) & 0xFFu; }
 
 typedef enum { CULL_NONE, CULL_BACK_CCW, CULL_BACK_CW } CullMode;
-typedef enum { STAGE_IDLE, STAGE_VERTEX, STAGE_ASSEMBLE, STAGE_RASTER } RenderStage;
+// LESS tests and writes; EQUAL passes only the depth already stored, as after a prepass
+typedef enum { DEPTH_LESS, DEPTH_LESS_NO_WRITE, DEPTH_EQUAL, DEPTH_OFF } DepthMode;
+// ADD saturates per channel. ALPHA draws are binned apart and composited per
+// pixel in depth order over the tile's finished opaque colour, whatever their
+// submission order; alpha is the colour's low byte times the blend constant.
+typedef enum { BLEND_OPAQUE, BLEND_ADD, BLEND_ALPHA } BlendMode;
+#define OIT_MAX_LAYERS 16           // Nearest transparent fragments composited per pixel
+
+// Per-thread fragment lists of the tile being rasterized; see renderer.c
+typedef struct OitArena OitArena;
+
+// Multisampling keeps MSAA_SAMPLES colours and depths per pixel for the tile
+// being rasterized only, and resolves them into the framebuffer as it finishes
+#define MSAA_SAMPLES 4
+typedef struct MsaaTile MsaaTile;
+
+// Temporal reuse keeps each pixel's opaque shading for the next frame; every
+// pixel is still reshaded at least once per TEMPORAL_MAX_AGE frames
+#define TEMPORAL_MAX_AGE 8
+typedef struct TemporalCache TemporalCache;
+
+// Assembly, raster and write-out kernels specialized for one (cull, depth,
+// blend) combination; see PIPELINE_KERNELS in renderer.c
+typedef struct PipelineKernels PipelineKernels;
+typedef enum { STAGE_IDLE, STAGE_VERTEX, STAGE_ASSEMBLE, STAGE_RASTER, STAGE_POST } RenderStage;
 
 typedef struct { int x0, x1, y0, y1; } TileRange;
-typedef struct { int x0, y0, x1, y1; int tri_offset, triangle_count; } Tile;
+typedef struct { int x0, y0, x1, y1; int tri_offset, triangle_count; int alpha_offset, alpha_count; } Tile;
+
+// --- Post-processing ---
+// A pass rewrites the pixels of `rect` in `dst`, reading `src`. POST_TILE passes
+// run on each tile as soon as it is rasterized, in place (src == dst), so they
+// may only read pixels inside rect. POST_HALO passes run in a stage of their
+// own once every tile is done: src is the whole finished frame, read-only, so
+// they can read neighbours across tile edges, clamped to width x height.
+// Tile passes run before halo passes, each group in the order it was added.
+typedef enum { POST_TILE, POST_HALO } PostStage;
+typedef void (*PostKernel)(const uint32_t *src, uint32_t *dst, int width, int height, TileRange rect, void *params);
+typedef struct { PostKernel kernel; PostStage stage; void *params; } PostPass;
+#define POST_MAX_PASSES 8
 
 typedef struct {
     Mesh           *mesh;
     size_t          uniform_offset; 
     VertexShader    vertex_shader;
     FragmentShader  fragment_shader;
+    BatchShader     batch_shader;   // NULL runs fragment_shader pixel by pixel
     CullMode        cull_mode;
+    DepthMode       depth_mode;
+    BlendMode       blend_mode;
+    float           blend_constant;
+    const PipelineKernels *pipeline;
+    const PipelineKernels *prepass; // Depth-only kernels run over the tile first, NULL outside the prepass
     size_t          vertex_offset; 
+    size_t          meshlet_offset; // Into meshlet_visible when cluster_cull is set
+    int             cluster_cull;
+    uint32_t        temporal_key;   // renderer_set_draw_key while temporal reuse is on, else 0
+#ifdef RENDERER_STATS
+    int             stats_shader_slot;
+#endif
 } DrawCall;
 
 typedef struct {
@@ -45,6 +130,19 @@ typedef struct {
     size_t       total_vertex_count;
     size_t       total_max_triangles;
 
+    uint8_t     *meshlet_visible;   // Written by the vertex stage, read by assembly
+    size_t       meshlet_visible_cap, total_meshlet_count;
+    int          cluster_culling;
+    int          batch_shading;     // Off: every draw uses its per-pixel shader
+    int          depth_prepass;     // Opaque DEPTH_LESS draws recorded while set go through the prepass
+    int          prepass_draws;     // Some draw of this frame was recorded with prepass kernels
+    int          msaa;              // Draws recorded while set test MSAA_SAMPLES samples per pixel
+    int          hdr;               // Colour is R11G11B10 while a tile rasterizes, RGBA8888 once it is done
+    float        tonemap_exposure, tonemap_white;
+    uint8_t     *tonemap_lut;       // Tonemapped 0..1 to gamma-encoded bytes
+    int          temporal;          // Opaque draws look up and fill temporal_cache
+    uint32_t     draw_key;
+
     DrawCall    *draw_calls;
     size_t       draw_call_count, draw_call_capacity;
     void        *uniform_pool;
@@ -56,6 +154,7 @@ typedef struct {
     
     int             thread_count;
     pthread_t      *threads;
+    atomic_int      next_worker_id;
     pthread_mutex_t lock;
     pthread_cond_t  can_work, done_working;   
     int             active_workers, shutdown;
@@ -63,18 +162,94 @@ typedef struct {
     void           *uniforms;      
     VertexShader    vertex_shader; 
     FragmentShader  fragment_shader; 
+    BatchShader     batch_shader;
     CullMode        cull_mode; 
+    DepthMode       depth_mode;
+    BlendMode       blend_mode;
+    float           blend_constant;
+
+    OitArena       *oit;            // [thread_count], index 0 is the main thread
+    MsaaTile       *msaa_tiles;     // [thread_count], allocated when MSAA is first enabled
+    TemporalCache  *temporal_cache; // Allocated when temporal reuse is first enabled
+
+    PostPass        post_passes[POST_MAX_PASSES];
+    int             post_pass_count;
+    int             post_current;   // Halo pass the POST stage runs
+    uint32_t       *post_buffer;    // Halo passes write here, then swap it with color_buffer
+
+#ifdef RENDERER_STATS
+    RenderStats    *thread_stats;   // [thread_count], index 0 is the main thread
+    FragmentShader  stats_shaders[STATS_MAX_SHADERS];
+    int             stats_shader_count;
+    uint64_t        stats_frame;
+#endif
+
+#ifdef RENDERER_TRACE
+    TraceRing      *trace_rings;    // [thread_count], index 0 is the main thread
+    int             trace_enabled;
+#endif
 } Renderer;
 
 Renderer* renderer_create(size_t w, size_t h, int threads, int tw, int th);
 void      renderer_destroy(Renderer *r);
 void      renderer_clear(Renderer *r, uint32_t c, float depth);
+void      renderer_clear_depth(Renderer *r, float depth);
 void      renderer_set_uniforms(Renderer *r, void *uniforms);
 void      renderer_set_shaders(Renderer *r, VertexShader vs, FragmentShader fs);
+// Batched variant of the bound fragment shader, NULL to shade pixel by pixel
+void      renderer_set_batch_shader(Renderer *r, BatchShader bs);
 void      renderer_set_cull_mode(Renderer *r, CullMode mode);
+void      renderer_set_depth_mode(Renderer *r, DepthMode mode);
+void      renderer_set_blend_mode(Renderer *r, BlendMode mode);
+// Scales the alpha of BLEND_ALPHA fragments, 1 by default
+void      renderer_set_blend_constant(Renderer *r, float alpha);
+void      renderer_set_cluster_culling(Renderer *r, int enabled);
+void      renderer_set_batch_shading(Renderer *r, int enabled);
+// Each tile first rasterizes the depth of its opaque DEPTH_LESS draws, then
+// shades them with DEPTH_EQUAL: one fragment shader call per covered pixel
+void      renderer_set_depth_prepass(Renderer *r, int enabled);
+// 4x MSAA: coverage and depth per sample, one fragment shader call per pixel.
+// Switch between frames only; every draw of a frame must agree.
+void      renderer_set_msaa(Renderer *r, int enabled);
+// HDR: shaders write linear colour as packed R11G11B10 floats (Uniforms.hdr),
+// still 32 bits per pixel, and blending and the MSAA resolve work in float.
+// Each tile is tonemapped to RGBA8888 in place when it finishes, before its
+// post passes. Switch between frames only; the frame must be cleared.
+void      renderer_set_hdr(Renderer *r, int enabled);
+// Scales by exposure, maps `white` to 1 with extended Reinhard per channel,
+// then encodes with 1 / gamma. Defaults are 1, 4 and 1.
+void      renderer_set_tonemap(Renderer *r, float exposure, float white, float gamma);
+// Temporal reuse: an opaque fragment whose surface point reprojects onto a
+// pixel that the same triangle, drawn last frame with the same key, left at
+// the same depth takes that pixel's colour instead of running the fragment
+// shader. Shading that depends on the view drifts until the pixel's refresh
+// comes up. Enabling drops the history.
+void      renderer_set_temporal_reuse(Renderer *r, int enabled);
+// Stands for everything the next draws' shading depends on besides the surface
+// point: mesh, transform, material, lights, time. 0 never reuses.
+void      renderer_set_draw_key(Renderer *r, uint32_t key);
+// World to clip of the frame being recorded; the next frame reprojects with it
+void      renderer_set_temporal_view(Renderer *r, mat4 view_proj);
 void      renderer_draw_mesh(Renderer *r, Mesh *mesh);
+// Appends a pass run by every renderer_rasterize from then on; `params` is
+// passed through and must outlive it. Returns 0 once POST_MAX_PASSES are set.
+int       renderer_add_post_pass(Renderer *r, PostKernel kernel, PostStage stage, void *params);
+void      renderer_clear_post_passes(Renderer *r);
 void      renderer_reset(Renderer *r);
 void      renderer_bin_triangles(Renderer *r);
 void      renderer_rasterize(Renderer *r);
 
+// --- Instrumentation (zeroed unless built with RENDERER_STATS) ---
+void      renderer_stats_collect(const Renderer *r, RenderStats *out_total);
+const RenderStats* renderer_stats_thread(const Renderer *r, int thread);
+// Rows end with a column per shader drawn so far: write the header again
+// whenever stats_shader_count changes
+void      renderer_stats_dump_csv(const Renderer *r, FILE *f, int write_header);
+void      renderer_stats_dump_json(const Renderer *r, FILE *f);
+
+// --- Timeline tracing (no-op unless built with RENDERER_TRACE) ---
+// Dump only between frames, while the workers are idle.
+void      renderer_trace_enable(Renderer *r, int enabled);
+int       renderer_trace_dump(const Renderer *r, const char *path);
+
 #endif
\ No newline at end of file
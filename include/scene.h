@@ -5,44 +5,175 @@
 #include "camera.h"
 #include "shader.h"
 #include "platform.h" 
+#include "bvh.h"
 
-#define MAX_SCENE_MESHES 16
+// Default Scene.light_threshold: a light's radius ends where its attenuated
+// intensity falls below this
+#define SCENE_LIGHT_THRESHOLD 0.05f
+
+typedef enum { MESH_LOADING, MESH_READY, MESH_FAILED } MeshLoadState;
+
+// Post-load steps run on the loader thread (async callers never see the raw mesh)
+enum { MESH_LOAD_CENTER_ORIGIN = 1 << 0, MESH_LOAD_BUILD_LODS = 1 << 1 };
+
+// Registry entry; individually allocated so handles stay valid as the registry grows.
+typedef struct SceneMesh {
+    Mesh mesh;                       // Only touched by the loader until state is MESH_READY
+    atomic_int state;
+    const Mesh *proxy;               // Drawn while loading, NULL skips the entity
+    MeshLODChain lods;               // Empty unless built with MESH_LOAD_BUILD_LODS
+    char *path;
+    unsigned flags;
+    struct SceneMesh *next_pending;
+} SceneMesh;
 
 typedef struct {
-    Mesh *mesh;
-    vec3 position;
-    vec3 rotation;
-    float scale;
-    vec3 base_color;
-    
-    VertexShader vs;
-    FragmentShader fs;
-
-    bool visible;
-} Entity;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake, idle;
+    SceneMesh *head, *tail;          // FIFO of requests not yet picked up
+    int busy, running, shutdown;
+} MeshStreamer;
+
+// Scene.lights as parallel arrays, repacked each frame: the light BVH refits
+// from it and each draw gathers its lights from it into LightChunks
+typedef struct {
+    float x[MAX_LIGHTS], y[MAX_LIGHTS], z[MAX_LIGHTS];
+    float r[MAX_LIGHTS], g[MAX_LIGHTS], b[MAX_LIGHTS];
+    float intensity[MAX_LIGHTS], radius[MAX_LIGHTS];   // Radius is 0 for lights that reach nothing
+    TileRange tiles[MAX_LIGHTS];     // Renderer tiles the light's sphere can cover, empty when off screen
+    const ShadowCube *shadow[MAX_LIGHTS];   // NULL for lights without a cube this frame
+    size_t count;
+} LightBuffer;
+
+// Stable index of an entity in the scene's store
+typedef uint32_t EntityHandle;
+
+// Entities as parallel arrays, so each per-frame pass (game logic, culling,
+// transform rebuild) streams only the fields it touches
+typedef struct {
+    size_t count, capacity;
+
+    // Written by game logic through the setters below
+    float *pos_x, *pos_y, *pos_z;
+    float *rot_x, *rot_y, *rot_z;    // Euler angles in radians, applied X, then Y, then Z
+    float *scale;
+    vec3 *color;
+    float *opacity;                  // Below 1 the entity is drawn with BLEND_ALPHA
+    uint8_t *visible;
+    uint8_t *dirty;                  // Transform changed since `model` was built
+
+    // Derived from the transform, rebuilt only for dirty entities
+    mat4 *model;
+    const Mesh **bounds_mesh;        // Mesh the world sphere was computed for, NULL if stale
+    vec3 *world_center;
+    float *world_radius;
+    vec3 *world_min, *world_max;     // Box around the transformed mesh bounds
+
+    Mesh **mesh;
+    SceneMesh **asset;               // Registry entry of mesh, NULL for external meshes
+    const Texture **texture;         // Bound as Uniforms.texture, NULL for none
+    VertexShader *vs;
+    FragmentShader *fs;
+} EntityStore;
 
+// Per-frame culling scratch, indexed by handle
 typedef struct {
-    Entity *entities;
-    size_t entity_count;
-    size_t entity_capacity;
+    float *radius;                   // Conservative world bounding spheres around the entity origin
+    const Mesh **meshes;             // Resolved mesh (asset or proxy) this frame
+    uint8_t *result;                 // FrustumResult
+    uint32_t *visible;               // Handles that passed the frustum test
+    mat4 *mvps;                      // Indexed like `visible`
+    uint32_t *light_first;           // Indexed like `visible`: first chunk in Scene.light_chunks
+    uint32_t *light_count;
+    size_t capacity;
+} EntityCullScratch;
+
+typedef struct {
+    EntityStore entities;
 
     PointLight lights[MAX_LIGHTS];
     size_t light_count;
+    float light_threshold;           // Attenuation at which light radii end, SCENE_LIGHT_THRESHOLD by default
+    DirectionalLight sun;            // Off until given an intensity
+
+    // Not owned; NULL renders no shadows. Lights with casts_shadows get its
+    // cubes while any are free, and the sun gets its cascades.
+    ShadowSystem *shadows;
 
     Camera camera;
 
     // Asset Management
-    Mesh meshes[MAX_SCENE_MESHES];
-    size_t mesh_count;
+    SceneMesh **meshes;
+    size_t mesh_count, mesh_capacity;
+    MeshStreamer streamer;
+    Texture **textures;
+    size_t texture_count, texture_capacity;
+
+    EntityCullScratch cull;
+
+    // Spatial indices, refitted each frame from the current positions
+    Bvh entity_bvh;
+    Bvh light_bvh;
+    LightBuffer light_buffer;
+
+    // Every visible entity's lights, packed before the first draw of a frame
+    LightChunk *light_chunks;
+    size_t light_chunk_count, light_chunk_capacity;
+
+    // Coarsest LOD whose RMS simplification error projects below this many pixels is drawn
+    float lod_error_pixels;
 } Scene;
 
 Scene* scene_create(size_t initial_capacity);
 void   scene_destroy(Scene* scene);
 
 Mesh* scene_load_mesh(Scene* scene, const char* filepath);
-Entity* scene_add_entity(Scene* scene, Mesh* mesh, vec3 pos, vec3 rot, float scale, vec3 color);
+
+// Returns immediately; the mesh is parsed on a background I/O thread. Entities
+// using it draw `proxy` (or nothing) until it is ready. `flags` are MESH_LOAD_*.
+Mesh* scene_load_mesh_async(Scene* scene, const char* filepath, const Mesh* proxy, unsigned flags);
+MeshLoadState scene_mesh_state(const Scene* scene, const Mesh* mesh);
+void  scene_wait_for_meshes(Scene* scene);
+int   scene_build_lods(Scene* scene, Mesh* mesh);
+// Owned by the scene; NULL if the file cannot be read
+Texture* scene_load_texture(Scene* scene, const char* filepath);
+
+EntityHandle scene_add_entity(Scene* scene, Mesh* mesh, vec3 pos, vec3 rot, float scale, vec3 color);
 PointLight* scene_add_light(Scene* scene, vec3 pos, vec3 color, float intensity);
 
+// --- Entity Access ---
+static inline vec3 scene_entity_position(const Scene* scene, EntityHandle h) {
+    const EntityStore *st = &scene->entities;
+    return (vec3){ st->pos_x[h], st->pos_y[h], st->pos_z[h] };
+}
+static inline vec3 scene_entity_rotation(const Scene* scene, EntityHandle h) {
+    const EntityStore *st = &scene->entities;
+    return (vec3){ st->rot_x[h], st->rot_y[h], st->rot_z[h] };
+}
+static inline void scene_entity_set_position(Scene* scene, EntityHandle h, vec3 p) {
+    EntityStore *st = &scene->entities;
+    st->pos_x[h] = p.x; st->pos_y[h] = p.y; st->pos_z[h] = p.z;
+    st->dirty[h] = 1;
+}
+static inline void scene_entity_set_rotation(Scene* scene, EntityHandle h, vec3 r) {
+    EntityStore *st = &scene->entities;
+    st->rot_x[h] = r.x; st->rot_y[h] = r.y; st->rot_z[h] = r.z;
+    st->dirty[h] = 1;
+}
+static inline void scene_entity_set_scale(Scene* scene, EntityHandle h, float scale) {
+    scene->entities.scale[h] = scale;
+    scene->entities.dirty[h] = 1;
+}
+static inline void scene_entity_set_color(Scene* scene, EntityHandle h, vec3 color) { scene->entities.color[h] = color; }
+static inline void scene_entity_set_opacity(Scene* scene, EntityHandle h, float opacity) { scene->entities.opacity[h] = opacity; }
+static inline void scene_entity_set_visible(Scene* scene, EntityHandle h, bool visible) { scene->entities.visible[h] = visible; }
+static inline void scene_entity_set_texture(Scene* scene, EntityHandle h, const Texture* tex) { scene->entities.texture[h] = tex; }
+static inline void scene_entity_set_shaders(Scene* scene, EntityHandle h, VertexShader vs, FragmentShader fs) {
+    scene->entities.vs[h] = vs;
+    scene->entities.fs[h] = fs;
+}
+
 void scene_render(Scene* scene, Renderer* renderer, Uniforms* base_uniforms);
 void scene_render_frame(Scene* scene, Renderer* renderer, Platform* platform, Uniforms* uniforms, uint32_t clear_color);
 
@@ -2,6 +2,8 @@
 #define SHADER_H
 
 #include "renderer.h"
+#include "texture.h"
+#include "shadow.h"
 
 #define MAX_LIGHTS 1024
 
@@ -9,8 +11,37 @@ typedef struct {
     vec3 position;
     vec3 color;
     float intensity;
+    float radius;      // Influence radius, re-derived from intensity every frame by the scene
+    int casts_shadows; // Gets a cube map while the scene has a ShadowSystem with one free
 } PointLight;
 
+// Sun-like light; no contribution while intensity is 0
+typedef struct {
+    vec3 direction;    // Unit vector the light travels along
+    vec3 color;
+    float intensity;
+} DirectionalLight;
+
+// Distance at which the smooth falloff intensity / (1 + 0.1 d + 0.4 d^2) drops
+// to `threshold`; 0 when the light never reaches it. The lighting shaders fade
+// each light to zero at this one radius whatever their own falloff, so it is
+// approximate elsewhere: fs_multi_light (0.7 d^2) is already below threshold
+// there, fs_cyber_neon (0.02 d^2) is not and relies on the fade.
+static inline float light_radius(float intensity, float threshold) {
+    float c = 1.0f - intensity / threshold;    // 0.4 d^2 + 0.1 d + c = 0
+    if (c >= 0.0f) return 0.0f;
+    return (sqrtf(0.01f - 1.6f * c) - 0.1f) / 0.8f;
+}
+
+// SIMD_WIDTH lights in SoA form, so light loops shade a pixel against a whole
+// chunk per instruction. Padding lanes sit far out of their unit radius with zero intensity.
+typedef struct {
+    float x[SIMD_WIDTH], y[SIMD_WIDTH], z[SIMD_WIDTH];
+    float r[SIMD_WIDTH], g[SIMD_WIDTH], b[SIMD_WIDTH];
+    float intensity[SIMD_WIDTH], radius[SIMD_WIDTH];
+    const ShadowCube *shadow[SIMD_WIDTH];  // NULL for lights without shadows
+} LightChunk;
+
 typedef struct {
     // Coordinate Spaces
     mat4 model;
@@ -23,16 +54,29 @@ typedef struct {
     float screen_width;
     float screen_height;
 
-    const PointLight *scene_lights;        
-    uint16_t active_lights[MAX_LIGHTS];    
+    const LightChunk *lights;              // ceil(light_count / SIMD_WIDTH) chunks, in light index order
     int light_count;
+    DirectionalLight sun;
+    const ShadowCascades *sun_shadow;      // NULL leaves the sun unshadowed
     
     vec3 base_color;
+    const Texture *texture;                // Albedo for fs_textured, NULL when untextured
     vec3 cam_pos; 
     float dt;
+    int hdr;                               // Output R11G11B10 for renderer_set_hdr; set by the renderer for every draw
 } Uniforms;
 
+// Every shader's output goes through these: clamped RGBA8888, or linear HDR
+static inline uint32_t shader_pack_color(const Uniforms *u, vec3 c) {
+    return u->hdr ? vec3_to_r11g11b10(c) : vec3_to_color(c);
+}
+static inline u32x8 shader_pack_color8(const Uniforms *u, f32x8 r, f32x8 g, f32x8 b) {
+    return u->hdr ? f32x8_to_r11g11b10(r, g, b) : f32x8_to_rgba8(r, g, b);
+}
+
 void vs_default(int idx, const Mesh *mesh, Vertex *out, void *uniforms);
+// Clip position only, for depth-only draws such as shadow casters
+void vs_depth(int idx, const Mesh *mesh, Vertex *out, void *uniforms);
 
 // Shaders
 uint32_t fs_multi_light(Triangle *t, float b0, float b1, float b2, void *uniforms);
@@ -42,4 +86,27 @@ uint32_t fs_wireframe(Triangle *t, float b0, float b1, float b2, void *uniforms)
 uint32_t fs_normals(Triangle *t, float b0, float b1, float b2, void *uniforms);
 uint32_t fs_plasma_glow(Triangle *t, float b0, float b1, float b2, void *uniforms);
 uint32_t fs_cyber_neon(Triangle *t, float b0, float b1, float b2, void *uniforms);
+// fs_multi_light_smooth lighting over base_color times a texture sample
+uint32_t fs_textured(Triangle *t, float b0, float b1, float b2, void *uniforms);
+
+// Batched variants: SIMD across the pixels of a FragmentBatch, lights in the
+// outer loop. bs_textured picks one mip level per quad from the UV derivatives.
+void bs_multi_light_smooth(const FragmentBatch *b, void *uniforms, uint32_t *out);
+void bs_multi_light(const FragmentBatch *b, void *uniforms, uint32_t *out);
+void bs_normals(const FragmentBatch *b, void *uniforms, uint32_t *out);
+void bs_pure_color(const FragmentBatch *b, void *uniforms, uint32_t *out);
+void bs_textured(const FragmentBatch *b, void *uniforms, uint32_t *out);
+// Per-pixel loops with the fragment shader inlined, for shaders without a SIMD port
+void bs_wireframe(const FragmentBatch *b, void *uniforms, uint32_t *out);
+void bs_plasma_glow(const FragmentBatch *b, void *uniforms, uint32_t *out);
+void bs_cyber_neon(const FragmentBatch *b, void *uniforms, uint32_t *out);
+
+// Batched variant of a built-in fragment shader, NULL for user shaders
+BatchShader shader_get_batch(FragmentShader fs);
+
+// Whether a built-in shader animates with Uniforms.dt; user shaders count as static
+int shader_uses_time(FragmentShader fs);
+
+// Debug name of a built-in shader, NULL for user shaders
+const char* shader_get_name(FragmentShader fs);
 #endif
\ No newline at end of file
@@ -0,0 +1,72 @@
+#ifndef SHADOW_H
+#define SHADOW_H
+
+#include "renderer.h"
+#include "camera.h"
+
+// Shadow maps are drawn by a depth-only Renderer of their own (draws without a
+// fragment shader), so casters take the same vertex, binning and raster path as
+// the frame. Depth follows the renderer: NDC z mapped to 0..1, cleared to 1.
+
+#define SHADOW_CUBE_FACES     6
+#define SHADOW_CASCADES       3
+#define SHADOW_MAX_CUBES      8     // Shadowed point lights at any one time
+#define SHADOW_DEFAULT_BUDGET 8     // Maps re-rendered per frame
+
+typedef struct {
+    mat4   view_proj;               // World to the map's clip space, as last rendered
+    float  texel_world;             // Texel footprint in world units: per unit of distance for cube faces
+    int    size;
+    float *depth;                   // size * size, row-major like the depth buffer
+    uint32_t version;               // Bumped whenever depth changes
+} ShadowMap;
+
+typedef struct {
+    ShadowMap faces[SHADOW_CUBE_FACES];   // +X, -X, +Y, -Y, +Z, -Z
+    vec3      position;             // Light position the faces are rendered from
+    float     far;                  // Far plane they are rendered with
+    int       light;                // Index in Scene.lights, -1 when unused
+    uint8_t   pending;              // Bit f: face f is stale and waits for the budget
+} ShadowCube;
+
+typedef struct {
+    ShadowMap maps[SHADOW_CASCADES];
+    float     split_far[SHADOW_CASCADES];  // View depth each cascade reaches
+    vec3      cam_pos, cam_forward;        // Camera the splits were fitted to
+    vec3      to_light;
+    uint8_t   pending;
+} ShadowCascades;
+
+typedef struct {
+    Renderer      *renderer;        // Depth-only, size x size
+    int            size;
+    ShadowCube     cubes[SHADOW_MAX_CUBES];
+    ShadowCascades sun;
+    float          sun_distance;    // Cascades cover view depths up to this
+    int            budget;          // Maps rendered per frame, cascades first
+    int            next_cube;       // Round-robin start for cube faces
+} ShadowSystem;
+
+ShadowSystem* shadow_system_create(int size, int threads);
+void          shadow_system_destroy(ShadowSystem *s);
+// Hands a cube to `light` with every face cleared to lit and pending; -1 frees it
+void          shadow_cube_assign(ShadowCube *c, int light);
+
+// View and projection of one cube face, 90 degrees wide out to `far`
+mat4  shadow_cube_face_matrix(vec3 position, int face, float far);
+// Fits cascade `i` around its slice of the camera frustum; casters between the
+// slice and the light are kept as long as they lie inside scene_min..scene_max.
+// Every bound is snapped to whole texels, so the matrix only changes with them.
+mat4  shadow_cascade_matrix(ShadowCascades *c, int i, const ShadowSystem *s, const Camera *cam, float aspect,
+                            vec3 scene_min, vec3 scene_max);
+
+// Renders into the shadow renderer between these two; end copies the depth into `m`
+void  shadow_map_begin(ShadowSystem *s, ShadowMap *m, mat4 view_proj, float texel_world);
+void  shadow_map_end(ShadowSystem *s, ShadowMap *m);
+
+// Fraction of a 3x3 PCF footprint that sees the light, 1 when unshadowed.
+// The lookup is pushed along the unit `normal` by a texel or so against acne.
+float shadow_cube_visibility(const ShadowCube *c, vec3 pos, vec3 normal);
+float shadow_cascades_visibility(const ShadowCascades *c, vec3 pos, vec3 normal);
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef CORE_SIMD_H
+#define CORE_SIMD_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+// Portable fixed-width vectors built on GCC/Clang vector extensions. The
+// compiler lowers them to SSE/AVX on x86 and NEON on ARM (an 8-wide op becomes
+// two 4-wide ones there), so kernels are written once for every target.
+
+typedef float    f32x4 __attribute__((vector_size(16)));
+typedef float    f32x8 __attribute__((vector_size(32)));
+typedef int32_t  i32x4 __attribute__((vector_size(16)));
+typedef int32_t  i32x8 __attribute__((vector_size(32))); // Lane masks are 0 / -1
+typedef uint32_t u32x4 __attribute__((vector_size(16)));
+typedef uint32_t u32x8 __attribute__((vector_size(32)));
+
+#define SIMD_WIDTH 8
+
+/* --- Load / Store (unaligned) --- */
+static inline f32x8 f32x8_load(const float *p) { f32x8 v; memcpy(&v, p, sizeof(v)); return v; }
+static inline void  f32x8_store(float *p, f32x8 v) { memcpy(p, &v, sizeof(v)); }
+static inline f32x4 f32x4_load(const float *p) { f32x4 v; memcpy(&v, p, sizeof(v)); return v; }
+static inline void  f32x4_store(float *p, f32x4 v) { memcpy(p, &v, sizeof(v)); }
+static inline u32x8 u32x8_load(const uint32_t *p) { u32x8 v; memcpy(&v, p, sizeof(v)); return v; }
+static inline void  u32x8_store(uint32_t *p, u32x8 v) { memcpy(p, &v, sizeof(v)); }
+
+static inline f32x8 f32x8_splat(float s) { return (f32x8){ s, s, s, s, s, s, s, s }; }
+static inline f32x4 f32x4_splat(float s) { return (f32x4){ s, s, s, s }; }
+static inline i32x8 i32x8_splat(int32_t s) { return (i32x8){ s, s, s, s, s, s, s, s }; }
+
+/* --- Arithmetic --- */
+// Lane-wise mask ? a : b (C has no vector ternary)
+static inline f32x8 f32x8_select(i32x8 mask, f32x8 a, f32x8 b) {
+    return (f32x8)(((i32x8)a & mask) | ((i32x8)b & ~mask));
+}
+static inline f32x4 f32x4_select(i32x4 mask, f32x4 a, f32x4 b) {
+    return (f32x4)(((i32x4)a & mask) | ((i32x4)b & ~mask));
+}
+static inline f32x8 f32x8_min(f32x8 a, f32x8 b) { return f32x8_select(a < b, a, b); }
+static inline f32x8 f32x8_max(f32x8 a, f32x8 b) { return f32x8_select(a > b, a, b); }
+// Per-lane loops the vectoriser turns into sqrtps / rsqrtps
+static inline f32x8 f32x8_sqrt(f32x8 v) {
+    for (int i = 0; i < 8; i++) v[i] = sqrtf(v[i]);
+    return v;
+}
+static inline f32x8 f32x8_rsqrt(f32x8 v) {
+    for (int i = 0; i < 8; i++) v[i] = 1.0f / sqrtf(v[i]);
+    return v;
+}
+// Sum of all lanes, pairwise so the order is fixed
+static inline float f32x8_hsum(f32x8 v) {
+    f32x4 h = (f32x4){ v[0], v[1], v[2], v[3] } + (f32x4){ v[4], v[5], v[6], v[7] };
+    return (h[0] + h[2]) + (h[1] + h[3]);
+}
+
+/* --- Colour --- */
+// RGBA8888 (R in the high byte, as in the framebuffer) to one float per channel, 0..255
+static inline f32x4 f32x4_from_rgba8(uint32_t c) {
+    u32x4 v = ((u32x4){ c, c, c, c } >> (u32x4){ 24, 16, 8, 0 }) & 0xFF;
+    return __builtin_convertvector((i32x4)v, f32x4);
+}
+
+// Channels in 0..1 to RGBA8888 with opaque alpha, clamped and truncated like vec3_to_color
+static inline u32x8 f32x8_to_rgba8(f32x8 r, f32x8 g, f32x8 b) {
+    const f32x8 zero = f32x8_splat(0.0f), one = f32x8_splat(1.0f);
+    u32x8 ri = (u32x8)__builtin_convertvector(f32x8_min(f32x8_max(r, zero), one) * 255.0f, i32x8);
+    u32x8 gi = (u32x8)__builtin_convertvector(f32x8_min(f32x8_max(g, zero), one) * 255.0f, i32x8);
+    u32x8 bi = (u32x8)__builtin_convertvector(f32x8_min(f32x8_max(b, zero), one) * 255.0f, i32x8);
+    return (ri << 24) | (gi << 16) | (bi << 8) | 0xFFu;
+}
+
+// Inverse of f32x8_to_rgba8: channels in 0..1 at the middle of each 8-bit step,
+// so a channel left unchanged packs back to the same byte
+static inline void f32x8_from_rgba8(u32x8 c, f32x8 *r, f32x8 *g, f32x8 *b) {
+    const float scale = 1.0f / 255.0f;
+    *r = (__builtin_convertvector((i32x8)(c >> 24), f32x8) + 0.5f) * scale;
+    *g = (__builtin_convertvector((i32x8)((c >> 16) & 0xFFu), f32x8) + 0.5f) * scale;
+    *b = (__builtin_convertvector((i32x8)((c >> 8) & 0xFFu), f32x8) + 0.5f) * scale;
+}
+
+// Packed float colour as DXGI R11G11B10_FLOAT: R in bits 0-10, G in 11-21, B in
+// 22-31. Unsigned, 5-bit exponents like half floats with 6/6/5 mantissa bits;
+// values below 2^-14 flush to zero and values above the maximum saturate.
+#define R11_MAX 65024.0f
+#define B10_MAX 64512.0f
+
+// Rebiases the float's exponent from 127 to 15 and rounds the mantissa
+static inline u32x8 f32x8_to_small_float(f32x8 v, int mantissa_bits, float max) {
+    u32x8 u = (u32x8)f32x8_min(f32x8_max(v, f32x8_splat(0.0f)), f32x8_splat(max));
+    u32x8 s = (u - (112u << 23) + (1u << (22 - mantissa_bits))) >> (23 - mantissa_bits);
+    return s & (u32x8)(u >= (113u << 23));
+}
+static inline f32x8 f32x8_from_small_float(u32x8 s, int mantissa_bits) {
+    u32x8 u = (s << (23 - mantissa_bits)) + (112u << 23);
+    return f32x8_select(s != 0, (f32x8)u, f32x8_splat(0.0f));
+}
+
+static inline u32x8 f32x8_to_r11g11b10(f32x8 r, f32x8 g, f32x8 b) {
+    return f32x8_to_small_float(r, 6, R11_MAX) | f32x8_to_small_float(g, 6, R11_MAX) << 11 |
+           f32x8_to_small_float(b, 5, B10_MAX) << 22;
+}
+static inline void f32x8_from_r11g11b10(u32x8 c, f32x8 *r, f32x8 *g, f32x8 *b) {
+    *r = f32x8_from_small_float(c & 0x7FFu, 6);
+    *g = f32x8_from_small_float((c >> 11) & 0x7FFu, 6);
+    *b = f32x8_from_small_float(c >> 22, 5);
+}
+
+/* --- Masks --- */
+static inline int i32x8_any(i32x8 m) {
+    return (m[0] | m[1] | m[2] | m[3] | m[4] | m[5] | m[6] | m[7]) != 0;
+}
+// Lane i of a 0 / -1 mask becomes bit i
+static inline uint32_t i32x4_bits(i32x4 m) {
+    m &= (i32x4){ 1, 2, 4, 8 };
+    return (uint32_t)(m[0] | m[1] | m[2] | m[3]);
+}
+static inline uint32_t i32x8_bits(i32x8 m) {
+    m &= (i32x8){ 1, 2, 4, 8, 16, 32, 64, 128 };
+    return (uint32_t)(m[0] | m[1] | m[2] | m[3] | m[4] | m[5] | m[6] | m[7]);
+}
+// Inverse of i32x4_bits
+static inline i32x4 i32x4_from_bits(uint32_t bits) {
+    return ((i32x4){ (int32_t)bits, (int32_t)bits, (int32_t)bits, (int32_t)bits } & (i32x4){ 1, 2, 4, 8 }) != 0;
+}
+
+#endif
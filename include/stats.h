@@ -0,0 +1,68 @@
+#ifndef RENDERER_STATS_H
+#define RENDERER_STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+// Build with -DRENDERER_STATS (make STATS=1) to enable the counters.
+// Without it every STATS_* macro expands to nothing.
+
+#define STATS_MAX_SHADERS 16
+
+typedef enum {
+    STAT_TIME_CLEAR,
+    STAT_TIME_VERTEX,
+    STAT_TIME_ASSEMBLE,
+    STAT_TIME_BIN,
+    STAT_TIME_RASTER,
+    STAT_TIME_POST,     // Halo post-processing stage; tile passes count as raster
+    STAT_TIME_WAIT,     // Main thread blocked in wait_for_workers
+    STAT_TIME_COUNT
+} StatTimer;
+
+// One block per thread, cache-line aligned so workers never share a line.
+typedef struct {
+    _Alignas(64) uint64_t vertices_shaded;
+    uint64_t meshlets_culled_frustum;
+    uint64_t meshlets_culled_backface;
+    uint64_t triangles_assembled;
+    uint64_t triangles_culled_near;
+    uint64_t triangles_culled_backface;
+    uint64_t triangles_culled_zero_area;
+    uint64_t triangles_culled_offscreen;
+    uint64_t bins_written;
+    uint64_t pixels_tested;
+    uint64_t pixels_depth_rejected;
+    uint64_t pixels_shaded;
+    uint64_t quads_shaded;          // Quads appended to fragment batches
+    uint64_t quad_helper_lanes;     // Lanes of those quads that were not written
+    uint64_t batches_shaded;        // Fragment batch flushes (one shader call each)
+    uint64_t oit_fragments;         // Transparent fragments appended to tile lists
+    uint64_t oit_fragments_dropped; // Behind OIT_MAX_LAYERS nearer ones at resolve
+    uint64_t temporal_reused;       // Opaque pixels that took last frame's colour
+    uint64_t temporal_shaded;       // Opaque pixels shaded while temporal reuse was on
+    uint64_t fs_invocations[STATS_MAX_SHADERS];
+    double   stage_ms[STAT_TIME_COUNT];
+} RenderStats;
+
+static inline double stats_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+#ifdef RENDERER_STATS
+    #define STATS_ONLY(...) __VA_ARGS__
+    #define STATS_ADD(r, thread, field, n) ((r)->thread_stats[(thread)].field += (uint64_t)(n))
+    #define STATS_TIMER_BEGIN(name) double name = stats_now_ms()
+    #define STATS_TIMER_END(r, thread, timer, name) \
+        ((r)->thread_stats[(thread)].stage_ms[(timer)] += stats_now_ms() - (name))
+#else
+    #define STATS_ONLY(...)
+    #define STATS_ADD(r, thread, field, n) ((void)0)
+    #define STATS_TIMER_BEGIN(name) ((void)0)
+    #define STATS_TIMER_END(r, thread, timer, name) ((void)0)
+#endif
+
+#endif
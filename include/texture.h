@@ -0,0 +1,45 @@
+#ifndef TEXTURE_H
+#define TEXTURE_H
+
+#include <stdint.h>
+#include "maths.h"
+#include "simd.h"
+
+// Texels are RGBA8888 like the framebuffer, stored in 4x4 tiles: one tile is a
+// 64-byte cache line, so a bilinear footprint touches one or two lines instead
+// of two rows that may be a full texture width apart.
+#define TEXTURE_TILE_SHIFT 2
+#define TEXTURE_TILE       (1 << TEXTURE_TILE_SHIFT)
+#define TEXTURE_MAX_LEVELS 16
+
+typedef struct {
+    uint32_t *texels;           // Tiles row-major, texels row-major inside a tile
+    int width, height;
+    int tiles_x;
+} TextureLevel;
+
+typedef struct {
+    TextureLevel levels[TEXTURE_MAX_LEVELS]; // levels[0] is full size, each next one is half
+    int level_count;
+} Texture;
+
+// `pixels` are row-major, top row first; the mip chain is built down to 1x1
+Texture* texture_create(int width, int height, const uint32_t *pixels);
+// Binary PPM (P6) or uncompressed 24/32-bit TGA
+Texture* texture_load(const char *path);
+void     texture_destroy(Texture *tex);
+
+// Mip level from the screen-space derivatives of (u, v), in UV units per pixel
+float texture_lod(const Texture *tex, float du_dx, float dv_dx, float du_dy, float dv_dy);
+
+// Repeat addressing; v = 0 is the bottom row as in OBJ texture coordinates.
+// Channels come back as (r, g, b, a) in 0..1.
+f32x4 texture_sample_bilinear(const Texture *tex, int level, float u, float v);
+f32x4 texture_sample_trilinear(const Texture *tex, float u, float v, float lod);
+
+static inline uint32_t texture_fetch(const TextureLevel *l, int x, int y) {
+    int tile = (y >> TEXTURE_TILE_SHIFT) * l->tiles_x + (x >> TEXTURE_TILE_SHIFT);
+    return l->texels[(tile << (2 * TEXTURE_TILE_SHIFT)) | ((y & (TEXTURE_TILE - 1)) << TEXTURE_TILE_SHIFT) | (x & (TEXTURE_TILE - 1))];
+}
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef RENDERER_TRACE_H
+#define RENDERER_TRACE_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <time.h>
+
+// Build with -DRENDERER_TRACE (make TRACE=1) to record a worker timeline.
+// Each thread owns one ring buffer and is its only writer, so recording is
+// a plain store plus a release increment of the head. Old events are
+// overwritten once the ring wraps.
+
+#define TRACE_RING_SIZE (1 << 16) // Events per thread, must be a power of two
+
+typedef enum {
+    TRACE_CLEAR,
+    TRACE_VERTEX,       // arg: draw call index
+    TRACE_ASSEMBLE,     // arg: draw call index
+    TRACE_BIN,
+    TRACE_TILE,         // arg: tile index
+    TRACE_POST,         // arg: tile index, one event per halo pass
+    TRACE_WAIT,         // Main thread blocked in wait_for_workers
+    TRACE_FRAME,        // Instant marker emitted by renderer_reset
+    TRACE_EVENT_COUNT
+} TraceEventType;
+
+typedef struct {
+    double   begin_us, end_us;
+    int32_t  arg;
+    uint16_t type;
+} TraceEvent;
+
+typedef struct {
+    _Alignas(64) atomic_uint_fast64_t head;
+    TraceEvent *events;
+} TraceRing;
+
+static inline double trace_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+static inline void trace_ring_push(TraceRing *ring, TraceEventType type, int32_t arg, double begin_us, double end_us) {
+    uint_fast64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    TraceEvent *e = &ring->events[head & (TRACE_RING_SIZE - 1)];
+    e->begin_us = begin_us; e->end_us = end_us;
+    e->arg = arg; e->type = (uint16_t)type;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+#ifdef RENDERER_TRACE
+    #define TRACE_BEGIN(name) double name = trace_now_us()
+    #define TRACE_END(r, thread, type, arg, name) \
+        do { if ((r)->trace_enabled) trace_ring_push(&(r)->trace_rings[(thread)], (type), (int32_t)(arg), (name), trace_now_us()); } while (0)
+    #define TRACE_INSTANT(r, thread, type, arg) \
+        do { if ((r)->trace_enabled) { double t_ = trace_now_us(); trace_ring_push(&(r)->trace_rings[(thread)], (type), (int32_t)(arg), t_, t_); } } while (0)
+#else
+    #define TRACE_BEGIN(name) ((void)0)
+    #define TRACE_END(r, thread, type, arg, name) ((void)0)
+    #define TRACE_INSTANT(r, thread, type, arg) ((void)0)
+#endif
+
+#endif
@@ -67,8 +67,8 @@ bool init_app(App *app) {
         Mesh *m = cube;
         if (!m) continue;
 
-        Entity* e = scene_add_entity(app->scene, m, pos, (vec3){0,0,0}, 1.25f, color);
-        e->fs = fs_multi_light_smooth;
+        EntityHandle e = scene_add_entity(app->scene, m, pos, (vec3){0,0,0}, 1.25f, color);
+        scene_entity_set_shaders(app->scene, e, vs_default, fs_multi_light_smooth);
     }
 
     // Add Lights
@@ -88,8 +88,9 @@ void update_game_logic(App *app, float dt) {
     float spacing = 6.0f;
 
     // 1. Update Entities: Ripple Waves and Topographical Colors
-    for(size_t i = 0; i < app->scene->entity_count; i++) {
-        Entity *e = &app->scene->entities[i];
+    Scene *scene = app->scene;
+    for(size_t i = 0; i < scene->entities.count; i++) {
+        EntityHandle e = (EntityHandle)i;
         int x_idx = i % grid_size; 
         int z_idx = i / grid_size;
         
@@ -104,16 +105,22 @@ void update_game_logic(App *app, float dt) {
         float wave1 = sinf(t * 3.0f - dist * 0.3f);
         float wave2 = sinf(t * 1.5f + (cx + cz) * 0.1f);
         
-        e->position.y = (wave1 + wave2) * 3.0f; // Height varies from -6 to +6
-        e->rotation.y = t * 1.2f + dist * 0.1f;
+        vec3 pos = scene_entity_position(scene, e);
+        vec3 rot = scene_entity_rotation(scene, e);
+        pos.y = (wave1 + wave2) * 3.0f; // Height varies from -6 to +6
+        rot.y = t * 1.2f + dist * 0.1f;
+        scene_entity_set_position(scene, e, pos);
+        scene_entity_set_rotation(scene, e, rot);
 
         // Topographical colors based on height
-        float norm_h = (e->position.y + 6.0f) / 12.0f; // Normalize height to 0.0 - 1.0
+        float norm_h = (pos.y + 6.0f) / 12.0f; // Normalize height to 0.0 - 1.0
         
         // Shift colors from Deep Purple (low) -> Cyan (mid) -> Hot Pink (high)
-        e->base_color.x = norm_h;                                   // Red increases with height
-        e->base_color.y = 0.2f + sinf(t * 2.0f + cx * 0.1f) * 0.3f; // Pulsing green
-        e->base_color.z = 1.0f - norm_h * 0.5f;                     // Blue decreases with height
+        scene_entity_set_color(scene, e, (vec3){
+            norm_h,                                   // Red increases with height
+            0.2f + sinf(t * 2.0f + cx * 0.1f) * 0.3f, // Pulsing green
+            1.0f - norm_h * 0.5f                      // Blue decreases with height
+        });
     }
 
     // 2. Update Lights: Swirling Vortex and Morphing Colors
@@ -181,7 +188,7 @@ int main(void) {
         frame_count++; fps_timer += dt;
         if (fps_timer >= TARGET_FPS_UPDATE) {
             char title[128];
-            sprintf(title, "ENGINE REFACTOR STRESS TEST | FPS: %.1f | Objects: %zu", frame_count / fps_timer, app.scene->entity_count);
+            sprintf(title, "ENGINE REFACTOR STRESS TEST | FPS: %.1f | Objects: %zu", frame_count / fps_timer, app.scene->entities.count);
             platform_set_title(app.platform, title);
             frame_count = 0; fps_timer = 0.0f;
         }
@@ -19,8 +19,8 @@ typedef struct {
     Scene    *scene;
     Uniforms  uniforms;
 
-    Entity   *dragon_entity;
-    Entity   *light_cubes[LIGHT_COUNT];
+    EntityHandle dragon_entity;
+    EntityHandle light_cubes[LIGHT_COUNT];
 
     float total_time;
     bool  is_running;
@@ -42,18 +42,18 @@ bool init_app(App *app) {
     app->uniforms.screen_width = (float)SCREEN_W; 
     app->uniforms.screen_height = (float)SCREEN_H;
 
-    Mesh* dragon = scene_load_mesh(app->scene, "/Users/aikoschurmann/code/c/soft-renderer/models/xyzrgb_dragon.obj");
-    if (dragon) mesh_center_origin(dragon);
     Mesh* cube = scene_load_mesh(app->scene, "/Users/aikoschurmann/code/c/soft-renderer/models/cube.obj");
     if (cube) mesh_center_origin(cube);
+    // The dragon streams in on the loader thread; the scene renders without it until then
+    Mesh* dragon = scene_load_mesh_async(app->scene, "/Users/aikoschurmann/code/c/soft-renderer/models/xyzrgb_dragon.obj", NULL, MESH_LOAD_CENTER_ORIGIN | MESH_LOAD_BUILD_LODS);
 
     app->dragon_entity = scene_add_entity(app->scene, dragon, (vec3){0,0,0}, (vec3){0,0,0}, 0.1f, (vec3){0.8f, 0.8f, 0.8f});
-    app->dragon_entity->fs = fs_multi_light_smooth; 
+    scene_entity_set_shaders(app->scene, app->dragon_entity, vs_default, fs_multi_light_smooth);
 
     for(int i = 0; i < LIGHT_COUNT; i++) {
         scene_add_light(app->scene, (vec3){0,0,0}, (vec3){1,1,1}, 50.0f);
         app->light_cubes[i] = scene_add_entity(app->scene, cube, (vec3){0,0,0}, (vec3){0,0,0}, 0.3f, (vec3){1,1,1});
-        app->light_cubes[i]->fs = fs_pure_color;
+        scene_entity_set_shaders(app->scene, app->light_cubes[i], vs_default, fs_pure_color);
     }
 
     app->is_running = true;
@@ -66,8 +66,7 @@ void update_game_logic(App *app, float dt) {
     float t = app->total_time;
 
     // Tumble the Dragon
-    app->dragon_entity->rotation.y = t * 0.6f;
-    app->dragon_entity->rotation.x = sinf(t * 0.4f) * 0.3f; 
+    scene_entity_set_rotation(app->scene, app->dragon_entity, (vec3){ sinf(t * 0.4f) * 0.3f, t * 0.6f, 0.0f });
 
     // Animate Lights
     app->scene->lights[0].position = (vec3){ cosf(t * 1.2f) * 14.0f, sinf(t * 2.4f) * 8.0f + 5.0f, sinf(t * 1.2f) * 14.0f };
@@ -81,8 +80,8 @@ void update_game_logic(App *app, float dt) {
 
     for(int i = 0; i < LIGHT_COUNT; i++) {
         app->scene->lights[i].intensity = 35.0f + sinf(t * 2.0f + i) * 10.0f;
-        app->light_cubes[i]->position = app->scene->lights[i].position;
-        app->light_cubes[i]->base_color = app->scene->lights[i].color;
+        scene_entity_set_position(app->scene, app->light_cubes[i], app->scene->lights[i].position);
+        scene_entity_set_color(app->scene, app->light_cubes[i], app->scene->lights[i].color);
     }
 }
 
@@ -0,0 +1,226 @@
+#include "bvh.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <float.h>
+
+// Refitting keeps the topology built for the old positions; once the summed
+// node area grows past this factor, moving items have scrambled it enough
+// that a fresh build is cheaper than traversing the bloated tree.
+#define BVH_REBUILD_RATIO 2.0f
+
+static void* bvh_realloc(void *ptr, size_t bytes) {
+    ptr = realloc(ptr, bytes ? bytes : 1);
+    if (!ptr) { fprintf(stderr, "Out of memory\n"); exit(1); }
+    return ptr;
+}
+
+static void bvh_reserve(Bvh *bvh, size_t count) {
+    if (count > bvh->capacity) {
+        bvh->capacity = count + count / 2;
+        bvh->items  = bvh_realloc(bvh->items, bvh->capacity * sizeof(uint32_t));
+        bvh->x      = bvh_realloc(bvh->x, bvh->capacity * sizeof(float));
+        bvh->y      = bvh_realloc(bvh->y, bvh->capacity * sizeof(float));
+        bvh->z      = bvh_realloc(bvh->z, bvh->capacity * sizeof(float));
+        bvh->radius = bvh_realloc(bvh->radius, bvh->capacity * sizeof(float));
+    }
+    // A binary tree over `count` leaves of at least one item
+    size_t max_nodes = count * 2 + 1;
+    if (max_nodes > bvh->node_capacity) {
+        bvh->node_capacity = max_nodes;
+        bvh->nodes = bvh_realloc(bvh->nodes, bvh->node_capacity * sizeof(BvhNode));
+    }
+}
+
+/* --- 1. BUILD --- */
+
+// Partial sort (Hoare quickselect): ids[nth] ends up with the key it would
+// have if sorted, smaller keys before it and larger ones after.
+static void bvh_select(uint32_t *ids, ptrdiff_t count, ptrdiff_t nth, const float *key) {
+    ptrdiff_t lo = 0, hi = count - 1;
+    while (lo < hi) {
+        float pivot = key[ids[lo + (hi - lo) / 2]];
+        ptrdiff_t i = lo, j = hi;
+        while (i <= j) {
+            while (key[ids[i]] < pivot) i++;
+            while (key[ids[j]] > pivot) j--;
+            if (i <= j) {
+                uint32_t t = ids[i]; ids[i] = ids[j]; ids[j] = t;
+                i++; j--;
+            }
+        }
+        if (nth <= j) hi = j;
+        else if (nth >= i) lo = i;
+        else return;
+    }
+}
+
+// Median split along the axis where the centres spread most
+static void bvh_build_node(Bvh *bvh, uint32_t node, uint32_t first, uint32_t count,
+                           const float *x, const float *y, const float *z) {
+    BvhNode *n = &bvh->nodes[node];
+    n->first = first;
+    n->count = count;
+    n->left = 0;
+    if (count <= BVH_LEAF_SIZE) return;
+
+    vec3 lo = {FLT_MAX, FLT_MAX, FLT_MAX}, hi = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (uint32_t k = first; k < first + count; k++) {
+        uint32_t id = bvh->items[k];
+        lo.x = MIN(lo.x, x[id]); hi.x = MAX(hi.x, x[id]);
+        lo.y = MIN(lo.y, y[id]); hi.y = MAX(hi.y, y[id]);
+        lo.z = MIN(lo.z, z[id]); hi.z = MAX(hi.z, z[id]);
+    }
+    vec3 ext = vec3_sub(hi, lo);
+    const float *key = (ext.x >= ext.y && ext.x >= ext.z) ? x : (ext.y >= ext.z) ? y : z;
+
+    uint32_t half = count / 2;
+    bvh_select(bvh->items + first, count, half, key);
+
+    uint32_t left = (uint32_t)bvh->node_count;
+    bvh->node_count += 2;
+    n->left = left;
+    bvh_build_node(bvh, left, first, half, x, y, z);
+    bvh_build_node(bvh, left + 1, first + half, count - half, x, y, z);
+}
+
+/* --- 2. REFIT --- */
+
+static void bvh_gather(Bvh *bvh, const float *x, const float *y, const float *z, const float *radius) {
+    for (size_t k = 0; k < bvh->count; k++) {
+        uint32_t id = bvh->items[k];
+        bvh->x[k] = x[id];
+        bvh->y[k] = y[id];
+        bvh->z[k] = z[id];
+        bvh->radius[k] = radius[id];
+    }
+}
+
+// Children always follow their parent, so one reverse sweep is bottom-up.
+// Returns the summed surface area of the non-empty nodes.
+static float bvh_refit_nodes(Bvh *bvh) {
+    float cost = 0.0f;
+    for (size_t i = bvh->node_count; i-- > 0;) {
+        BvhNode *n = &bvh->nodes[i];
+        vec3 lo = {FLT_MAX, FLT_MAX, FLT_MAX}, hi = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+        if (n->left) {
+            const BvhNode *a = &bvh->nodes[n->left], *b = &bvh->nodes[n->left + 1];
+            lo = (vec3){ MIN(a->min.x, b->min.x), MIN(a->min.y, b->min.y), MIN(a->min.z, b->min.z) };
+            hi = (vec3){ MAX(a->max.x, b->max.x), MAX(a->max.y, b->max.y), MAX(a->max.z, b->max.z) };
+        } else {
+            for (uint32_t k = n->first; k < n->first + n->count; k++) {
+                float r = bvh->radius[k];
+                if (r <= 0.0f) continue;
+                lo.x = MIN(lo.x, bvh->x[k] - r); hi.x = MAX(hi.x, bvh->x[k] + r);
+                lo.y = MIN(lo.y, bvh->y[k] - r); hi.y = MAX(hi.y, bvh->y[k] + r);
+                lo.z = MIN(lo.z, bvh->z[k] - r); hi.z = MAX(hi.z, bvh->z[k] + r);
+            }
+        }
+        n->min = lo;
+        n->max = hi;
+        if (lo.x <= hi.x) {
+            vec3 e = vec3_sub(hi, lo);
+            cost += e.x * e.y + e.y * e.z + e.z * e.x;
+        }
+    }
+    return cost;
+}
+
+void bvh_build(Bvh *bvh, const float *x, const float *y, const float *z, const float *radius, size_t count) {
+    bvh_reserve(bvh, count);
+    bvh->count = count;
+    bvh->node_count = 0;
+    bvh->built_cost = 0.0f;
+    if (count == 0) return;
+
+    for (size_t k = 0; k < count; k++) bvh->items[k] = (uint32_t)k;
+    bvh->node_count = 1;
+    bvh_build_node(bvh, 0, 0, (uint32_t)count, x, y, z);
+    bvh_gather(bvh, x, y, z, radius);
+    bvh->built_cost = bvh_refit_nodes(bvh);
+}
+
+void bvh_update(Bvh *bvh, const float *x, const float *y, const float *z, const float *radius, size_t count) {
+    if (count != bvh->count) {
+        bvh_build(bvh, x, y, z, radius, count);
+        return;
+    }
+    bvh_gather(bvh, x, y, z, radius);
+    if (bvh_refit_nodes(bvh) > bvh->built_cost * BVH_REBUILD_RATIO) {
+        bvh_build(bvh, x, y, z, radius, count);
+    }
+}
+
+void bvh_free(Bvh *bvh) {
+    free(bvh->nodes);
+    free(bvh->items);
+    free(bvh->x); free(bvh->y); free(bvh->z); free(bvh->radius);
+    *bvh = (Bvh){0};
+}
+
+/* --- 3. QUERIES --- */
+
+void bvh_query_frustum(const Bvh *bvh, const Frustum *f, uint8_t *out_result) {
+    if (bvh->node_count == 0) return;
+    uint32_t stack[BVH_MAX_DEPTH];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const BvhNode *n = &bvh->nodes[stack[--top]];
+        if (n->min.x > n->max.x) continue;
+
+        FrustumResult r = frustum_test_aabb(f, n->min, n->max);
+        if (r == FRUSTUM_OUTSIDE) continue;
+        if (r == FRUSTUM_INSIDE) {
+            // The whole subtree is visible: its items are one contiguous run
+            for (uint32_t k = n->first; k < n->first + n->count; k++) {
+                if (bvh->radius[k] > 0.0f) out_result[bvh->items[k]] = FRUSTUM_INSIDE;
+            }
+            continue;
+        }
+        if (n->left) {
+            stack[top++] = n->left + 1;
+            stack[top++] = n->left;
+            continue;
+        }
+
+        uint8_t leaf[BVH_LEAF_SIZE];
+        frustum_cull_spheres(f, bvh->x + n->first, bvh->y + n->first, bvh->z + n->first,
+                             bvh->radius + n->first, n->count, leaf);
+        for (uint32_t k = 0; k < n->count; k++) {
+            if (leaf[k] != FRUSTUM_OUTSIDE) out_result[bvh->items[n->first + k]] = leaf[k];
+        }
+    }
+}
+
+size_t bvh_query_sphere(const Bvh *bvh, vec3 center, float radius, uint32_t *out, size_t max_out) {
+    if (bvh->node_count == 0) return 0;
+    uint32_t stack[BVH_MAX_DEPTH];
+    int top = 0;
+    stack[top++] = 0;
+    size_t found = 0;
+
+    while (top > 0) {
+        const BvhNode *n = &bvh->nodes[stack[--top]];
+        if (n->min.x > n->max.x) continue;
+
+        // Distance from the query centre to the box
+        float dx = MAX(MAX(n->min.x - center.x, center.x - n->max.x), 0.0f);
+        float dy = MAX(MAX(n->min.y - center.y, center.y - n->max.y), 0.0f);
+        float dz = MAX(MAX(n->min.z - center.z, center.z - n->max.z), 0.0f);
+        if (dx * dx + dy * dy + dz * dz > radius * radius) continue;
+
+        if (n->left) {
+            stack[top++] = n->left + 1;
+            stack[top++] = n->left;
+            continue;
+        }
+        for (uint32_t k = n->first; k < n->first + n->count; k++) {
+            float r = bvh->radius[k];
+            if (r <= 0.0f) continue;
+            vec3 d = { bvh->x[k] - center.x, bvh->y[k] - center.y, bvh->z[k] - center.z };
+            if (vec3_dot(d, d) < (r + radius) * (r + radius) && found < max_out) out[found++] = bvh->items[k];
+        }
+    }
+    return found;
+}
@@ -0,0 +1,99 @@
+#include "frustum.h"
+#include "simd.h"
+
+// Gribb & Hartmann: each plane is the sum or difference of the matrix's last
+// row with one of the first three (clip space x, y, z in [-w, w]).
+void frustum_from_matrix(Frustum *f, mat4 m) {
+    vec4 row[4];
+    for (int i = 0; i < 4; i++) row[i] = (vec4){ m.m[0][i], m.m[1][i], m.m[2][i], m.m[3][i] };
+
+    for (int i = 0; i < 3; i++) {
+        f->planes[i * 2]     = (vec4){ row[3].x + row[i].x, row[3].y + row[i].y, row[3].z + row[i].z, row[3].w + row[i].w };
+        f->planes[i * 2 + 1] = (vec4){ row[3].x - row[i].x, row[3].y - row[i].y, row[3].z - row[i].z, row[3].w - row[i].w };
+    }
+    for (int i = 0; i < 6; i++) {
+        vec4 *p = &f->planes[i];
+        float len = sqrtf(p->x * p->x + p->y * p->y + p->z * p->z);
+        if (len > 0.0f) {
+            float inv = 1.0f / len;
+            *p = (vec4){ p->x * inv, p->y * inv, p->z * inv, p->w * inv };
+        }
+    }
+}
+
+FrustumResult frustum_test_sphere(const Frustum *f, vec3 c, float radius) {
+    FrustumResult result = FRUSTUM_INSIDE;
+    for (int i = 0; i < 6; i++) {
+        const vec4 *p = &f->planes[i];
+        float d = p->x * c.x + p->y * c.y + p->z * c.z + p->w;
+        if (d < -radius) return FRUSTUM_OUTSIDE;
+        if (d < radius) result = FRUSTUM_INTERSECT;
+    }
+    return result;
+}
+
+FrustumResult frustum_test_obb(const Frustum *f, const mat4 *model, BoundingBox local) {
+    vec3 half = vec3_mul(vec3_sub(local.max, local.min), 0.5f);
+    vec4 c = mat4_mul_vec4(*model, (vec4){ local.center.x, local.center.y, local.center.z, 1.0f });
+
+    // World-space half axes of the box
+    vec3 ax[3];
+    for (int i = 0; i < 3; i++) {
+        float h = (i == 0) ? half.x : (i == 1) ? half.y : half.z;
+        ax[i] = (vec3){ model->m[i][0] * h, model->m[i][1] * h, model->m[i][2] * h };
+    }
+
+    FrustumResult result = FRUSTUM_INSIDE;
+    for (int i = 0; i < 6; i++) {
+        const vec4 *p = &f->planes[i];
+        vec3 n = { p->x, p->y, p->z };
+        float extent = fabsf(vec3_dot(n, ax[0])) + fabsf(vec3_dot(n, ax[1])) + fabsf(vec3_dot(n, ax[2]));
+        float d = n.x * c.x + n.y * c.y + n.z * c.z + p->w;
+        if (d < -extent) return FRUSTUM_OUTSIDE;
+        if (d < extent) result = FRUSTUM_INTERSECT;
+    }
+    return result;
+}
+
+// Per plane, the corner furthest along the normal decides outside and the
+// nearest one decides inside
+FrustumResult frustum_test_aabb(const Frustum *f, vec3 min, vec3 max) {
+    FrustumResult result = FRUSTUM_INSIDE;
+    for (int i = 0; i < 6; i++) {
+        const vec4 *p = &f->planes[i];
+        vec3 pv = { p->x >= 0.0f ? max.x : min.x, p->y >= 0.0f ? max.y : min.y, p->z >= 0.0f ? max.z : min.z };
+        vec3 nv = { p->x >= 0.0f ? min.x : max.x, p->y >= 0.0f ? min.y : max.y, p->z >= 0.0f ? min.z : max.z };
+        if (p->x * pv.x + p->y * pv.y + p->z * pv.z + p->w < 0.0f) return FRUSTUM_OUTSIDE;
+        if (p->x * nv.x + p->y * nv.y + p->z * nv.z + p->w < 0.0f) result = FRUSTUM_INTERSECT;
+    }
+    return result;
+}
+
+void frustum_cull_spheres(const Frustum *f, const float *x, const float *y, const float *z,
+                          const float *radius, size_t count, uint8_t *out) {
+    f32x8 px[6], py[6], pz[6], pw[6];
+    for (int i = 0; i < 6; i++) {
+        px[i] = f32x8_splat(f->planes[i].x); py[i] = f32x8_splat(f->planes[i].y);
+        pz[i] = f32x8_splat(f->planes[i].z); pw[i] = f32x8_splat(f->planes[i].w);
+    }
+
+    size_t i = 0;
+    for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) {
+        f32x8 cx = f32x8_load(x + i), cy = f32x8_load(y + i), cz = f32x8_load(z + i);
+        f32x8 r = f32x8_load(radius + i);
+        i32x8 outside = r <= f32x8_splat(0.0f);
+        i32x8 inside = i32x8_splat(-1);
+        for (int p = 0; p < 6; p++) {
+            f32x8 d = px[p] * cx + py[p] * cy + pz[p] * cz + pw[p];
+            outside |= d < -r;
+            inside &= d >= r;
+        }
+        for (int l = 0; l < SIMD_WIDTH; l++) {
+            out[i + l] = outside[l] ? FRUSTUM_OUTSIDE : inside[l] ? FRUSTUM_INSIDE : FRUSTUM_INTERSECT;
+        }
+    }
+    for (; i < count; i++) {
+        out[i] = radius[i] <= 0.0f ? FRUSTUM_OUTSIDE
+               : (uint8_t)frustum_test_sphere(f, (vec3){ x[i], y[i], z[i] }, radius[i]);
+    }
+}
@@ -9,28 +9,29 @@
 #include "renderer.h"
 #include "scene.h" 
 #include "camera.h"
+#include "postfx.h"
 
 #define SCREEN_W 1000
 #define SCREEN_H 768
 #define INSTANCE_COUNT (1024 * 16) 
 #define LIGHT_COUNT 256
+#define SHADOW_LIGHTS 4
+#define SHADOW_MAP_SIZE 1024
 #define TARGET_FPS_UPDATE 5.0f
 
 typedef struct {
     Platform *platform;
     Renderer *renderer;
     Scene    *scene;
+    ShadowSystem *shadows;
     Uniforms  uniforms;
+    PostGrade grade;
+    PostBloom bloom;
 
     float total_time;
     bool  is_running;
 } App;
 
-// Add this helper function to modify the final color buffer
-void apply_post_processing(uint32_t* buffer, int width, int height, float time) {
-    // Post-processing logic goes here
-}
-
 bool init_app(App *app) {
     memset(app, 0, sizeof(App));
     
@@ -39,6 +40,14 @@ bool init_app(App *app) {
 
     app->renderer = renderer_create(SCREEN_W, SCREEN_H, 10, 100, 100);
     renderer_set_cull_mode(app->renderer, CULL_BACK_CCW); 
+    renderer_set_msaa(app->renderer, 1);
+    renderer_set_hdr(app->renderer, 1);   // 256 lights saturate RGBA8888 shading
+    renderer_set_tonemap(app->renderer, 1.5f, 4.0f, 1.0f);
+    // No temporal reuse: every entity and light animates, so no draw key survives a frame
+    app->grade = (PostGrade){ .exposure = 1.0f, .saturation = 1.1f, .contrast = 1.05f, .vignette = 0.35f };
+    app->bloom = (PostBloom){ .threshold = 0.8f, .intensity = 0.6f };
+    renderer_add_post_pass(app->renderer, post_grade, POST_TILE, &app->grade);
+    renderer_add_post_pass(app->renderer, post_bloom, POST_HALO, &app->bloom);
 
     app->scene = scene_create(INSTANCE_COUNT);
     app->scene->camera = (Camera){ .position = {0, 30, -50}, .up = {0, 1, 0}, .yaw = 90.0f, .pitch = -25.0f, .fov = 60.0f, .znear = 0.5f, .zfar = 1000.0f };
@@ -48,6 +57,12 @@ bool init_app(App *app) {
     // Load Meshes entirely inside the Scene
     Mesh* cube   = scene_load_mesh(app->scene, "/Users/aikoschurmann/code/c/soft-renderer/models/cube.obj");
     if (cube) mesh_center_origin(cube);
+    // Dense enough to simplify; distant copies draw coarser levels
+    Mesh* monkey = scene_load_mesh(app->scene, "/Users/aikoschurmann/code/c/soft-renderer/models/suzanne.obj");
+    if (monkey) {
+        mesh_center_origin(monkey);
+        scene_build_lods(app->scene, monkey);
+    }
 
     // Add Objects
     int grid_size = (int)sqrt(INSTANCE_COUNT);
@@ -58,11 +73,13 @@ bool init_app(App *app) {
         vec3 pos = { (x_idx - grid_size/2.0f) * spacing, 0.0f, (z_idx - grid_size/2.0f) * spacing };
         vec3 color = { 0.3f + (x_idx/(float)grid_size)*0.7f, 0.4f, 0.3f + (z_idx/(float)grid_size)*0.7f };
         
-        Mesh *m = cube;
+        Mesh *m = (i % 4 == 0 && monkey) ? monkey : cube;
         if (!m) continue;
 
-        Entity* e = scene_add_entity(app->scene, m, pos, (vec3){0,0,0}, 1.25f, color);
-        e->fs = fs_multi_light_smooth;
+        EntityHandle e = scene_add_entity(app->scene, m, pos, (vec3){0,0,0}, 1.25f, color);
+        scene_entity_set_shaders(app->scene, e, vs_default, fs_multi_light_smooth);
+        // One glass cube, so the order-independent transparency pass runs every frame
+        if (i == 1) scene_entity_set_opacity(app->scene, e, 0.5f);
     }
 
     // Add Lights
@@ -70,6 +87,12 @@ bool init_app(App *app) {
         scene_add_light(app->scene, (vec3){0,0,0}, 
             (vec3){ (float)rand()/RAND_MAX, (float)rand()/RAND_MAX, (float)rand()/RAND_MAX }, 50.0f);
     }
+    for (int i = 0; i < SHADOW_LIGHTS && i < LIGHT_COUNT; i++) app->scene->lights[i].casts_shadows = 1;
+
+    // Low sun with cascaded shadows
+    app->shadows = shadow_system_create(SHADOW_MAP_SIZE, 10);
+    app->scene->shadows = app->shadows;
+    app->scene->sun = (DirectionalLight){ vec3_norm((vec3){ 0.4f, -1.0f, 0.6f }), { 1.0f, 0.95f, 0.8f }, 0.4f };
 
     app->is_running = true;
     return true;
@@ -161,8 +184,9 @@ void update_game_logic(App *app, float dt) {
     // ---------------------------------------------------------
     // ENTITY POSITIONS & COLOR WAVES
     // ---------------------------------------------------------
-    for(size_t i = 0; i < app->scene->entity_count; i++) {
-        Entity *e = &app->scene->entities[i];
+    Scene *scene = app->scene;
+    for(size_t i = 0; i < scene->entities.count; i++) {
+        EntityHandle e = (EntityHandle)i;
         int x_idx = i % grid_size; 
         int z_idx = i / grid_size;
         
@@ -178,14 +202,16 @@ void update_game_logic(App *app, float dt) {
         float warped_rot_time = local_time * p.rot_timer_speed + sinf(local_time * p.irregular_speed) * p.irregular_amount;
         float rot_stage = get_smooth_stage(warped_rot_time, p.burst_threshold);
 
-        e->position.y = sinf(local_time * p.bob_speed + dist_from_center * p.wave_spread) * p.bob_height;
-        e->rotation.y = local_time * 1.2f + i; 
+        vec3 pos = scene_entity_position(scene, e);
+        vec3 rot = scene_entity_rotation(scene, e);
+        pos.y = sinf(local_time * p.bob_speed + dist_from_center * p.wave_spread) * p.bob_height;
+        rot.y = local_time * 1.2f + i; 
+        scene_entity_set_position(scene, e, pos);
+        scene_entity_set_rotation(scene, e, rot);
 
         // Colors ripple outward
         float t = local_time * p.color_base_speed + dist_from_center * p.color_spread + (rot_stage * p.color_burst_shift);
-        e->base_color.x = sinf(t) * 0.5f + 0.5f;
-        e->base_color.y = sinf(t + 2.0f) * 0.5f + 0.5f;
-        e->base_color.z = sinf(t + 4.0f) * 0.5f + 0.5f;
+        scene_entity_set_color(scene, e, (vec3){ sinf(t) * 0.5f + 0.5f, sinf(t + 2.0f) * 0.5f + 0.5f, sinf(t + 4.0f) * 0.5f + 0.5f });
     }
 
     // ---------------------------------------------------------
@@ -298,13 +324,25 @@ int main(void) {
         frame_count++; fps_timer += dt;
         if (fps_timer >= TARGET_FPS_UPDATE) {
             char title[128];
-            sprintf(title, "ENGINE REFACTOR STRESS TEST | FPS: %.1f | Objects: %zu", frame_count / fps_timer, app.scene->entity_count);
+            sprintf(title, "ENGINE REFACTOR STRESS TEST | FPS: %.1f | Objects: %zu", frame_count / fps_timer, app.scene->entities.count);
             platform_set_title(app.platform, title);
             frame_count = 0; fps_timer = 0.0f;
+
+#ifdef RENDERER_STATS
+            // A shader drawn for the first time adds a column
+            static int stats_header_shaders = -1;
+            renderer_stats_dump_csv(app.renderer, stdout, app.renderer->stats_shader_count != stats_header_shaders);
+            stats_header_shaders = app.renderer->stats_shader_count;
+#endif
         }
     }
     
+#ifdef RENDERER_TRACE
+    renderer_trace_dump(app.renderer, "trace.json");
+#endif
+
     scene_destroy(app.scene);
+    shadow_system_destroy(app.shadows);
     renderer_destroy(app.renderer);
     platform_destroy(app.platform);
     
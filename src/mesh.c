@@ -4,33 +4,7 @@
 #include <string.h>
 #include <math.h>
 #include <float.h>
-
-// Generic dynamic array growth macro
-#define ARRAY_PUSH(type, ptr, count, cap, item) \
-    do { \
-        if ((count) >= (cap)) { \
-            (cap) = (cap) == 0 ? 128 : (cap) * 2; \
-            void *temp = realloc((ptr), sizeof(type) * (cap)); \
-            if (!temp) { fprintf(stderr, "Out of memory\n"); exit(1); } \
-            (ptr) = (type*)temp; \
-        } \
-        (ptr)[(count)++] = (item); \
-    } while (0)
-
-#define HASH_TABLE_SIZE 65536 
-
-// --- DEDUPLICATION STRUCTURES ---
-typedef struct {
-    size_t p_idx; // Position Index
-    size_t t_idx; // UV Index
-    size_t n_idx; // Normal Index
-} VertexKey;
-
-typedef struct HashNode {
-    VertexKey key;
-    uint32_t  final_index;
-    struct HashNode *next;
-} HashNode;
+#include <sys/mman.h>
 
 static void v3_normalize_ptr(float *x, float *y, float *z) {
     float len = sqrtf((*x)*(*x) + (*y)*(*y) + (*z)*(*z));
@@ -40,16 +14,8 @@ static void v3_normalize_ptr(float *x, float *y, float *z) {
     }
 }
 
-static uint32_t hash_key(VertexKey k) {
-    uint32_t h = 2166136261u;
-    h = (h ^ k.p_idx) * 16777619u;
-    h = (h ^ k.t_idx) * 16777619u;
-    h = (h ^ k.n_idx) * 16777619u;
-    return h % HASH_TABLE_SIZE;
-}
-
 // --- NORMAL CALCULATION ---
-static void calculate_normals(Mesh *mesh) {
+void mesh_calculate_normals(Mesh *mesh) {
     // 1. Reset existing normals (just in case)
     memset(mesh->n_x, 0, mesh->vertex_count * sizeof(float));
     memset(mesh->n_y, 0, mesh->vertex_count * sizeof(float));
@@ -83,160 +49,28 @@ static void calculate_normals(Mesh *mesh) {
 
 Mesh load_mesh(const char *filename) {
     Mesh mesh = {0};
-    FILE *file = fopen(filename, "r");
-    if (!file) {
-        fprintf(stderr, "Failed to open OBJ file: %s\n", filename);
+    if (mesh_cache_load(filename, &mesh) == 0) {
+        mesh_update_bounds(&mesh);
+        printf("Mesh Loaded (cache): %zu vertices, %zu indices\n", mesh.vertex_count, mesh.index_count);
         return mesh;
     }
 
-    // --- RAW DATA POOLS ---
-    vec3 *pos_pool = NULL;  size_t p_count = 0, p_cap = 0;
-    vec3 *norm_pool = NULL; size_t n_count = 0, n_cap = 0;
-    vec2 *uv_pool = NULL;   size_t u_count = 0, u_cap = 0;
-
-    // --- FINAL MESH BUFFERS (SoA) ---
-    float *f_px = NULL, *f_py = NULL, *f_pz = NULL;
-    float *f_nx = NULL, *f_ny = NULL, *f_nz = NULL;
-    float *f_u = NULL, *f_v = NULL;
-    uint32_t *f_colors = NULL;
-    uint32_t *f_indices = NULL;
-    
-    size_t v_count = 0, v_cap = 0;
-    size_t i_count = 0, i_cap = 0;
-
-    HashNode **buckets = calloc(HASH_TABLE_SIZE, sizeof(HashNode*));
-    if (!buckets) { fprintf(stderr, "Out of memory\n"); exit(1); }
-
-    char line[256];
-    while (fgets(line, sizeof(line), file)) {
-        if (strncmp(line, "v ", 2) == 0) {
-            vec3 p; sscanf(line, "v %f %f %f", &p.x, &p.y, &p.z);
-            ARRAY_PUSH(vec3, pos_pool, p_count, p_cap, p);
-        } else if (strncmp(line, "vt ", 3) == 0) {
-            vec2 uv; sscanf(line, "vt %f %f", &uv.x, &uv.y);
-            ARRAY_PUSH(vec2, uv_pool, u_count, u_cap, uv);
-        } else if (strncmp(line, "vn ", 3) == 0) {
-            vec3 n; sscanf(line, "vn %f %f %f", &n.x, &n.y, &n.z);
-            ARRAY_PUSH(vec3, norm_pool, n_count, n_cap, n);
-        } else if (strncmp(line, "f ", 2) == 0) {
-            int v[3], t[3], n[3];
-            int has_uvs = 0, has_norms = 0, matches = 0;
-
-            if ((matches = sscanf(line, "f %d/%d/%d %d/%d/%d %d/%d/%d", 
-                &v[0], &t[0], &n[0], &v[1], &t[1], &n[1], &v[2], &t[2], &n[2])) == 9) {
-                has_uvs = 1; has_norms = 1;
-            } else if ((matches = sscanf(line, "f %d//%d %d//%d %d//%d", 
-                &v[0], &n[0], &v[1], &n[1], &v[2], &n[2])) == 6) {
-                has_norms = 1;
-            } else if ((matches = sscanf(line, "f %d/%d %d/%d %d/%d", 
-                &v[0], &t[0], &v[1], &t[1], &v[2], &t[2])) == 6) {
-                has_uvs = 1;
-            } else {
-                sscanf(line, "f %d %d %d", &v[0], &v[1], &v[2]);
-            }
-
-            for (int k = 0; k < 3; k++) {
-                VertexKey key;
-                key.p_idx = v[k] - 1;
-                key.t_idx = has_uvs   ? t[k] - 1 : -1;
-                key.n_idx = has_norms ? n[k] - 1 : -1;
-
-                uint32_t h = hash_key(key);
-                uint32_t final_idx = (uint32_t)-1;
-                HashNode *node = buckets[h];
-                
-                while (node) {
-                    if (node->key.p_idx == key.p_idx && 
-                        node->key.t_idx == key.t_idx && 
-                        node->key.n_idx == key.n_idx) {
-                        final_idx = node->final_index;
-                        break;
-                    }
-                    node = node->next;
-                }
-
-                if (final_idx == (uint32_t)-1) {
-                    final_idx = v_count;
-                    if (v_count >= v_cap) {
-                        v_cap = v_cap == 0 ? 128 : v_cap * 2;
-                        f_px = realloc(f_px, v_cap * sizeof(float));
-                        f_py = realloc(f_py, v_cap * sizeof(float));
-                        f_pz = realloc(f_pz, v_cap * sizeof(float));
-                        f_nx = realloc(f_nx, v_cap * sizeof(float));
-                        f_ny = realloc(f_ny, v_cap * sizeof(float));
-                        f_nz = realloc(f_nz, v_cap * sizeof(float));
-                        f_u  = realloc(f_u,  v_cap * sizeof(float));
-                        f_v  = realloc(f_v,  v_cap * sizeof(float));
-                        f_colors = realloc(f_colors, v_cap * sizeof(uint32_t));
-                    }
-
-                    if (key.p_idx >= 0 && key.p_idx < p_count) {
-                        f_px[v_count] = pos_pool[key.p_idx].x;
-                        f_py[v_count] = pos_pool[key.p_idx].y;
-                        f_pz[v_count] = pos_pool[key.p_idx].z;
-                    }
-
-                    if (key.n_idx >= 0 && key.n_idx < n_count) {
-                        f_nx[v_count] = norm_pool[key.n_idx].x;
-                        f_ny[v_count] = norm_pool[key.n_idx].y;
-                        f_nz[v_count] = norm_pool[key.n_idx].z;
-                    } else {
-                        f_nx[v_count] = 0; f_ny[v_count] = 0; f_nz[v_count] = 0;
-                    }
-
-                    if (key.t_idx >= 0 && key.t_idx < u_count) {
-                        f_u[v_count] = uv_pool[key.t_idx].x;
-                        f_v[v_count] = uv_pool[key.t_idx].y;
-                    } else {
-                        f_u[v_count] = 0; f_v[v_count] = 0;
-                    }
-                    
-                    f_colors[v_count] = 0xFFFFFFFF;
-                    v_count++;
-
-                    HashNode *new_node = malloc(sizeof(HashNode));
-                    new_node->key = key;
-                    new_node->final_index = final_idx;
-                    new_node->next = buckets[h];
-                    buckets[h] = new_node;
-                }
-                ARRAY_PUSH(uint32_t, f_indices, i_count, i_cap, final_idx);
-            }
-        }
-    }
-
-    // --- ASSIGN TO MESH ---
-    mesh.vertex_count = v_count;
-    mesh.index_count  = i_count;
-    mesh.p_x = f_px; mesh.p_y = f_py; mesh.p_z = f_pz;
-    mesh.n_x = f_nx; mesh.n_y = f_ny; mesh.n_z = f_nz;
-    mesh.u   = f_u;  mesh.v   = f_v;
-    mesh.colors  = f_colors;
-    mesh.indices = f_indices;
-
-    // --- AUTO-CALCULATE NORMALS IF MISSING ---
-    if (n_count == 0 && mesh.index_count > 0) {
-        calculate_normals(&mesh);
-    }
-
-    // --- CLEANUP ---
-    free(pos_pool); free(uv_pool); free(norm_pool);
-    for (int i = 0; i < HASH_TABLE_SIZE; i++) {
-        HashNode *node = buckets[i];
-        while (node) {
-            HashNode *next = node->next;
-            free(node);
-            node = next;
-        }
-    }
-    free(buckets);
-    fclose(file);
+    mesh = mesh_parse_obj(filename);
+    // Meshlets reorder the index buffer, so build them before both are cached
+    mesh_build_meshlets(&mesh);
+    if (mesh.vertex_count > 0) mesh_cache_write(filename, &mesh);
+    mesh_update_bounds(&mesh);
 
     printf("Mesh Loaded: %zu vertices, %zu indices\n", mesh.vertex_count, mesh.index_count);
     return mesh;
 }
 
 void free_mesh(Mesh *mesh) {
+    mesh_free_meshlets(mesh);
+    if (mesh->mapping) {
+        munmap(mesh->mapping, mesh->mapping_size);
+        return;
+    }
     free(mesh->p_x); free(mesh->p_y); free(mesh->p_z);
     free(mesh->n_x); free(mesh->n_y); free(mesh->n_z);
     free(mesh->u);   free(mesh->v);
@@ -265,6 +99,18 @@ BoundingBox mesh_calculate_bounds(const Mesh *mesh) {
     return bb;
 }
 
+void mesh_update_bounds(Mesh *mesh) {
+    mesh->bounds = mesh_calculate_bounds(mesh);
+    float r2 = 0.0f;
+    for (size_t i = 0; i < mesh->vertex_count; i++) {
+        float dx = mesh->p_x[i] - mesh->bounds.center.x;
+        float dy = mesh->p_y[i] - mesh->bounds.center.y;
+        float dz = mesh->p_z[i] - mesh->bounds.center.z;
+        r2 = MAX(r2, dx*dx + dy*dy + dz*dz);
+    }
+    mesh->bounds_radius = sqrtf(r2);
+}
+
 void mesh_center_origin(Mesh *mesh) {
     BoundingBox bb = mesh_calculate_bounds(mesh);
 
@@ -273,4 +119,10 @@ void mesh_center_origin(Mesh *mesh) {
         mesh->p_y[i] -= bb.center.y;
         mesh->p_z[i] -= bb.center.z;
     }
+    for (size_t i = 0; i < mesh->meshlet_count; i++) {
+        mesh->meshlets[i].center = vec3_sub(mesh->meshlets[i].center, bb.center);
+    }
+    mesh->bounds.min = vec3_sub(bb.min, bb.center);
+    mesh->bounds.max = vec3_sub(bb.max, bb.center);
+    mesh->bounds.center = (vec3){0, 0, 0};
 }
@@ -0,0 +1,198 @@
+#include "mesh.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define MESH_CACHE_MAGIC     "SRMESH\0"
+#define MESH_CACHE_VERSION   2
+#define MESH_CACHE_ENDIAN    0x01020304u
+#define MESH_CACHE_ALIGN     64
+#define MESH_CACHE_EXT       ".meshbin"
+
+// Order of the arrays stored after the header
+enum { CACHE_PX, CACHE_PY, CACHE_PZ, CACHE_NX, CACHE_NY, CACHE_NZ, CACHE_U, CACHE_V, CACHE_COLORS, CACHE_INDICES,
+       CACHE_MESHLETS, CACHE_MESHLET_VERTICES, CACHE_ARRAY_COUNT };
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t endian;
+    uint64_t source_size;
+    int64_t  source_mtime_sec;
+    int64_t  source_mtime_nsec;
+    uint64_t vertex_count;
+    uint64_t index_count;
+    uint64_t meshlet_count;
+    uint64_t meshlet_vertex_count;
+    uint64_t offsets[CACHE_ARRAY_COUNT]; // Byte offsets from the start of the file
+    uint64_t file_size;
+} MeshCacheHeader;
+
+static size_t align_up(size_t v) {
+    return (v + MESH_CACHE_ALIGN - 1) & ~(size_t)(MESH_CACHE_ALIGN - 1);
+}
+
+static void cache_path(const char *obj_path, char *out, size_t len) {
+    snprintf(out, len, "%s%s", obj_path, MESH_CACHE_EXT);
+}
+
+static int source_stamp(const char *obj_path, uint64_t *size, int64_t *sec, int64_t *nsec) {
+    struct stat st;
+    if (stat(obj_path, &st) != 0) return -1;
+    *size = (uint64_t)st.st_size;
+#ifdef __APPLE__
+    *sec = st.st_mtimespec.tv_sec; *nsec = st.st_mtimespec.tv_nsec;
+#else
+    *sec = st.st_mtim.tv_sec;      *nsec = st.st_mtim.tv_nsec;
+#endif
+    return 0;
+}
+
+static uint64_t cache_array_bytes(const MeshCacheHeader *h, int i) {
+    switch (i) {
+        case CACHE_INDICES:          return h->index_count * sizeof(uint32_t);
+        case CACHE_MESHLETS:         return h->meshlet_count * sizeof(Meshlet);
+        case CACHE_MESHLET_VERTICES: return h->meshlet_vertex_count * sizeof(uint32_t);
+        default:                     return h->vertex_count * 4;   // float and uint32_t alike
+    }
+}
+
+// Computes the aligned layout shared by the writer and the validator
+static uint64_t cache_layout(const MeshCacheHeader *h, uint64_t offsets[CACHE_ARRAY_COUNT]) {
+    size_t cursor = align_up(sizeof(MeshCacheHeader));
+    for (int i = 0; i < CACHE_ARRAY_COUNT; i++) {
+        offsets[i] = cursor;
+        cursor = align_up(cursor + cache_array_bytes(h, i));
+    }
+    return cursor;
+}
+
+// Every index the vertex stage and cluster culling follow stays in range, so a
+// corrupt file is rejected here instead of read out of bounds later
+static int cache_ranges_valid(const MeshCacheHeader *h, const char *base) {
+    const uint32_t *indices = (const uint32_t*)(base + h->offsets[CACHE_INDICES]);
+    const Meshlet *meshlets = (const Meshlet*)(base + h->offsets[CACHE_MESHLETS]);
+    const uint32_t *meshlet_vertices = (const uint32_t*)(base + h->offsets[CACHE_MESHLET_VERTICES]);
+    for (uint64_t i = 0; i < h->index_count; i++) {
+        if (indices[i] >= h->vertex_count) return 0;
+    }
+    for (uint64_t i = 0; i < h->meshlet_count; i++) {
+        const Meshlet *m = &meshlets[i];
+        if ((uint64_t)m->index_offset + (uint64_t)m->triangle_count * 3 > h->index_count) return 0;
+        if ((uint64_t)m->vertex_offset + m->vertex_count > h->meshlet_vertex_count) return 0;
+    }
+    for (uint64_t i = 0; i < h->meshlet_vertex_count; i++) {
+        if (meshlet_vertices[i] >= h->vertex_count) return 0;
+    }
+    return 1;
+}
+
+int mesh_cache_load(const char *obj_path, Mesh *out_mesh) {
+    uint64_t src_size; int64_t src_sec, src_nsec;
+    if (source_stamp(obj_path, &src_size, &src_sec, &src_nsec) != 0) return -1;
+
+    char path[1024];
+    cache_path(obj_path, path, sizeof(path));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(MeshCacheHeader)) { close(fd); return -1; }
+
+    // MAP_PRIVATE + PROT_WRITE: reads are zero-copy, in-place edits (mesh_center_origin) copy-on-write
+    size_t size = (size_t)st.st_size;
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    const MeshCacheHeader *h = map;
+    uint64_t expected[CACHE_ARRAY_COUNT];
+    int valid = memcmp(h->magic, MESH_CACHE_MAGIC, sizeof(h->magic)) == 0 &&
+                h->version == MESH_CACHE_VERSION && h->endian == MESH_CACHE_ENDIAN &&
+                h->source_size == src_size && h->source_mtime_sec == src_sec && h->source_mtime_nsec == src_nsec &&
+                h->file_size == size &&
+                cache_layout(h, expected) == size &&
+                memcmp(expected, h->offsets, sizeof(expected)) == 0 &&
+                cache_ranges_valid(h, map);
+    if (!valid) {
+        munmap(map, size);
+        return -1;
+    }
+
+    char *base = map;
+    Mesh mesh = {0};
+    mesh.vertex_count = h->vertex_count;
+    mesh.index_count  = h->index_count;
+    mesh.p_x = (float*)(base + h->offsets[CACHE_PX]);
+    mesh.p_y = (float*)(base + h->offsets[CACHE_PY]);
+    mesh.p_z = (float*)(base + h->offsets[CACHE_PZ]);
+    mesh.n_x = (float*)(base + h->offsets[CACHE_NX]);
+    mesh.n_y = (float*)(base + h->offsets[CACHE_NY]);
+    mesh.n_z = (float*)(base + h->offsets[CACHE_NZ]);
+    mesh.u   = (float*)(base + h->offsets[CACHE_U]);
+    mesh.v   = (float*)(base + h->offsets[CACHE_V]);
+    mesh.colors  = (uint32_t*)(base + h->offsets[CACHE_COLORS]);
+    mesh.indices = (uint32_t*)(base + h->offsets[CACHE_INDICES]);
+    mesh.meshlets = (Meshlet*)(base + h->offsets[CACHE_MESHLETS]);
+    mesh.meshlet_vertices = (uint32_t*)(base + h->offsets[CACHE_MESHLET_VERTICES]);
+    mesh.meshlet_count = h->meshlet_count;
+    mesh.mapping = map;
+    mesh.mapping_size = size;
+
+    *out_mesh = mesh;
+    return 0;
+}
+
+int mesh_cache_write(const char *obj_path, const Mesh *mesh) {
+    MeshCacheHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, MESH_CACHE_MAGIC, sizeof(h.magic));
+    h.version = MESH_CACHE_VERSION;
+    h.endian = MESH_CACHE_ENDIAN;
+    if (source_stamp(obj_path, &h.source_size, &h.source_mtime_sec, &h.source_mtime_nsec) != 0) return -1;
+    h.vertex_count = mesh->vertex_count;
+    h.index_count = mesh->index_count;
+    h.meshlet_count = mesh->meshlet_count;
+    // Meshlets own consecutive runs of meshlet_vertices, so the last one ends the array
+    if (mesh->meshlet_count > 0) {
+        const Meshlet *last = &mesh->meshlets[mesh->meshlet_count - 1];
+        h.meshlet_vertex_count = (uint64_t)last->vertex_offset + last->vertex_count;
+    }
+    h.file_size = cache_layout(&h, h.offsets);
+
+    const void *arrays[CACHE_ARRAY_COUNT] = {
+        mesh->p_x, mesh->p_y, mesh->p_z, mesh->n_x, mesh->n_y, mesh->n_z,
+        mesh->u, mesh->v, mesh->colors, mesh->indices, mesh->meshlets, mesh->meshlet_vertices
+    };
+
+    // Write to a temporary file and rename so readers never see a partial cache
+    char path[1024], tmp_path[1040];
+    cache_path(obj_path, path, sizeof(path));
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%d.tmp", path, (int)getpid());
+
+    FILE *f = fopen(tmp_path, "wb");
+    if (!f) return -1;
+
+    static const char zeros[MESH_CACHE_ALIGN] = {0};
+    int ok = fwrite(&h, sizeof(h), 1, f) == 1;
+    size_t cursor = sizeof(h);
+    for (int i = 0; i < CACHE_ARRAY_COUNT && ok; i++) {
+        size_t bytes = cache_array_bytes(&h, i);
+        ok = fwrite(zeros, 1, h.offsets[i] - cursor, f) == h.offsets[i] - cursor;
+        ok = ok && fwrite(arrays[i], 1, bytes, f) == bytes;
+        cursor = h.offsets[i] + bytes;
+    }
+    ok = ok && fwrite(zeros, 1, h.file_size - cursor, f) == h.file_size - cursor;
+    ok = (fclose(f) == 0) && ok;
+
+    if (!ok || rename(tmp_path, path) != 0) {
+        fprintf(stderr, "Failed to write mesh cache: %s\n", path);
+        remove(tmp_path);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,467 @@
+#include "mesh.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Quadric error metric simplification (Garland & Heckbert) using half-edge
+// collapses: a vertex always moves onto one of its neighbours, so the output
+// reuses the source attributes and no new vertices are interpolated.
+
+#define BOUNDARY_WEIGHT 10.0
+#define MIN_FLIP_COS    0.2f // Reject collapses that rotate a face by more than ~78 degrees
+
+/* --- 1. QUADRICS --- */
+// Symmetric 4x4 matrix, upper triangle: a2 ab ac ad b2 bc bd c2 cd d2
+typedef struct { double q[10]; } Quadric;
+
+static inline void quadric_add_plane(Quadric *Q, double a, double b, double c, double d, double w) {
+    Q->q[0] += w*a*a; Q->q[1] += w*a*b; Q->q[2] += w*a*c; Q->q[3] += w*a*d;
+    Q->q[4] += w*b*b; Q->q[5] += w*b*c; Q->q[6] += w*b*d;
+    Q->q[7] += w*c*c; Q->q[8] += w*c*d;
+    Q->q[9] += w*d*d;
+}
+
+static inline void quadric_add(Quadric *dst, const Quadric *src) {
+    for (int i = 0; i < 10; i++) dst->q[i] += src->q[i];
+}
+
+static inline double quadric_eval(const Quadric *A, const Quadric *B, vec3 p) {
+    double q[10];
+    for (int i = 0; i < 10; i++) q[i] = A->q[i] + B->q[i];
+    double x = p.x, y = p.y, z = p.z;
+    double e = q[0]*x*x + 2*q[1]*x*y + 2*q[2]*x*z + 2*q[3]*x
+             + q[4]*y*y + 2*q[5]*y*z + 2*q[6]*y
+             + q[7]*z*z + 2*q[8]*z
+             + q[9];
+    return e > 0.0 ? e : 0.0;
+}
+
+/* --- 2. COLLAPSE HEAP --- */
+typedef struct {
+    float    cost;
+    uint32_t from, to;
+    uint32_t from_version, to_version;
+} Collapse;
+
+typedef struct {
+    Collapse *items;
+    size_t    count, capacity;
+} CollapseHeap;
+
+static void heap_push(CollapseHeap *h, Collapse c) {
+    if (h->count == h->capacity) {
+        h->capacity = h->capacity ? h->capacity * 2 : 1024;
+        h->items = realloc(h->items, h->capacity * sizeof(Collapse));
+        if (!h->items) { fprintf(stderr, "Out of memory\n"); exit(1); }
+    }
+    size_t i = h->count++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (h->items[parent].cost <= c.cost) break;
+        h->items[i] = h->items[parent];
+        i = parent;
+    }
+    h->items[i] = c;
+}
+
+static Collapse heap_pop(CollapseHeap *h) {
+    Collapse top = h->items[0];
+    Collapse last = h->items[--h->count];
+    size_t i = 0;
+    while (1) {
+        size_t child = 2 * i + 1;
+        if (child >= h->count) break;
+        if (child + 1 < h->count && h->items[child + 1].cost < h->items[child].cost) child++;
+        if (last.cost <= h->items[child].cost) break;
+        h->items[i] = h->items[child];
+        i = child;
+    }
+    if (h->count) h->items[i] = last;
+    return top;
+}
+
+/* --- 3. SIMPLIFIER STATE --- */
+typedef struct {
+    const Mesh *src;
+
+    // Welded positions; attribute vertices sharing a position form a list
+    size_t    pos_count;
+    vec3     *pos;
+    uint32_t *vert_pos;              // Source vertex -> position
+    uint32_t *pos_vert_start;        // CSR [pos_count + 1] into pos_verts
+    uint32_t *pos_verts;
+    uint8_t  *locked;                // Attribute seams never move
+    uint8_t  *removed;
+    uint32_t *version;
+    Quadric  *quadrics;
+    double   *weight;                // Summed face area, turns the quadric into a mean squared distance
+
+    // Triangles reference positions (for topology) and vertices (for output)
+    size_t    tri_count, live_tris;
+    uint32_t *tri_pos;
+    uint32_t *tri_vert;
+    uint8_t  *tri_alive;
+
+    // Position -> triangles; positions merged into another are chained onto it
+    uint32_t *pos_tri_start;
+    uint32_t *pos_tris;
+    uint32_t *merge_next, *merge_tail;
+
+    CollapseHeap heap;
+} Simplifier;
+
+static void* simp_alloc(size_t bytes) {
+    void *ptr = calloc(1, bytes ? bytes : 1);
+    if (!ptr) { fprintf(stderr, "Out of memory\n"); exit(1); }
+    return ptr;
+}
+
+static inline uint32_t hash_position(float x, float y, float z) {
+    uint32_t bits[3];
+    memcpy(&bits[0], &x, 4); memcpy(&bits[1], &y, 4); memcpy(&bits[2], &z, 4);
+    return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+}
+
+// Vertices split by UV or normal seams share one position
+static void simp_weld(Simplifier *s) {
+    const Mesh *m = s->src;
+    size_t cap = 16;
+    while (cap < m->vertex_count * 2) cap <<= 1;
+    uint32_t *table = malloc(cap * sizeof(uint32_t));
+    memset(table, 0xFF, cap * sizeof(uint32_t));
+
+    s->pos = simp_alloc(m->vertex_count * sizeof(vec3));
+    s->vert_pos = simp_alloc(m->vertex_count * sizeof(uint32_t));
+    for (size_t v = 0; v < m->vertex_count; v++) {
+        float x = m->p_x[v], y = m->p_y[v], z = m->p_z[v];
+        uint32_t slot = hash_position(x, y, z) & (uint32_t)(cap - 1);
+        while (table[slot] != UINT32_MAX) {
+            vec3 p = s->pos[table[slot]];
+            if (p.x == x && p.y == y && p.z == z) break;
+            slot = (slot + 1) & (uint32_t)(cap - 1);
+        }
+        if (table[slot] == UINT32_MAX) {
+            table[slot] = (uint32_t)s->pos_count;
+            s->pos[s->pos_count++] = (vec3){x, y, z};
+        }
+        s->vert_pos[v] = table[slot];
+    }
+    free(table);
+
+    s->pos_vert_start = simp_alloc((s->pos_count + 1) * sizeof(uint32_t));
+    s->pos_verts = simp_alloc(m->vertex_count * sizeof(uint32_t));
+    for (size_t v = 0; v < m->vertex_count; v++) s->pos_vert_start[s->vert_pos[v] + 1]++;
+    for (size_t p = 0; p < s->pos_count; p++) s->pos_vert_start[p + 1] += s->pos_vert_start[p];
+    uint32_t *fill = simp_alloc(s->pos_count * sizeof(uint32_t));
+    for (size_t v = 0; v < m->vertex_count; v++) {
+        uint32_t p = s->vert_pos[v];
+        s->pos_verts[s->pos_vert_start[p] + fill[p]++] = (uint32_t)v;
+    }
+    free(fill);
+
+    s->locked = simp_alloc(s->pos_count);
+    for (size_t p = 0; p < s->pos_count; p++) {
+        s->locked[p] = (s->pos_vert_start[p + 1] - s->pos_vert_start[p]) > 1;
+    }
+}
+
+static void simp_build_triangles(Simplifier *s) {
+    const Mesh *m = s->src;
+    size_t tris = m->index_count / 3;
+    s->tri_pos = simp_alloc(tris * 3 * sizeof(uint32_t));
+    s->tri_vert = simp_alloc(tris * 3 * sizeof(uint32_t));
+    s->tri_alive = simp_alloc(tris);
+
+    for (size_t t = 0; t < tris; t++) {
+        uint32_t v0 = m->indices[t*3], v1 = m->indices[t*3+1], v2 = m->indices[t*3+2];
+        if (v0 >= m->vertex_count || v1 >= m->vertex_count || v2 >= m->vertex_count) continue;
+        uint32_t p0 = s->vert_pos[v0], p1 = s->vert_pos[v1], p2 = s->vert_pos[v2];
+        if (p0 == p1 || p1 == p2 || p0 == p2) continue; // Already degenerate
+
+        size_t o = s->tri_count++ * 3;
+        s->tri_pos[o] = p0;  s->tri_pos[o+1] = p1;  s->tri_pos[o+2] = p2;
+        s->tri_vert[o] = v0; s->tri_vert[o+1] = v1; s->tri_vert[o+2] = v2;
+        s->tri_alive[o / 3] = 1;
+    }
+    s->live_tris = s->tri_count;
+
+    s->pos_tri_start = simp_alloc((s->pos_count + 1) * sizeof(uint32_t));
+    s->pos_tris = simp_alloc(s->tri_count * 3 * sizeof(uint32_t));
+    for (size_t i = 0; i < s->tri_count * 3; i++) s->pos_tri_start[s->tri_pos[i] + 1]++;
+    for (size_t p = 0; p < s->pos_count; p++) s->pos_tri_start[p + 1] += s->pos_tri_start[p];
+    uint32_t *fill = simp_alloc(s->pos_count * sizeof(uint32_t));
+    for (size_t i = 0; i < s->tri_count * 3; i++) {
+        uint32_t p = s->tri_pos[i];
+        s->pos_tris[s->pos_tri_start[p] + fill[p]++] = (uint32_t)(i / 3);
+    }
+    free(fill);
+
+    s->merge_next = simp_alloc(s->pos_count * sizeof(uint32_t));
+    s->merge_tail = simp_alloc(s->pos_count * sizeof(uint32_t));
+    for (size_t p = 0; p < s->pos_count; p++) {
+        s->merge_next[p] = UINT32_MAX;
+        s->merge_tail[p] = (uint32_t)p;
+    }
+}
+
+// Does the boundary edge (a, b) of triangle t have no other triangle on its far side?
+static int simp_edge_is_boundary(const Simplifier *s, uint32_t t, uint32_t a, uint32_t b) {
+    for (uint32_t i = s->pos_tri_start[a]; i < s->pos_tri_start[a + 1]; i++) {
+        uint32_t other = s->pos_tris[i];
+        if (other == t) continue;
+        const uint32_t *p = &s->tri_pos[other * 3];
+        if (p[0] == b || p[1] == b || p[2] == b) return 0;
+    }
+    return 1;
+}
+
+static void simp_build_quadrics(Simplifier *s) {
+    s->quadrics = simp_alloc(s->pos_count * sizeof(Quadric));
+    s->weight = simp_alloc(s->pos_count * sizeof(double));
+
+    for (size_t t = 0; t < s->tri_count; t++) {
+        const uint32_t *p = &s->tri_pos[t * 3];
+        vec3 a = s->pos[p[0]], b = s->pos[p[1]], c = s->pos[p[2]];
+        vec3 n = vec3_cross(vec3_sub(b, a), vec3_sub(c, a));
+        float len = vec3_len(n);
+        if (len <= 0.0f) continue;
+        double area = 0.5 * len;
+        n = vec3_mul(n, 1.0f / len);
+        double d = -vec3_dot(n, a);
+
+        for (int k = 0; k < 3; k++) {
+            quadric_add_plane(&s->quadrics[p[k]], n.x, n.y, n.z, d, area);
+            s->weight[p[k]] += area;
+        }
+
+        // Open borders get a perpendicular plane so they do not shrink inwards
+        for (int k = 0; k < 3; k++) {
+            uint32_t e0 = p[k], e1 = p[(k + 1) % 3];
+            if (!simp_edge_is_boundary(s, (uint32_t)t, e0, e1)) continue;
+            vec3 edge = vec3_sub(s->pos[e1], s->pos[e0]);
+            vec3 bn = vec3_norm(vec3_cross(edge, n));
+            double bd = -vec3_dot(bn, s->pos[e0]);
+            double w = BOUNDARY_WEIGHT * vec3_len_sq(edge);
+            quadric_add_plane(&s->quadrics[e0], bn.x, bn.y, bn.z, bd, w);
+            quadric_add_plane(&s->quadrics[e1], bn.x, bn.y, bn.z, bd, w);
+        }
+    }
+
+    s->removed = simp_alloc(s->pos_count);
+    s->version = simp_alloc(s->pos_count * sizeof(uint32_t));
+}
+
+/* --- 4. COLLAPSES --- */
+// Area-weighted RMS distance of the moved vertex to its accumulated planes
+static inline float simp_collapse_error(const Simplifier *s, uint32_t from, uint32_t to) {
+    double e = quadric_eval(&s->quadrics[from], &s->quadrics[to], s->pos[to]);
+    double w = s->weight[from] + s->weight[to];
+    return (float)sqrt(w > 0.0 ? e / w : e);
+}
+
+// Queues the cheaper direction of edge (a, b); locked positions only receive
+static void simp_push_edge(Simplifier *s, uint32_t a, uint32_t b) {
+    if (s->locked[a] && s->locked[b]) return;
+    Collapse c;
+    if (s->locked[a]) {
+        c = (Collapse){ simp_collapse_error(s, b, a), b, a, 0, 0 };
+    } else if (s->locked[b]) {
+        c = (Collapse){ simp_collapse_error(s, a, b), a, b, 0, 0 };
+    } else {
+        float ab = simp_collapse_error(s, a, b), ba = simp_collapse_error(s, b, a);
+        c = (ab <= ba) ? (Collapse){ ab, a, b, 0, 0 } : (Collapse){ ba, b, a, 0, 0 };
+    }
+    c.from_version = s->version[c.from];
+    c.to_version = s->version[c.to];
+    heap_push(&s->heap, c);
+}
+
+#define FOR_EACH_TRI(s, root, t)                                                         \
+    for (uint32_t _q = (root); _q != UINT32_MAX; _q = (s)->merge_next[_q])               \
+        for (uint32_t _i = (s)->pos_tri_start[_q], t; _i < (s)->pos_tri_start[_q + 1] && \
+             ((t = (s)->pos_tris[_i]), 1); _i++)                                         \
+            if ((s)->tri_alive[t])
+
+// Rejects collapses that would flip or crush a surviving face
+static int simp_collapse_valid(const Simplifier *s, uint32_t from, uint32_t to) {
+    vec3 target = s->pos[to];
+    FOR_EACH_TRI(s, from, t) {
+        const uint32_t *p = &s->tri_pos[t * 3];
+        if (p[0] == to || p[1] == to || p[2] == to) continue; // Removed by the collapse
+
+        vec3 a = s->pos[p[0]], b = s->pos[p[1]], c = s->pos[p[2]];
+        vec3 n0 = vec3_cross(vec3_sub(b, a), vec3_sub(c, a));
+        if (p[0] == from) a = target;
+        if (p[1] == from) b = target;
+        if (p[2] == from) c = target;
+        vec3 n1 = vec3_cross(vec3_sub(b, a), vec3_sub(c, a));
+
+        float l0 = vec3_len(n0), l1 = vec3_len(n1);
+        if (l1 <= 1e-12f) return 0;
+        if (l0 > 0.0f && vec3_dot(n0, n1) < MIN_FLIP_COS * l0 * l1) return 0;
+    }
+    return 1;
+}
+
+// Attribute vertex at `to` closest to the one a corner used at `from`
+static uint32_t simp_pick_vertex(const Simplifier *s, uint32_t old_vert, uint32_t to) {
+    const Mesh *m = s->src;
+    uint32_t begin = s->pos_vert_start[to], end = s->pos_vert_start[to + 1];
+    uint32_t best = s->pos_verts[begin];
+    float best_d = INFINITY;
+    for (uint32_t i = begin; i < end; i++) {
+        uint32_t v = s->pos_verts[i];
+        float dn = (m->n_x[v]-m->n_x[old_vert])*(m->n_x[v]-m->n_x[old_vert])
+                 + (m->n_y[v]-m->n_y[old_vert])*(m->n_y[v]-m->n_y[old_vert])
+                 + (m->n_z[v]-m->n_z[old_vert])*(m->n_z[v]-m->n_z[old_vert]);
+        float du = (m->u[v]-m->u[old_vert])*(m->u[v]-m->u[old_vert])
+                 + (m->v[v]-m->v[old_vert])*(m->v[v]-m->v[old_vert]);
+        if (dn + du < best_d) { best_d = dn + du; best = v; }
+    }
+    return best;
+}
+
+static void simp_collapse(Simplifier *s, uint32_t from, uint32_t to) {
+    FOR_EACH_TRI(s, from, t) {
+        uint32_t *p = &s->tri_pos[t * 3];
+        if (p[0] == to || p[1] == to || p[2] == to) {
+            s->tri_alive[t] = 0;
+            s->live_tris--;
+            continue;
+        }
+        for (int k = 0; k < 3; k++) {
+            if (p[k] != from) continue;
+            p[k] = to;
+            s->tri_vert[t * 3 + k] = simp_pick_vertex(s, s->tri_vert[t * 3 + k], to);
+        }
+    }
+
+    quadric_add(&s->quadrics[to], &s->quadrics[from]);
+    s->weight[to] += s->weight[from];
+    s->removed[from] = 1;
+    s->version[to]++;
+
+    // Chain the triangle lists of `from` behind `to`
+    s->merge_next[s->merge_tail[to]] = from;
+    s->merge_tail[to] = s->merge_tail[from];
+
+    FOR_EACH_TRI(s, to, t) {
+        const uint32_t *p = &s->tri_pos[t * 3];
+        for (int k = 0; k < 3; k++) {
+            if (p[k] != to) simp_push_edge(s, p[k], to);
+        }
+    }
+}
+
+static void simp_free(Simplifier *s) {
+    free(s->pos); free(s->vert_pos); free(s->pos_vert_start); free(s->pos_verts);
+    free(s->locked); free(s->removed); free(s->version); free(s->quadrics); free(s->weight);
+    free(s->tri_pos); free(s->tri_vert); free(s->tri_alive);
+    free(s->pos_tri_start); free(s->pos_tris); free(s->merge_next); free(s->merge_tail);
+    free(s->heap.items);
+}
+
+/* --- 5. OUTPUT --- */
+// Compacts the surviving triangles; vertices are renumbered in first-use order
+static Mesh simp_emit(const Simplifier *s) {
+    const Mesh *m = s->src;
+    uint32_t *remap = malloc((m->vertex_count ? m->vertex_count : 1) * sizeof(uint32_t));
+    memset(remap, 0xFF, m->vertex_count * sizeof(uint32_t));
+
+    Mesh out = {0};
+    out.index_count = s->live_tris * 3;
+    out.indices = simp_alloc(out.index_count * sizeof(uint32_t));
+    size_t vc = 0, ic = 0;
+    for (size_t t = 0; t < s->tri_count; t++) {
+        if (!s->tri_alive[t]) continue;
+        for (int k = 0; k < 3; k++) {
+            uint32_t v = s->tri_vert[t * 3 + k];
+            if (remap[v] == UINT32_MAX) remap[v] = (uint32_t)vc++;
+            out.indices[ic++] = remap[v];
+        }
+    }
+
+    out.vertex_count = vc;
+    out.p_x = simp_alloc(vc * sizeof(float)); out.p_y = simp_alloc(vc * sizeof(float)); out.p_z = simp_alloc(vc * sizeof(float));
+    out.n_x = simp_alloc(vc * sizeof(float)); out.n_y = simp_alloc(vc * sizeof(float)); out.n_z = simp_alloc(vc * sizeof(float));
+    out.u   = simp_alloc(vc * sizeof(float)); out.v   = simp_alloc(vc * sizeof(float));
+    out.colors = simp_alloc(vc * sizeof(uint32_t));
+    for (size_t v = 0; v < m->vertex_count; v++) {
+        uint32_t o = remap[v];
+        if (o == UINT32_MAX) continue;
+        out.p_x[o] = m->p_x[v]; out.p_y[o] = m->p_y[v]; out.p_z[o] = m->p_z[v];
+        out.n_x[o] = m->n_x[v]; out.n_y[o] = m->n_y[v]; out.n_z[o] = m->n_z[v];
+        out.u[o] = m->u[v];     out.v[o] = m->v[v];
+        out.colors[o] = m->colors[v];
+    }
+    free(remap);
+    return out;
+}
+
+/* --- 6. PUBLIC API --- */
+Mesh mesh_simplify(const Mesh *mesh, size_t target_index_count, float *out_rms_error) {
+    Simplifier s = { .src = mesh };
+    float max_error = 0.0f;
+
+    simp_weld(&s);
+    simp_build_triangles(&s);
+    simp_build_quadrics(&s);
+
+    for (size_t t = 0; t < s.tri_count; t++) {
+        const uint32_t *p = &s.tri_pos[t * 3];
+        // Each interior edge is seen twice; the stale copy is dropped when popped
+        simp_push_edge(&s, p[0], p[1]);
+        simp_push_edge(&s, p[1], p[2]);
+        simp_push_edge(&s, p[2], p[0]);
+    }
+
+    while (s.live_tris * 3 > target_index_count && s.heap.count > 0) {
+        Collapse c = heap_pop(&s.heap);
+        if (s.removed[c.from] || s.removed[c.to]) continue;
+        if (c.from_version != s.version[c.from] || c.to_version != s.version[c.to]) continue;
+        if (!simp_collapse_valid(&s, c.from, c.to)) continue;
+
+        simp_collapse(&s, c.from, c.to);
+        if (c.cost > max_error) max_error = c.cost;
+    }
+
+    Mesh out = simp_emit(&s);
+    simp_free(&s);
+    if (out_rms_error) *out_rms_error = max_error;
+    return out;
+}
+
+int mesh_build_lods(const Mesh *mesh, MeshLODChain *chain) {
+    memset(chain, 0, sizeof(*chain));
+    const Mesh *prev = mesh;
+    float error = 0.0f;
+
+    while (chain->count < MESH_MAX_LODS) {
+        size_t target = (prev->index_count / 6) * 3; // Halve the triangle count per level
+        if (target < MESH_LOD_MIN_TRIANGLES * 3) break;
+
+        float level_error = 0.0f;
+        Mesh lod = mesh_simplify(prev, target, &level_error);
+
+        // Stop once collapses stall (seams, tiny meshes); the level would not pay for itself
+        if (lod.index_count == 0 || lod.index_count * 4 > prev->index_count * 3) {
+            free_mesh(&lod);
+            break;
+        }
+
+        // Levels build on each other, so their errors are summed
+        error += level_error;
+        mesh_build_meshlets(&lod);
+        mesh_update_bounds(&lod);
+        chain->levels[chain->count] = lod;
+        chain->rms_error[chain->count] = error;
+        prev = &chain->levels[chain->count++];
+    }
+    return chain->count;
+}
+
+void mesh_free_lods(MeshLODChain *chain) {
+    for (int i = 0; i < chain->count; i++) free_mesh(&chain->levels[i]);
+    chain->count = 0;
+}
@@ -0,0 +1,158 @@
+#include "mesh.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+// Cones wider than this (min normal/axis cosine) can never be rejected
+#define MESHLET_CONE_MIN_DOT 0.1f
+
+static void meshlet_compute_bounds(const Mesh *mesh, Meshlet *m) {
+    const uint32_t *verts = &mesh->meshlet_vertices[m->vertex_offset];
+
+    // Sphere around the AABB centre
+    vec3 lo = {FLT_MAX, FLT_MAX, FLT_MAX}, hi = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (uint32_t i = 0; i < m->vertex_count; i++) {
+        uint32_t v = verts[i];
+        lo.x = MIN(lo.x, mesh->p_x[v]); hi.x = MAX(hi.x, mesh->p_x[v]);
+        lo.y = MIN(lo.y, mesh->p_y[v]); hi.y = MAX(hi.y, mesh->p_y[v]);
+        lo.z = MIN(lo.z, mesh->p_z[v]); hi.z = MAX(hi.z, mesh->p_z[v]);
+    }
+    m->center = vec3_mul(vec3_add(lo, hi), 0.5f);
+    float r2 = 0.0f;
+    for (uint32_t i = 0; i < m->vertex_count; i++) {
+        uint32_t v = verts[i];
+        vec3 d = { mesh->p_x[v] - m->center.x, mesh->p_y[v] - m->center.y, mesh->p_z[v] - m->center.z };
+        r2 = MAX(r2, vec3_len_sq(d));
+    }
+    m->radius = sqrtf(r2);
+
+    // Normal cone from the geometric face normals (the winding the cull mode sees)
+    vec3 normals[MESHLET_MAX_TRIANGLES];
+    vec3 axis = {0, 0, 0};
+    uint32_t valid = 0;
+    for (uint32_t t = 0; t < m->triangle_count; t++) {
+        const uint32_t *idx = &mesh->indices[m->index_offset + t * 3];
+        vec3 a = { mesh->p_x[idx[0]], mesh->p_y[idx[0]], mesh->p_z[idx[0]] };
+        vec3 b = { mesh->p_x[idx[1]], mesh->p_y[idx[1]], mesh->p_z[idx[1]] };
+        vec3 c = { mesh->p_x[idx[2]], mesh->p_y[idx[2]], mesh->p_z[idx[2]] };
+        vec3 n = vec3_cross(vec3_sub(b, a), vec3_sub(c, a));
+        float len = vec3_len(n);
+        if (len <= 0.0f) continue;
+        normals[valid] = vec3_mul(n, 1.0f / len);
+        axis = vec3_add(axis, normals[valid++]);
+    }
+
+    m->cone_axis = vec3_norm(axis);
+    m->cone_cutoff = 1.0f;
+    if (valid == 0 || vec3_len_sq(axis) == 0.0f) return;
+
+    float min_dot = 1.0f;
+    for (uint32_t t = 0; t < valid; t++) min_dot = MIN(min_dot, vec3_dot(normals[t], m->cone_axis));
+    if (min_dot >= MESHLET_CONE_MIN_DOT) m->cone_cutoff = sqrtf(1.0f - min_dot * min_dot);
+}
+
+static void* meshlet_alloc(size_t bytes) {
+    void *ptr = malloc(bytes ? bytes : 1);
+    if (!ptr) { fprintf(stderr, "Out of memory\n"); exit(1); }
+    return ptr;
+}
+
+// Meshlets grow greedily across shared vertices, preferring the triangle that
+// adds the fewest new vertices, so clusters are compact patches with tight
+// spheres and cones. The index buffer is rewritten in meshlet order.
+void mesh_build_meshlets(Mesh *mesh) {
+    mesh_free_meshlets(mesh);
+    size_t tri_count = mesh->index_count / 3;
+    size_t vc = mesh->vertex_count;
+    if (tri_count == 0) return;
+
+    // Vertex -> triangle adjacency (CSR)
+    uint32_t *adj_start = calloc(vc + 1, sizeof(uint32_t));
+    uint32_t *adj = meshlet_alloc(tri_count * 3 * sizeof(uint32_t));
+    if (!adj_start) { fprintf(stderr, "Out of memory\n"); exit(1); }
+    for (size_t i = 0; i < tri_count * 3; i++) adj_start[mesh->indices[i] + 1]++;
+    for (size_t v = 0; v < vc; v++) adj_start[v + 1] += adj_start[v];
+    uint32_t *fill = calloc(vc + 1, sizeof(uint32_t));
+    for (size_t i = 0; i < tri_count * 3; i++) {
+        uint32_t v = mesh->indices[i];
+        adj[adj_start[v] + fill[v]++] = (uint32_t)(i / 3);
+    }
+    free(fill);
+
+    uint8_t  *emitted = calloc(tri_count, 1);
+    uint8_t  *local = meshlet_alloc(vc);
+    uint32_t *ordered = meshlet_alloc(tri_count * 3 * sizeof(uint32_t));
+    memset(local, 0xFF, vc);
+
+    size_t meshlet_cap = tri_count / MESHLET_MAX_TRIANGLES + 16;
+    mesh->meshlets = meshlet_alloc(meshlet_cap * sizeof(Meshlet));
+    mesh->meshlet_vertices = meshlet_alloc(tri_count * 3 * sizeof(uint32_t));
+
+    size_t vertex_total = 0, index_total = 0, seed = 0;
+    while (1) {
+        while (seed < tri_count && emitted[seed]) seed++;
+        if (seed == tri_count) break;
+
+        Meshlet cur = { .index_offset = (uint32_t)index_total, .vertex_offset = (uint32_t)vertex_total };
+        uint32_t next = (uint32_t)seed;
+
+        while (1) {
+            const uint32_t *idx = &mesh->indices[next * 3];
+            emitted[next] = 1;
+            for (int k = 0; k < 3; k++) {
+                ordered[index_total++] = idx[k];
+                if (local[idx[k]] != 0xFF) continue;
+                local[idx[k]] = (uint8_t)cur.vertex_count++;
+                mesh->meshlet_vertices[vertex_total++] = idx[k];
+            }
+            if (++cur.triangle_count == MESHLET_MAX_TRIANGLES) break;
+
+            // Best neighbour of the meshlet: fewest vertices not yet in it
+            int best_new = 4;
+            for (uint32_t i = 0; i < cur.vertex_count && best_new > 0; i++) {
+                uint32_t v = mesh->meshlet_vertices[cur.vertex_offset + i];
+                for (uint32_t a = adj_start[v]; a < adj_start[v + 1]; a++) {
+                    uint32_t t = adj[a];
+                    if (emitted[t]) continue;
+                    const uint32_t *ti = &mesh->indices[t * 3];
+                    int extra = (local[ti[0]] == 0xFF) + (local[ti[1]] == 0xFF && ti[1] != ti[0]) +
+                                (local[ti[2]] == 0xFF && ti[2] != ti[0] && ti[2] != ti[1]);
+                    if (extra < best_new && cur.vertex_count + extra <= MESHLET_MAX_VERTICES) {
+                        best_new = extra;
+                        next = t;
+                        if (extra == 0) break;
+                    }
+                }
+            }
+            if (best_new == 4) break; // No connected triangle fits
+        }
+
+        for (uint32_t i = 0; i < cur.vertex_count; i++) local[mesh->meshlet_vertices[cur.vertex_offset + i]] = 0xFF;
+        if (mesh->meshlet_count == meshlet_cap) {
+            meshlet_cap *= 2;
+            mesh->meshlets = realloc(mesh->meshlets, meshlet_cap * sizeof(Meshlet));
+            if (!mesh->meshlets) { fprintf(stderr, "Out of memory\n"); exit(1); }
+        }
+        mesh->meshlets[mesh->meshlet_count++] = cur;
+    }
+
+    memcpy(mesh->indices, ordered, tri_count * 3 * sizeof(uint32_t));
+    for (size_t i = 0; i < mesh->meshlet_count; i++) meshlet_compute_bounds(mesh, &mesh->meshlets[i]);
+
+    free(adj_start); free(adj); free(emitted); free(local); free(ordered);
+    mesh->meshlet_vertices = realloc(mesh->meshlet_vertices, (vertex_total ? vertex_total : 1) * sizeof(uint32_t));
+}
+
+void mesh_free_meshlets(Mesh *mesh) {
+    // Meshlets loaded from a cache file live in its mapping, unmapped by free_mesh
+    uintptr_t map = (uintptr_t)mesh->mapping, at = (uintptr_t)mesh->meshlets;
+    if (!mesh->mapping || at < map || at >= map + mesh->mapping_size) {
+        free(mesh->meshlets);
+        free(mesh->meshlet_vertices);
+    }
+    mesh->meshlets = NULL;
+    mesh->meshlet_vertices = NULL;
+    mesh->meshlet_count = 0;
+}
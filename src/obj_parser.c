@@ -0,0 +1,640 @@
+#include "mesh.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+
+// Bulk OBJ parser: the file is mapped once, scanned for record counts so every
+// pool is allocated up front, then tokenized by hand. Unique vertices are
+// deduplicated through an open-addressing table; nothing is allocated per vertex.
+
+#define OBJ_NO_INDEX (-1)
+#define OBJ_EMPTY_SLOT UINT32_MAX
+#define OBJ_PARALLEL_MIN_BYTES (8u << 20) // Below this thread startup outweighs the gain
+
+typedef struct { int32_t p, t, n; } ObjKey;
+typedef struct { ObjKey key; uint32_t index; } ObjSlot;
+
+typedef struct {
+    ObjSlot *slots;
+    size_t   mask;
+    size_t   count;
+} ObjDedupTable;
+
+typedef struct {
+    const char *data;
+    size_t      size;
+    void       *mapping;
+} ObjFile;
+
+/* --- 1. FILE ACCESS --- */
+static int obj_file_open(const char *filename, ObjFile *out) {
+    memset(out, 0, sizeof(*out));
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) { close(fd); return -1; }
+    out->size = (size_t)st.st_size;
+    if (out->size == 0) { close(fd); return 0; }
+
+    void *map = mmap(NULL, out->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+#ifdef MADV_SEQUENTIAL
+    madvise(map, out->size, MADV_SEQUENTIAL);
+#endif
+    out->mapping = map;
+    out->data = map;
+    return 0;
+}
+
+static void obj_file_close(ObjFile *f) {
+    if (f->mapping) munmap(f->mapping, f->size);
+}
+
+/* --- 2. TOKENIZER --- */
+static inline int is_space(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+static inline int is_digit(char c) { return (unsigned)(c - '0') < 10u; }
+
+static inline const char* skip_space(const char *p, const char *end) {
+    while (p < end && is_space(*p)) p++;
+    return p;
+}
+
+static inline const char* skip_line(const char *p, const char *end) {
+    const char *nl = memchr(p, '\n', (size_t)(end - p));
+    return nl ? nl + 1 : end;
+}
+
+static const double pow10_table[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static double pow10_int(int e) {
+    double r = 1.0;
+    int a = e < 0 ? -e : e;
+    while (a > 22) { r *= 1e22; a -= 22; }
+    r *= pow10_table[a];
+    return e < 0 ? 1.0 / r : r;
+}
+
+// Parses [sign] digits [. digits] [e [sign] digits]. Returns p unchanged if no number.
+static const char* parse_float(const char *p, const char *end, float *out) {
+    const char *start = p;
+    int neg = 0;
+    if (p < end && (*p == '-' || *p == '+')) { neg = (*p == '-'); p++; }
+
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0, any = 0;
+    while (p < end && is_digit(*p)) {
+        if (digits < 19) { mantissa = mantissa * 10 + (uint64_t)(*p - '0'); digits += (mantissa != 0); }
+        else exponent++;
+        p++; any = 1;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && is_digit(*p)) {
+            if (digits < 19) { mantissa = mantissa * 10 + (uint64_t)(*p - '0'); digits += (mantissa != 0); exponent--; }
+            p++; any = 1;
+        }
+    }
+    if (!any) { *out = 0.0f; return start; }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char *e = p + 1;
+        int e_neg = 0, e_val = 0;
+        if (e < end && (*e == '-' || *e == '+')) { e_neg = (*e == '-'); e++; }
+        if (e < end && is_digit(*e)) {
+            while (e < end && is_digit(*e)) { if (e_val < 10000) e_val = e_val * 10 + (*e - '0'); e++; }
+            exponent += e_neg ? -e_val : e_val;
+            p = e;
+        }
+    }
+
+    // Exact for up to 15 significant digits and |exponent| <= 22 (Clinger's fast path)
+    double value = (double)mantissa;
+    if (exponent < 0 && exponent >= -22) value /= pow10_table[-exponent];
+    else if (exponent != 0) value *= pow10_int(exponent);
+
+    *out = (float)(neg ? -value : value);
+    return p;
+}
+
+static inline const char* parse_int(const char *p, const char *end, int32_t *out) {
+    int neg = 0;
+    if (p < end && (*p == '-' || *p == '+')) { neg = (*p == '-'); p++; }
+    int32_t v = 0;
+    while (p < end && is_digit(*p)) { v = v * 10 + (*p - '0'); p++; }
+    *out = neg ? -v : v;
+    return p;
+}
+
+// Converts a 1-based (or negative, relative) OBJ index to 0-based
+static inline int32_t resolve_index(int32_t idx, size_t count) {
+    if (idx > 0) return idx - 1;
+    if (idx < 0) return (int32_t)count + idx;
+    return OBJ_NO_INDEX;
+}
+
+/* --- 3. DEDUPLICATION --- */
+// The three indices are combined with odd multipliers, then mixed with
+// murmur3's fmix32 so that similar triples spread over the whole table.
+// The table keeps at least two slots per key.
+static inline uint32_t obj_key_hash(ObjKey k) {
+    uint32_t h = (uint32_t)k.p * 0x9E3779B1u ^ (uint32_t)k.t * 0x85EBCA77u ^ (uint32_t)k.n * 0xC2B2AE3Du;
+    h ^= h >> 16; h *= 0x85EBCA6Bu;
+    h ^= h >> 13; h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
+static void dedup_init(ObjDedupTable *t, size_t expected) {
+    size_t cap = 1024;
+    while (cap < expected * 2) cap <<= 1;
+    t->slots = malloc(cap * sizeof(ObjSlot));
+    if (!t->slots) { fprintf(stderr, "Out of memory\n"); exit(1); }
+    for (size_t i = 0; i < cap; i++) t->slots[i].index = OBJ_EMPTY_SLOT;
+    t->mask = cap - 1;
+    t->count = 0;
+}
+
+static void dedup_grow(ObjDedupTable *t) {
+    ObjSlot *old = t->slots;
+    size_t old_cap = t->mask + 1;
+    dedup_init(t, old_cap);
+    for (size_t i = 0; i < old_cap; i++) {
+        if (old[i].index == OBJ_EMPTY_SLOT) continue;
+        size_t s = obj_key_hash(old[i].key) & t->mask;
+        while (t->slots[s].index != OBJ_EMPTY_SLOT) s = (s + 1) & t->mask;
+        t->slots[s] = old[i];
+        t->count++;
+    }
+    free(old);
+}
+
+// Returns the final vertex index for key; new keys get next_index
+static inline uint32_t dedup_insert(ObjDedupTable *t, ObjKey key, uint32_t next_index, int *inserted) {
+    if ((t->count + 1) * 2 > t->mask + 1) dedup_grow(t);
+    size_t s = obj_key_hash(key) & t->mask;
+    while (t->slots[s].index != OBJ_EMPTY_SLOT) {
+        ObjKey k = t->slots[s].key;
+        if (k.p == key.p && k.t == key.t && k.n == key.n) { *inserted = 0; return t->slots[s].index; }
+        s = (s + 1) & t->mask;
+    }
+    t->slots[s].key = key;
+    t->slots[s].index = next_index;
+    t->count++;
+    *inserted = 1;
+    return next_index;
+}
+
+/* --- 4. RECORD PARSING (shared by the serial and parallel paths) --- */
+typedef struct {
+    size_t v, vt, vn, f;
+} ObjCounts;
+
+typedef struct {
+    vec3 *pos;
+    vec2 *uv;
+    vec3 *norm;
+} ObjPools;
+
+typedef enum { OBJ_RECORD_OTHER, OBJ_RECORD_V, OBJ_RECORD_VT, OBJ_RECORD_VN, OBJ_RECORD_F } ObjRecord;
+
+static inline ObjRecord classify_record(const char *p, const char *end) {
+    if (p + 1 >= end) return OBJ_RECORD_OTHER;
+    if (p[0] == 'v') {
+        if (is_space(p[1])) return OBJ_RECORD_V;
+        if (p[1] == 't') return OBJ_RECORD_VT;
+        if (p[1] == 'n') return OBJ_RECORD_VN;
+    } else if (p[0] == 'f' && is_space(p[1])) {
+        return OBJ_RECORD_F;
+    }
+    return OBJ_RECORD_OTHER;
+}
+
+static ObjCounts obj_count_records(const char *p, const char *end) {
+    ObjCounts c = {0};
+    while (p < end) {
+        p = skip_space(p, end);
+        switch (classify_record(p, end)) {
+            case OBJ_RECORD_V:  c.v++;  break;
+            case OBJ_RECORD_VT: c.vt++; break;
+            case OBJ_RECORD_VN: c.vn++; break;
+            case OBJ_RECORD_F:  c.f++;  break;
+            default: break;
+        }
+        p = skip_line(p, end);
+    }
+    return c;
+}
+
+static inline const char* parse_vec3(const char *p, const char *end, vec3 *out) {
+    vec3 v = {0};
+    p = parse_float(skip_space(p + 2, end), end, &v.x);
+    p = parse_float(skip_space(p, end), end, &v.y);
+    p = parse_float(skip_space(p, end), end, &v.z);
+    *out = v;
+    return p;
+}
+
+static inline const char* parse_vec2(const char *p, const char *end, vec2 *out) {
+    vec2 v = {0};
+    p = parse_float(skip_space(p + 2, end), end, &v.x);
+    p = parse_float(skip_space(p, end), end, &v.y);
+    *out = v;
+    return p;
+}
+
+// Parses one "v[/vt][/vn]" face corner. Counts are the number of records seen
+// so far, which anchors negative indices. Returns 0 at the end of the face.
+static inline int parse_corner(const char **pp, const char *end, ObjCounts seen, ObjKey *out) {
+    const char *p = skip_space(*pp, end);
+    *pp = p;
+    if (p >= end || *p == '\n' || *p == '#') return 0;
+
+    int32_t vi = 0, ti = 0, ni = 0;
+    const char *tok = p;
+    p = parse_int(p, end, &vi);
+    if (p < end && *p == '/') {
+        p++;
+        if (p < end && *p != '/') p = parse_int(p, end, &ti);
+        if (p < end && *p == '/') p = parse_int(p + 1, end, &ni);
+    }
+    *pp = p;
+    if (p == tok) return 0; // Malformed token, drop the rest of the line
+
+    ObjKey key = { resolve_index(vi, seen.v), resolve_index(ti, seen.vt), resolve_index(ni, seen.vn) };
+    if (key.p < 0 || key.p >= (int32_t)seen.v)  key.p = OBJ_NO_INDEX;
+    if (key.t < 0 || key.t >= (int32_t)seen.vt) key.t = OBJ_NO_INDEX;
+    if (key.n < 0 || key.n >= (int32_t)seen.vn) key.n = OBJ_NO_INDEX;
+    *out = key;
+    return 1;
+}
+
+static void* obj_alloc(size_t bytes) {
+    void *ptr = malloc(bytes ? bytes : 1);
+    if (!ptr) { fprintf(stderr, "Out of memory\n"); exit(1); }
+    return ptr;
+}
+
+static void* obj_grow(void *ptr, size_t *cap, size_t needed, size_t elem) {
+    if (needed <= *cap) return ptr;
+    while (*cap < needed) *cap = *cap ? *cap * 2 : 256;
+    ptr = realloc(ptr, *cap * elem);
+    if (!ptr) { fprintf(stderr, "Out of memory\n"); exit(1); }
+    return ptr;
+}
+
+static void mesh_alloc_vertices(Mesh *mesh, size_t vc) {
+    mesh->vertex_count = vc;
+    mesh->p_x = obj_alloc(vc * sizeof(float)); mesh->p_y = obj_alloc(vc * sizeof(float)); mesh->p_z = obj_alloc(vc * sizeof(float));
+    mesh->n_x = obj_alloc(vc * sizeof(float)); mesh->n_y = obj_alloc(vc * sizeof(float)); mesh->n_z = obj_alloc(vc * sizeof(float));
+    mesh->u   = obj_alloc(vc * sizeof(float)); mesh->v   = obj_alloc(vc * sizeof(float));
+    mesh->colors = obj_alloc(vc * sizeof(uint32_t));
+}
+
+// Writes the attributes of keys[0..count) to the SoA arrays starting at base
+static void fill_vertices(Mesh *mesh, const ObjPools *pools, ObjKey *keys, size_t count, size_t base) {
+    for (size_t i = 0; i < count; i++) {
+        ObjKey k = keys[i];
+        vec3 pos = (k.p >= 0) ? pools->pos[k.p] : (vec3){0, 0, 0};
+        vec3 n   = (k.n >= 0) ? pools->norm[k.n] : (vec3){0, 0, 0};
+        vec2 uv  = (k.t >= 0) ? pools->uv[k.t] : (vec2){0, 0};
+        size_t o = base + i;
+        mesh->p_x[o] = pos.x; mesh->p_y[o] = pos.y; mesh->p_z[o] = pos.z;
+        mesh->n_x[o] = n.x;   mesh->n_y[o] = n.y;   mesh->n_z[o] = n.z;
+        mesh->u[o] = uv.x;    mesh->v[o] = uv.y;
+        mesh->colors[o] = 0xFFFFFFFF;
+    }
+}
+
+/* --- 5. SERIAL PARSER --- */
+static Mesh parse_obj_serial(const ObjFile *file) {
+    Mesh mesh = {0};
+    const char *p = file->data, *end = file->data + file->size;
+    ObjCounts counts = obj_count_records(p, end);
+
+    // --- RAW DATA POOLS (sized exactly by the pre-scan) ---
+    ObjPools pools = {
+        obj_alloc(counts.v * sizeof(vec3)), obj_alloc(counts.vt * sizeof(vec2)), obj_alloc(counts.vn * sizeof(vec3))
+    };
+    ObjCounts seen = {0};
+
+    // Triangles are the common case; n-gons grow the arrays geometrically
+    size_t idx_cap = counts.f * 3, idx_count = 0;
+    size_t key_cap = MAX(counts.v, MAX(counts.vt, counts.vn)) + 16, key_count = 0;
+    uint32_t *indices = obj_alloc(idx_cap * sizeof(uint32_t));
+    ObjKey   *keys = obj_alloc(key_cap * sizeof(ObjKey));
+
+    ObjDedupTable table;
+    dedup_init(&table, key_cap);
+
+    while (p < end) {
+        p = skip_space(p, end);
+        switch (classify_record(p, end)) {
+            case OBJ_RECORD_V:  p = parse_vec3(p, end, &pools.pos[seen.v++]);  break;
+            case OBJ_RECORD_VT: p = parse_vec2(p, end, &pools.uv[seen.vt++]);  break;
+            case OBJ_RECORD_VN: p = parse_vec3(p, end, &pools.norm[seen.vn++]); break;
+            case OBJ_RECORD_F: {
+                p += 2;
+                uint32_t first = 0, prev = 0;
+                ObjKey key;
+                for (int corner = 0; parse_corner(&p, end, seen, &key); corner++) {
+                    int inserted;
+                    uint32_t idx = dedup_insert(&table, key, (uint32_t)key_count, &inserted);
+                    if (inserted) {
+                        keys = obj_grow(keys, &key_cap, key_count + 1, sizeof(ObjKey));
+                        keys[key_count++] = key;
+                    }
+
+                    // Fan triangulation: (first, prev, current)
+                    if (corner == 0) first = idx;
+                    else if (corner >= 2) {
+                        indices = obj_grow(indices, &idx_cap, idx_count + 3, sizeof(uint32_t));
+                        indices[idx_count++] = first;
+                        indices[idx_count++] = prev;
+                        indices[idx_count++] = idx;
+                    }
+                    prev = idx;
+                }
+                break;
+            }
+            default: break;
+        }
+        p = skip_line(p, end);
+    }
+
+    // --- FINAL MESH BUFFERS (SoA), allocated once at the exact size ---
+    mesh_alloc_vertices(&mesh, key_count);
+    fill_vertices(&mesh, &pools, keys, key_count, 0);
+    mesh.index_count = idx_count;
+    mesh.indices = indices;
+
+    // --- AUTO-CALCULATE NORMALS IF MISSING ---
+    if (seen.vn == 0 && mesh.index_count > 0) {
+        mesh_calculate_normals(&mesh);
+    }
+
+    free(pools.pos); free(pools.uv); free(pools.norm);
+    free(keys); free(table.slots);
+    return mesh;
+}
+
+/* --- 6. PARALLEL PARSER --- */
+// Phases, each run on every thread and joined before the next:
+//   A. count records per line-aligned chunk  -> prefix sums give global v/vt/vn bases
+//   B. parse chunks into the global pools and per-chunk triangulated corner keys
+//   C. dedup corners, sharded by position block  -> prefix sums give shard vertex bases;
+//      parsing buckets each chunk's corners by shard, so a shard only reads its own
+//   D. fill the SoA arrays per shard and the index buffer per chunk
+
+#define OBJ_MAX_THREADS      16
+#define OBJ_SHARD_BLOCK_BITS 12
+
+typedef struct {
+    const char *begin, *end;
+    ObjCounts   counts, base;
+    ObjKey     *corners;
+    size_t      corner_count, corner_cap;
+    size_t      index_base;
+    uint32_t   *buckets[OBJ_MAX_THREADS];   // Per shard: offsets of its corners, in file order
+    size_t      bucket_count[OBJ_MAX_THREADS], bucket_cap[OBJ_MAX_THREADS];
+} ObjChunk;
+
+typedef struct {
+    ObjDedupTable table;
+    ObjKey       *keys;
+    size_t        key_count, key_cap;
+    size_t        vertex_base;
+} ObjShard;
+
+typedef struct {
+    ObjChunk *chunks;
+    ObjShard *shards;
+    int       count;        // Chunks, shards and threads are one to one
+    ObjPools  pools;
+    uint32_t *corner_local; // Per corner: vertex index local to its shard
+    size_t    expected_vertices;
+    Mesh     *mesh;
+} ObjParallelJob;
+
+typedef void (*ObjPhase)(ObjParallelJob *job, int index);
+typedef struct { ObjParallelJob *job; ObjPhase phase; int index; } ObjTask;
+
+static inline int shard_of(ObjKey key, int shard_count) {
+    return (int)(((uint32_t)key.p >> OBJ_SHARD_BLOCK_BITS) % (uint32_t)shard_count);
+}
+
+static void* obj_task_entry(void *data) {
+    ObjTask *task = data;
+    task->phase(task->job, task->index);
+    return NULL;
+}
+
+// Chunks whose thread cannot be started run on the calling thread instead
+static void run_phase(ObjParallelJob *job, ObjPhase phase) {
+    pthread_t threads[OBJ_MAX_THREADS];
+    ObjTask tasks[OBJ_MAX_THREADS];
+    int started[OBJ_MAX_THREADS] = { 0 };
+    for (int i = 1; i < job->count; i++) {
+        tasks[i] = (ObjTask){ job, phase, i };
+        started[i] = pthread_create(&threads[i], NULL, obj_task_entry, &tasks[i]) == 0;
+        if (!started[i]) phase(job, i);
+    }
+    phase(job, 0);
+    for (int i = 1; i < job->count; i++) {
+        if (started[i]) pthread_join(threads[i], NULL);
+    }
+}
+
+static void phase_count(ObjParallelJob *job, int i) {
+    ObjChunk *c = &job->chunks[i];
+    c->counts = obj_count_records(c->begin, c->end);
+}
+
+static inline void chunk_push_corner(ObjChunk *c, ObjKey key, int shard_count) {
+    int s = shard_of(key, shard_count);
+    c->buckets[s] = obj_grow(c->buckets[s], &c->bucket_cap[s], c->bucket_count[s] + 1, sizeof(uint32_t));
+    c->buckets[s][c->bucket_count[s]++] = (uint32_t)c->corner_count;
+    c->corners[c->corner_count++] = key;
+}
+
+static void phase_parse(ObjParallelJob *job, int i) {
+    ObjChunk *c = &job->chunks[i];
+    const char *p = c->begin, *end = c->end;
+    ObjCounts seen = c->base; // Global counts at the start of this chunk
+    c->corner_cap = c->counts.f * 3;
+    c->corners = obj_alloc(c->corner_cap * sizeof(ObjKey));
+
+    while (p < end) {
+        p = skip_space(p, end);
+        switch (classify_record(p, end)) {
+            case OBJ_RECORD_V:  p = parse_vec3(p, end, &job->pools.pos[seen.v++]);  break;
+            case OBJ_RECORD_VT: p = parse_vec2(p, end, &job->pools.uv[seen.vt++]);  break;
+            case OBJ_RECORD_VN: p = parse_vec3(p, end, &job->pools.norm[seen.vn++]); break;
+            case OBJ_RECORD_F: {
+                p += 2;
+                ObjKey first = {0}, prev = {0}, key;
+                for (int corner = 0; parse_corner(&p, end, seen, &key); corner++) {
+                    if (corner == 0) first = key;
+                    else if (corner >= 2) {
+                        c->corners = obj_grow(c->corners, &c->corner_cap, c->corner_count + 3, sizeof(ObjKey));
+                        chunk_push_corner(c, first, job->count);
+                        chunk_push_corner(c, prev, job->count);
+                        chunk_push_corner(c, key, job->count);
+                    }
+                    prev = key;
+                }
+                break;
+            }
+            default: break;
+        }
+        p = skip_line(p, end);
+    }
+}
+
+static void phase_dedup(ObjParallelJob *job, int s) {
+    ObjShard *shard = &job->shards[s];
+    shard->key_cap = job->expected_vertices / job->count + 256;
+    shard->keys = obj_alloc(shard->key_cap * sizeof(ObjKey));
+    dedup_init(&shard->table, shard->key_cap);
+
+    // Every shard walks its corners in file order, so local indices follow first use
+    for (int c = 0; c < job->count; c++) {
+        const ObjChunk *chunk = &job->chunks[c];
+        uint32_t *local = &job->corner_local[chunk->index_base];
+        for (size_t b = 0; b < chunk->bucket_count[s]; b++) {
+            uint32_t k = chunk->buckets[s][b];
+            ObjKey key = chunk->corners[k];
+            int inserted;
+            local[k] = dedup_insert(&shard->table, key, (uint32_t)shard->key_count, &inserted);
+            if (inserted) {
+                shard->keys = obj_grow(shard->keys, &shard->key_cap, shard->key_count + 1, sizeof(ObjKey));
+                shard->keys[shard->key_count++] = key;
+            }
+        }
+    }
+}
+
+static void phase_finalize(ObjParallelJob *job, int i) {
+    ObjShard *shard = &job->shards[i];
+    fill_vertices(job->mesh, &job->pools, shard->keys, shard->key_count, shard->vertex_base);
+
+    const ObjChunk *chunk = &job->chunks[i];
+    const uint32_t *local = &job->corner_local[chunk->index_base];
+    uint32_t *out = &job->mesh->indices[chunk->index_base];
+    for (int s = 0; s < job->count; s++) {
+        uint32_t base = (uint32_t)job->shards[s].vertex_base;
+        for (size_t b = 0; b < chunk->bucket_count[s]; b++) {
+            uint32_t k = chunk->buckets[s][b];
+            out[k] = base + local[k];
+        }
+    }
+}
+
+static Mesh parse_obj_parallel(const ObjFile *file, int thread_count) {
+    Mesh mesh = {0};
+    ObjParallelJob job = {0};
+    job.count = CLAMP(thread_count, 1, OBJ_MAX_THREADS);
+    job.chunks = calloc(job.count, sizeof(ObjChunk));
+    job.shards = calloc(job.count, sizeof(ObjShard));
+    job.mesh = &mesh;
+
+    // Line-aligned chunks of roughly equal size
+    const char *cursor = file->data, *end = file->data + file->size;
+    for (int i = 0; i < job.count; i++) {
+        const char *split = (i == job.count - 1) ? end : file->data + file->size * (size_t)(i + 1) / job.count;
+        if (split < cursor) split = cursor;
+        if (split < end) split = skip_line(split, end);
+        job.chunks[i].begin = cursor;
+        job.chunks[i].end = split;
+        cursor = split;
+    }
+
+    run_phase(&job, phase_count);
+
+    ObjCounts total = {0};
+    for (int i = 0; i < job.count; i++) {
+        job.chunks[i].base = total;
+        total.v += job.chunks[i].counts.v;   total.vt += job.chunks[i].counts.vt;
+        total.vn += job.chunks[i].counts.vn; total.f += job.chunks[i].counts.f;
+    }
+    job.pools.pos  = obj_alloc(total.v * sizeof(vec3));
+    job.pools.uv   = obj_alloc(total.vt * sizeof(vec2));
+    job.pools.norm = obj_alloc(total.vn * sizeof(vec3));
+    job.expected_vertices = MAX(total.v, MAX(total.vt, total.vn));
+
+    run_phase(&job, phase_parse);
+
+    size_t index_count = 0;
+    for (int i = 0; i < job.count; i++) {
+        job.chunks[i].index_base = index_count;
+        index_count += job.chunks[i].corner_count;
+    }
+    job.corner_local = obj_alloc(index_count * sizeof(uint32_t));
+
+    run_phase(&job, phase_dedup);
+
+    size_t vertex_count = 0;
+    for (int s = 0; s < job.count; s++) {
+        job.shards[s].vertex_base = vertex_count;
+        vertex_count += job.shards[s].key_count;
+    }
+    mesh_alloc_vertices(&mesh, vertex_count);
+    mesh.index_count = index_count;
+    mesh.indices = obj_alloc(index_count * sizeof(uint32_t));
+
+    run_phase(&job, phase_finalize);
+
+    if (total.vn == 0 && mesh.index_count > 0) {
+        mesh_calculate_normals(&mesh);
+    }
+
+    for (int i = 0; i < job.count; i++) {
+        free(job.chunks[i].corners);
+        for (int s = 0; s < job.count; s++) free(job.chunks[i].buckets[s]);
+        free(job.shards[i].keys); free(job.shards[i].table.slots);
+    }
+    free(job.chunks); free(job.shards); free(job.corner_local);
+    free(job.pools.pos); free(job.pools.uv); free(job.pools.norm);
+    return mesh;
+}
+
+/* --- 7. ENTRY POINTS --- */
+static int obj_default_threads(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return (int)CLAMP(cores, 1, OBJ_MAX_THREADS);
+}
+
+Mesh mesh_parse_obj_parallel(const char *filename, int thread_count) {
+    ObjFile file;
+    if (obj_file_open(filename, &file) != 0) {
+        fprintf(stderr, "Failed to open OBJ file: %s\n", filename);
+        return (Mesh){0};
+    }
+    if (thread_count <= 0) thread_count = obj_default_threads();
+    Mesh mesh = thread_count > 1 ? parse_obj_parallel(&file, thread_count) : parse_obj_serial(&file);
+    obj_file_close(&file);
+    return mesh;
+}
+
+Mesh mesh_parse_obj(const char *filename) {
+    ObjFile file;
+    if (obj_file_open(filename, &file) != 0) {
+        fprintf(stderr, "Failed to open OBJ file: %s\n", filename);
+        return (Mesh){0};
+    }
+    int threads = obj_default_threads();
+    Mesh mesh = (threads > 1 && file.size >= OBJ_PARALLEL_MIN_BYTES)
+        ? parse_obj_parallel(&file, threads)
+        : parse_obj_serial(&file);
+    obj_file_close(&file);
+    return mesh;
+}
@@ -0,0 +1,127 @@
+#include "postfx.h"
+
+typedef struct { f32x8 r, g, b; } Rgb8;
+
+/* --- 1. ROW ACCESS --- */
+
+// Pixels x..x+7 of a row; those outside lo..hi-1 repeat the nearest one inside.
+// Tile passes clamp to their own tile, which no other thread is writing.
+static inline Rgb8 row_load8(const uint32_t *row, int x, int lo, int hi) {
+    u32x8 c;
+    if (x >= lo && x + 8 <= hi) {
+        c = u32x8_load(row + x);
+    } else {
+        for (int i = 0; i < 8; i++) c[i] = row[CLAMP(x + i, lo, hi - 1)];
+    }
+    Rgb8 p;
+    f32x8_from_rgba8(c, &p.r, &p.g, &p.b);
+    return p;
+}
+
+static inline void row_store8(uint32_t *row, int x, int n, Rgb8 p) {
+    u32x8 c = f32x8_to_rgba8(p.r, p.g, p.b);
+    if (n == 8) {
+        u32x8_store(row + x, c);
+    } else {
+        for (int i = 0; i < n; i++) row[x + i] = c[i];
+    }
+}
+
+/* --- 2. TILE PASSES --- */
+
+void post_grade(const uint32_t *src, uint32_t *dst, int width, int height, TileRange rect, void *params) {
+    const PostGrade *g = params;
+    const f32x8 lane = { 0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f };
+    float cx = 0.5f * (float)width, cy = 0.5f * (float)height;
+
+    for (int y = rect.y0; y < rect.y1; y++) {
+        const uint32_t *in = &src[(size_t)y * width];
+        uint32_t *out = &dst[(size_t)y * width];
+        float dy = ((float)y + 0.5f - cy) / cy;
+        for (int x = rect.x0; x < rect.x1; x += 8) {
+            Rgb8 p = row_load8(in, x, rect.x0, rect.x1);
+            p.r *= g->exposure; p.g *= g->exposure; p.b *= g->exposure;
+
+            f32x8 luma = 0.2126f * p.r + 0.7152f * p.g + 0.0722f * p.b;
+            p.r = luma + (p.r - luma) * g->saturation;
+            p.g = luma + (p.g - luma) * g->saturation;
+            p.b = luma + (p.b - luma) * g->saturation;
+
+            p.r = (p.r - 0.5f) * g->contrast + 0.5f;
+            p.g = (p.g - 0.5f) * g->contrast + 0.5f;
+            p.b = (p.b - 0.5f) * g->contrast + 0.5f;
+
+            // Squared distance from the centre, 1 in the corners
+            f32x8 dx = ((float)x + 0.5f - cx + lane) / cx;
+            f32x8 v = 1.0f - g->vignette * 0.5f * (dx * dx + dy * dy);
+            p.r *= v; p.g *= v; p.b *= v;
+            row_store8(out, x, MIN(8, rect.x1 - x), p);
+        }
+    }
+}
+
+/* --- 3. HALO PASSES --- */
+
+void post_sharpen(const uint32_t *src, uint32_t *dst, int width, int height, TileRange rect, void *params) {
+    float amount = ((const PostSharpen*)params)->amount;
+    for (int y = rect.y0; y < rect.y1; y++) {
+        const uint32_t *up = &src[(size_t)MAX(y - 1, 0) * width];
+        const uint32_t *mid = &src[(size_t)y * width];
+        const uint32_t *down = &src[(size_t)MIN(y + 1, height - 1) * width];
+        uint32_t *out = &dst[(size_t)y * width];
+        for (int x = rect.x0; x < rect.x1; x += 8) {
+            Rgb8 c = row_load8(mid, x, 0, width);
+            Rgb8 l = row_load8(mid, x - 1, 0, width), r = row_load8(mid, x + 1, 0, width);
+            Rgb8 u = row_load8(up, x, 0, width), d = row_load8(down, x, 0, width);
+            c.r += amount * (4.0f * c.r - l.r - r.r - u.r - d.r);
+            c.g += amount * (4.0f * c.g - l.g - r.g - u.g - d.g);
+            c.b += amount * (4.0f * c.b - l.b - r.b - u.b - d.b);
+            row_store8(out, x, MIN(8, rect.x1 - x), c);
+        }
+    }
+}
+
+#define BLOOM_RADIUS 2
+#define BLOOM_TAPS   (2 * BLOOM_RADIUS + 1)
+
+// Horizontal sum of what exceeds the threshold around pixels x..x+7 of row y
+static inline Rgb8 bloom_row(const uint32_t *src, int width, int height, int x, int y, float threshold) {
+    const f32x8 zero = f32x8_splat(0.0f);
+    const uint32_t *row = &src[(size_t)CLAMP(y, 0, height - 1) * width];
+    Rgb8 sum = { zero, zero, zero };
+    for (int i = -BLOOM_RADIUS; i <= BLOOM_RADIUS; i++) {
+        Rgb8 p = row_load8(row, x + i, 0, width);
+        sum.r += f32x8_max(p.r - threshold, zero);
+        sum.g += f32x8_max(p.g - threshold, zero);
+        sum.b += f32x8_max(p.b - threshold, zero);
+    }
+    return sum;
+}
+
+// Walks down 8-pixel columns keeping the last BLOOM_TAPS row sums, so each
+// output adds one row and drops one instead of summing the whole box
+void post_bloom(const uint32_t *src, uint32_t *dst, int width, int height, TileRange rect, void *params) {
+    const PostBloom *b = params;
+    const f32x8 zero = f32x8_splat(0.0f);
+    const float weight = b->intensity / (float)(BLOOM_TAPS * BLOOM_TAPS);
+
+    for (int x = rect.x0; x < rect.x1; x += 8) {
+        Rgb8 rows[BLOOM_TAPS], box = { zero, zero, zero };
+        for (int j = 0; j < BLOOM_TAPS - 1; j++) {
+            rows[j] = bloom_row(src, width, height, x, rect.y0 - BLOOM_RADIUS + j, b->threshold);
+            box.r += rows[j].r; box.g += rows[j].g; box.b += rows[j].b;
+        }
+        for (int y = rect.y0; y < rect.y1; y++) {
+            Rgb8 *next = &rows[(y - rect.y0 + BLOOM_TAPS - 1) % BLOOM_TAPS];
+            *next = bloom_row(src, width, height, x, y + BLOOM_RADIUS, b->threshold);
+            box.r += next->r; box.g += next->g; box.b += next->b;
+
+            Rgb8 c = row_load8(&src[(size_t)y * width], x, 0, width);
+            c.r += box.r * weight; c.g += box.g * weight; c.b += box.b * weight;
+            row_store8(&dst[(size_t)y * width], x, MIN(8, rect.x1 - x), c);
+
+            const Rgb8 *oldest = &rows[(y - rect.y0) % BLOOM_TAPS];
+            box.r -= oldest->r; box.g -= oldest->g; box.b -= oldest->b;
+        }
+    }
+}
@@ -1,5 +1,6 @@
 #include "renderer.h"
 #include "shader.h"
+#include "frustum.h"
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
@@ -7,10 +8,71 @@
 #define STARTING_TRI_CAP 8192
 #define STARTING_DRAW_CAP 256
 #define INITIAL_UNIFORM_POOL_SIZE (1024 * 1024) 
+#define NEAR_PLANE_W 0.1f // Vertices with a smaller clip w are dropped with their triangles
+#define OIT_STARTING_FRAGS 4096
+#define TONEMAP_LUT_SIZE 4096
+#define TEMPORAL_MAX_OFFSET 0.125f   // Pixels a reprojected point may land from the centre it was shaded at
+#define TEMPORAL_DEPTH_TOLERANCE 0.002f   // Of the distance, between the reprojected and the cached depth
+#define TEMPORAL_REFRESH_SHIFT 4     // Pixels come up for refresh in 16x16 blocks, so batches mostly reuse or shade whole
 
 static void* renderer_worker_thread(void* data);
 static inline float edge_func(float ax, float ay, float bx, float by, float px, float py);
-static void rasterize_triangle_in_tile(Renderer *r, Triangle *t, Tile *tile);
+
+typedef struct RasterSetup RasterSetup;
+typedef struct BatchState BatchState;
+
+// Transparent fragments of one tile as per-pixel linked lists in a growable
+// arena. Each thread owns its arena and a tile is rasterized by one thread,
+// so no atomics are needed; lists are newest first. RGBA8888 colours carry
+// their alpha in the low byte as well; R11G11B10 ones have no room for it.
+typedef struct { float z; uint32_t color; int32_t next; uint8_t alpha; } OitFragment;
+
+struct OitArena {
+    int32_t     *heads;             // Per pixel of the tile, -1 when empty
+    OitFragment *frags;
+    size_t       count, capacity;
+    int          x0, y0, width;     // Tile the heads cover
+};
+
+// Samples of one tile, pixel-major: the samples of a pixel are adjacent so
+// its depth test is one SIMD compare and its resolve one cache line
+struct MsaaTile {
+    float    *depth;
+    uint32_t *color;
+    int       x0, y0, width;        // Tile being rasterized
+};
+
+// Rotated grid in sixteenths of a pixel from the centre, as D3D's standard 4x pattern
+static const int msaa_positions[MSAA_SAMPLES][2] = { { -2, -6 }, { 6, -2 }, { -6, 2 }, { 2, 6 } };
+
+// One frame of per-pixel opaque shading, for the frame after to reuse
+typedef struct {
+    uint32_t *color;                // Shader output, before blending, resolve and tonemapping
+    uint32_t *key;                  // Key of the draw last written there, 0 for none
+    uint32_t *prim;                 // Its triangle's prim_id
+    float    *depth;                // Its clip w, which is linear where z is not
+    uint8_t  *age;                  // Frames since the colour was shaded
+    mat4      view_proj;
+} TemporalFrame;
+
+// Written by process_tile into frames[current], read from the other one;
+// renderer_reset swaps them
+struct TemporalCache {
+    TemporalFrame frames[2];
+    int           current;
+    int           prev_valid;       // The other frame was rasterized with reuse on
+    int           written;          // renderer_rasterize ran since the last swap
+    uint32_t      frame;            // Picks the pixels due for a refresh
+};
+
+// Pipeline state is resolved once per draw call to kernels compiled for it,
+// so cull, depth and blend never branch per triangle or per pixel
+struct PipelineKernels {
+    void (*assemble)(Renderer *r, int dc_idx, int thread);
+    void (*raster)(Renderer *r, Triangle *t, BatchState *bs, const RasterSetup *s, int thread);
+    void (*flush)(Renderer *r, BatchState *bs, int thread);
+};
+static const PipelineKernels* pipeline_kernels_get(CullMode cull, DepthMode depth, BlendMode blend, int depth_only, int msaa);
 
 /* --- 1. GEOMETRY & MATH HELPERS --- */
 BoundingBox calculate_triangle_bbox(const Triangle *t) {
@@ -32,11 +94,15 @@ static inline void* get_dc_uniforms(Renderer *r, DrawCall *dc) {
 
 /* --- 2. INTERNAL SYNCHRONIZATION --- */
 static void wait_for_workers(Renderer *r) {
+    STATS_TIMER_BEGIN(t_wait);
+    TRACE_BEGIN(tr_wait);
     pthread_mutex_lock(&r->lock);
     while (r->active_workers > 0) {
         pthread_cond_wait(&r->done_working, &r->lock);
     }
     pthread_mutex_unlock(&r->lock);
+    STATS_TIMER_END(r, 0, STAT_TIME_WAIT, t_wait);
+    TRACE_END(r, 0, TRACE_WAIT, 0, tr_wait);
 }
 
 static void signal_workers(Renderer *r, RenderStage stage) {
@@ -47,51 +113,165 @@ static void signal_workers(Renderer *r, RenderStage stage) {
 }
 
 /* --- 3. BATCH GEOMETRY EXECUTION --- */
-static void process_draw_call_vertices(Renderer *r, int dc_idx) {
+// Depth-only draws (no fragment shader) skip the attribute divide
+static inline void shade_vertex(Renderer *r, DrawCall *dc, void *uniforms, size_t i) {
+    Vertex *out = &r->vertex_scratch[dc->vertex_offset + i];
+    dc->vertex_shader((int)i, dc->mesh, out, uniforms);
+
+    if (out->w >= NEAR_PLANE_W) {
+        float inv_w = 1.0f / out->w;
+        out->x = (out->x * inv_w + 1.0f) * 0.5f * (float)r->screen_width;
+        out->y = (1.0f - out->y * inv_w) * 0.5f * (float)r->screen_height;
+        out->z = out->z * inv_w * 0.5f + 0.5f;
+        out->w = inv_w;
+        if (!dc->fragment_shader) return;
+
+        out->world_pos.x *= inv_w; out->world_pos.y *= inv_w; out->world_pos.z *= inv_w;
+        out->nx *= inv_w; out->ny *= inv_w; out->nz *= inv_w;
+        out->u *= inv_w; out->v *= inv_w;
+    } else {
+        out->w = -1.0f; 
+    }
+}
+
+// Frustum and normal-cone rejection of whole meshlets; fills meshlet_visible
+// for the draw call and returns the number of meshlets that survive.
+static size_t cull_meshlets(Renderer *r, DrawCall *dc, const Uniforms *u, int thread) {
+    const Mesh *mesh = dc->mesh;
+    uint8_t *visible = &r->meshlet_visible[dc->meshlet_offset];
+    STATS_ONLY(uint64_t culled_frustum = 0, culled_back = 0;)
+
+    // Object-space planes; near becomes w >= NEAR_PLANE_W like the assembler, far is left to the depth test
+    Frustum frustum;
+    frustum_from_matrix(&frustum, u->mvp);
+    vec4 w_plane = { u->mvp.m[0][3], u->mvp.m[1][3], u->mvp.m[2][3], u->mvp.m[3][3] - NEAR_PLANE_W };
+    float w_len = sqrtf(w_plane.x * w_plane.x + w_plane.y * w_plane.y + w_plane.z * w_plane.z);
+    if (w_len > 0.0f) w_plane = (vec4){ w_plane.x / w_len, w_plane.y / w_len, w_plane.z / w_len, w_plane.w / w_len };
+    frustum.planes[4] = w_plane;
+    const vec4 *planes = frustum.planes;
+
+    // Cones are tested in world space; the model matrix has uniform scale
+    const mat4 *m = &u->model;
+    float scale = sqrtf(m->m[0][0] * m->m[0][0] + m->m[0][1] * m->m[0][1] + m->m[0][2] * m->m[0][2]);
+    float facing = (dc->cull_mode == CULL_BACK_CCW) ? 1.0f : (dc->cull_mode == CULL_BACK_CW) ? -1.0f : 0.0f;
+
+    size_t kept = 0;
+    for (size_t i = 0; i < mesh->meshlet_count; i++) {
+        const Meshlet *ml = &mesh->meshlets[i];
+        visible[i] = 0;
+
+        int outside = 0;
+        for (int p = 0; p < 5 && !outside; p++) {
+            outside = planes[p].x * ml->center.x + planes[p].y * ml->center.y +
+                      planes[p].z * ml->center.z + planes[p].w < -ml->radius;
+        }
+        if (outside) { STATS_ONLY(culled_frustum++;) continue; }
+
+        if (facing != 0.0f && ml->cone_cutoff < 1.0f) {
+            vec4 c = mat4_mul_vec4(*m, (vec4){ ml->center.x, ml->center.y, ml->center.z, 1.0f });
+            vec4 a = mat4_mul_vec4(*m, (vec4){ ml->cone_axis.x, ml->cone_axis.y, ml->cone_axis.z, 0.0f });
+            vec3 d = { c.x - u->cam_pos.x, c.y - u->cam_pos.y, c.z - u->cam_pos.z };
+            float along = facing * (d.x * a.x + d.y * a.y + d.z * a.z) / scale;
+            if (along >= ml->cone_cutoff * vec3_len(d) + ml->radius * scale) { STATS_ONLY(culled_back++;) continue; }
+        }
+
+        visible[i] = 1;
+        kept++;
+    }
+
+    STATS_ADD(r, thread, meshlets_culled_frustum, culled_frustum);
+    STATS_ADD(r, thread, meshlets_culled_backface, culled_back);
+    (void)thread;
+    return kept;
+}
+
+static void process_draw_call_vertices(Renderer *r, int dc_idx, int thread) {
     DrawCall *dc = &r->draw_calls[dc_idx];
     void* uniforms = get_dc_uniforms(r, dc); 
-    const float near_plane = 0.1f;
-    
-    for (size_t i = 0; i < dc->mesh->vertex_count; i++) {
-        Vertex *out = &r->vertex_scratch[dc->vertex_offset + i];
-        dc->vertex_shader((int)i, dc->mesh, out, uniforms);
-
-        if (out->w >= near_plane) {
-            float inv_w = 1.0f / out->w;
-            out->x = (out->x * inv_w + 1.0f) * 0.5f * (float)r->screen_width;
-            out->y = (1.0f - out->y * inv_w) * 0.5f * (float)r->screen_height;
-            out->z = out->z * inv_w * 0.5f + 0.5f;
-            
-            out->world_pos.x *= inv_w; out->world_pos.y *= inv_w; out->world_pos.z *= inv_w;
-            out->nx *= inv_w; out->ny *= inv_w; out->nz *= inv_w;
-            out->w = inv_w; 
-        } else {
-            out->w = -1.0f; 
+    TRACE_BEGIN(tr_vertex);
+    STATS_ONLY(uint64_t shaded = 0;)
+
+    if (dc->cluster_cull) {
+        const Mesh *mesh = dc->mesh;
+        cull_meshlets(r, dc, uniforms, thread);
+        // Vertices shared by two visible meshlets are shaded twice, which is cheaper than tracking them
+        for (size_t m = 0; m < mesh->meshlet_count; m++) {
+            if (!r->meshlet_visible[dc->meshlet_offset + m]) continue;
+            const Meshlet *ml = &mesh->meshlets[m];
+            const uint32_t *verts = &mesh->meshlet_vertices[ml->vertex_offset];
+            for (uint32_t i = 0; i < ml->vertex_count; i++) shade_vertex(r, dc, uniforms, verts[i]);
+            STATS_ONLY(shaded += ml->vertex_count;)
         }
+    } else {
+        for (size_t i = 0; i < dc->mesh->vertex_count; i++) shade_vertex(r, dc, uniforms, i);
+        STATS_ONLY(shaded = dc->mesh->vertex_count;)
     }
+    STATS_ADD(r, thread, vertices_shaded, shaded);
+    TRACE_END(r, thread, TRACE_VERTEX, dc_idx, tr_vertex);
+    (void)thread;
 }
 
-static void process_draw_call_triangles(Renderer *r, int dc_idx) {
+// Template for the assembly kernels; `cull` is a constant in every instantiation
+static inline __attribute__((always_inline)) void assemble_triangles(Renderer *r, int dc_idx, int thread, const CullMode cull) {
     DrawCall *dc = &r->draw_calls[dc_idx];
     Vertex *v_cache = &r->vertex_scratch[dc->vertex_offset];
+    const float screen_w = (float)r->screen_width, screen_h = (float)r->screen_height;
+    STATS_ONLY(uint64_t culled_near = 0, culled_offscreen = 0, culled_back = 0, culled_zero = 0, assembled = 0;)
+    TRACE_BEGIN(tr_assemble);
 
-    for (size_t i = 0; i < dc->mesh->index_count; i += 3) {
-        Vertex *v0 = &v_cache[dc->mesh->indices[i]];
-        Vertex *v1 = &v_cache[dc->mesh->indices[i+1]];
-        Vertex *v2 = &v_cache[dc->mesh->indices[i+2]];
+    // Without meshlets the whole index buffer is one range
+    const Mesh *mesh = dc->mesh;
+    int use_meshlets = dc->cluster_cull;
+    size_t range_count = use_meshlets ? mesh->meshlet_count : 1;
 
-        if (v0->w < 0 || v1->w < 0 || v2->w < 0) continue;
+    for (size_t m = 0; m < range_count; m++) {
+        size_t begin = 0, end = mesh->index_count;
+        if (use_meshlets) {
+            if (!r->meshlet_visible[dc->meshlet_offset + m]) continue;
+            begin = mesh->meshlets[m].index_offset;
+            end = begin + mesh->meshlets[m].triangle_count * 3;
+        }
 
-        float area = edge_func(v0->x, v0->y, v1->x, v1->y, v2->x, v2->y);
-        if (dc->cull_mode == CULL_BACK_CCW && area <= 0) continue;
-        if (dc->cull_mode == CULL_BACK_CW  && area >= 0) continue;
-        if (fabsf(area) < 0.0001f) continue;
+        for (size_t i = begin; i < end; i += 3) {
+            Vertex *v0 = &v_cache[dc->mesh->indices[i]];
+            Vertex *v1 = &v_cache[dc->mesh->indices[i+1]];
+            Vertex *v2 = &v_cache[dc->mesh->indices[i+2]];
 
-        size_t t_idx = atomic_fetch_add(&r->triangle_count, 1);
-        Triangle *t = &r->triangles[t_idx];
-        t->v[0] = *v0; t->v[1] = *v1; t->v[2] = *v2;
-        t->draw_id = (uint32_t)dc_idx;
+            if (v0->w < 0 || v1->w < 0 || v2->w < 0) { STATS_ONLY(culled_near++;) continue; }
+
+            if (MAX(v0->x, MAX(v1->x, v2->x)) < 0.0f || MIN(v0->x, MIN(v1->x, v2->x)) >= screen_w ||
+                MAX(v0->y, MAX(v1->y, v2->y)) < 0.0f || MIN(v0->y, MIN(v1->y, v2->y)) >= screen_h) {
+                STATS_ONLY(culled_offscreen++;)
+                continue;
+            }
+
+            float area = edge_func(v0->x, v0->y, v1->x, v1->y, v2->x, v2->y);
+            if (cull == CULL_BACK_CCW && area <= 0) { STATS_ONLY(culled_back++;) continue; }
+            if (cull == CULL_BACK_CW  && area >= 0) { STATS_ONLY(culled_back++;) continue; }
+            if (fabsf(area) < 0.0001f) { STATS_ONLY(culled_zero++;) continue; }
+            // The rasterizer only walks positive-area triangles: flip the rest
+            if (cull != CULL_BACK_CCW && area < 0) { Vertex *tmp = v1; v1 = v2; v2 = tmp; }
+
+            size_t t_idx = atomic_fetch_add(&r->triangle_count, 1);
+            Triangle *t = &r->triangles[t_idx];
+            t->v[0] = *v0; t->v[1] = *v1; t->v[2] = *v2;
+            t->draw_id = (uint32_t)dc_idx;
+            t->prim_id = (uint32_t)(i / 3);
+            STATS_ONLY(assembled++;)
+        }
     }
+
+    STATS_ADD(r, thread, triangles_assembled, assembled);
+    STATS_ADD(r, thread, triangles_culled_near, culled_near);
+    STATS_ADD(r, thread, triangles_culled_offscreen, culled_offscreen);
+    STATS_ADD(r, thread, triangles_culled_backface, culled_back);
+    STATS_ADD(r, thread, triangles_culled_zero_area, culled_zero);
+    TRACE_END(r, thread, TRACE_ASSEMBLE, dc_idx, tr_assemble);
+    (void)thread;
+}
+
+static void process_draw_call_triangles(Renderer *r, int dc_idx, int thread) {
+    r->draw_calls[dc_idx].pipeline->assemble(r, dc_idx, thread);
 }
 
 static void renderer_execute_geometry(Renderer *r) {
@@ -100,11 +280,13 @@ static void renderer_execute_geometry(Renderer *r) {
     // 1. Parallel Vertex Transformation
     atomic_store(&r->next_draw_call, 0);
     signal_workers(r, STAGE_VERTEX);
+    STATS_TIMER_BEGIN(t_vertex);
     while (1) {
         int idx = atomic_fetch_add(&r->next_draw_call, 1);
         if (idx >= (int)r->draw_call_count) break;
-        process_draw_call_vertices(r, idx);
+        process_draw_call_vertices(r, idx, 0);
     }
+    STATS_TIMER_END(r, 0, STAT_TIME_VERTEX, t_vertex);
     wait_for_workers(r);
 
     // 2. Pre-allocate triangles safely on Main Thread
@@ -116,11 +298,13 @@ static void renderer_execute_geometry(Renderer *r) {
     // 3. Parallel Triangle Assembly
     atomic_store(&r->next_draw_call, 0);
     signal_workers(r, STAGE_ASSEMBLE);
+    STATS_TIMER_BEGIN(t_assemble);
     while (1) {
         int idx = atomic_fetch_add(&r->next_draw_call, 1);
         if (idx >= (int)r->draw_call_count) break;
-        process_draw_call_triangles(r, idx);
+        process_draw_call_triangles(r, idx, 0);
     }
+    STATS_TIMER_END(r, 0, STAT_TIME_ASSEMBLE, t_assemble);
     wait_for_workers(r);
 }
 
@@ -139,6 +323,11 @@ Renderer* renderer_create(size_t w, size_t h, int threads, int tw, int th) {
     r->uniform_pool_cap = INITIAL_UNIFORM_POOL_SIZE;
     r->uniform_pool = malloc(r->uniform_pool_cap);
 
+    r->cluster_culling = 1;
+    r->batch_shading = 1;
+    r->blend_constant = 1.0f;
+    renderer_set_tonemap(r, 1.0f, 4.0f, 1.0f);
+
     r->tile_width = tw; r->tile_height = th;
     r->tile_count_x = (w + tw - 1) / tw; 
     r->tile_count_y = (h + th - 1) / th;
@@ -151,8 +340,27 @@ Renderer* renderer_create(size_t w, size_t h, int threads, int tw, int th) {
         tile->x0 = tx * tw; tile->y0 = ty * th;
         tile->x1 = MIN((tx + 1) * tw, (int)w); tile->y1 = MIN((ty + 1) * th, (int)h);
         tile->triangle_count = 0;
+        tile->alpha_count = 0;
     }
 
+    r->oit = calloc(threads, sizeof(OitArena));
+    for (int i = 0; i < threads; i++) r->oit[i].heads = malloc((size_t)tw * th * sizeof(int32_t));
+
+#ifdef RENDERER_TRACE
+    r->trace_rings = aligned_alloc(_Alignof(TraceRing), sizeof(TraceRing) * threads);
+    for (int i = 0; i < threads; i++) {
+        atomic_init(&r->trace_rings[i].head, 0);
+        r->trace_rings[i].events = malloc(TRACE_RING_SIZE * sizeof(TraceEvent));
+    }
+    r->trace_enabled = 1;
+#endif
+
+#ifdef RENDERER_STATS
+    size_t stats_size = sizeof(RenderStats) * threads;
+    r->thread_stats = aligned_alloc(_Alignof(RenderStats), stats_size);
+    memset(r->thread_stats, 0, stats_size);
+#endif
+
     pthread_mutex_init(&r->lock, NULL);
     pthread_cond_init(&r->can_work, NULL);
     pthread_cond_init(&r->done_working, NULL);
@@ -184,33 +392,147 @@ void renderer_destroy(Renderer *r) {
     
     free(r->threads); free(r->color_buffer); free(r->depth_buffer);
     free(r->triangles); free(r->tiles); free(r->tile_tri_indices);
-    free(r->vertex_scratch); free(r->bbox_scratch);
-    free(r->draw_calls); free(r->uniform_pool);
+    free(r->vertex_scratch); free(r->bbox_scratch); free(r->meshlet_visible);
+    free(r->draw_calls); free(r->uniform_pool); free(r->post_buffer); free(r->tonemap_lut);
+    for (int i = 0; i < r->thread_count; i++) { free(r->oit[i].heads); free(r->oit[i].frags); }
+    free(r->oit);
+    if (r->msaa_tiles) {
+        for (int i = 0; i < r->thread_count; i++) { free(r->msaa_tiles[i].depth); free(r->msaa_tiles[i].color); }
+        free(r->msaa_tiles);
+    }
+    if (r->temporal_cache) {
+        for (int i = 0; i < 2; i++) {
+            TemporalFrame *f = &r->temporal_cache->frames[i];
+            free(f->color); free(f->key); free(f->prim); free(f->depth); free(f->age);
+        }
+        free(r->temporal_cache);
+    }
+#ifdef RENDERER_STATS
+    free(r->thread_stats);
+#endif
+#ifdef RENDERER_TRACE
+    for (int i = 0; i < r->thread_count; i++) free(r->trace_rings[i].events);
+    free(r->trace_rings);
+#endif
     free(r);
 }
 
 void renderer_reset(Renderer *r) {
-    for (size_t i = 0; i < r->tile_count; i++) r->tiles[i].triangle_count = 0;
+    for (size_t i = 0; i < r->tile_count; i++) r->tiles[i].triangle_count = r->tiles[i].alpha_count = 0;
     atomic_store(&r->triangle_count, 0);
     r->draw_call_count = 0;
+    r->prepass_draws = 0;
     r->uniform_pool_ptr = 0; 
     r->total_vertex_count = 0;
     r->total_max_triangles = 0;
+    r->total_meshlet_count = 0;
+    if (r->temporal_cache) {
+        TemporalCache *tc = r->temporal_cache;
+        tc->prev_valid = tc->written;
+        tc->written = 0;
+        tc->current ^= 1;
+        tc->frame++;
+    }
+#ifdef RENDERER_STATS
+    memset(r->thread_stats, 0, sizeof(RenderStats) * r->thread_count);
+    r->stats_frame++;
+#endif
+    TRACE_INSTANT(r, 0, TRACE_FRAME, 0);
 }
 
 void renderer_clear(Renderer *r, uint32_t c, float d) {
+    STATS_TIMER_BEGIN(t_clear);
+    TRACE_BEGIN(tr_clear);
+    if (r->hdr) c = vec3_to_r11g11b10((vec3){ (float)(c >> 24) / 255.0f, (float)((c >> 16) & 0xFF) / 255.0f, (float)((c >> 8) & 0xFF) / 255.0f });
     size_t count = r->screen_width * r->screen_height;
     for(size_t i=0; i<count; i++) { r->color_buffer[i] = c; r->depth_buffer[i] = d; }
+    STATS_TIMER_END(r, 0, STAT_TIME_CLEAR, t_clear);
+    TRACE_END(r, 0, TRACE_CLEAR, 0, tr_clear);
+}
+
+void renderer_clear_depth(Renderer *r, float d) {
+    STATS_TIMER_BEGIN(t_clear);
+    TRACE_BEGIN(tr_clear);
+    size_t count = r->screen_width * r->screen_height;
+    for(size_t i=0; i<count; i++) r->depth_buffer[i] = d;
+    STATS_TIMER_END(r, 0, STAT_TIME_CLEAR, t_clear);
+    TRACE_END(r, 0, TRACE_CLEAR, 0, tr_clear);
 }
 
 
 void renderer_set_uniforms(Renderer *r, void *u) { r->uniforms = u; }
 void renderer_set_shaders(Renderer *r, VertexShader vs, FragmentShader fs) { r->vertex_shader = vs; r->fragment_shader = fs; }
 void renderer_set_cull_mode(Renderer *r, CullMode mode) { r->cull_mode = mode; }
+void renderer_set_depth_mode(Renderer *r, DepthMode mode) { r->depth_mode = mode; }
+void renderer_set_blend_mode(Renderer *r, BlendMode mode) { r->blend_mode = mode; }
+void renderer_set_blend_constant(Renderer *r, float alpha) { r->blend_constant = alpha; }
+void renderer_set_cluster_culling(Renderer *r, int enabled) { r->cluster_culling = enabled; }
+void renderer_set_batch_shader(Renderer *r, BatchShader bs) { r->batch_shader = bs; }
+void renderer_set_batch_shading(Renderer *r, int enabled) { r->batch_shading = enabled; }
+void renderer_set_depth_prepass(Renderer *r, int enabled) { r->depth_prepass = enabled; }
+
+int renderer_add_post_pass(Renderer *r, PostKernel kernel, PostStage stage, void *params) {
+    if (r->post_pass_count == POST_MAX_PASSES) return 0;
+    r->post_passes[r->post_pass_count++] = (PostPass){ kernel, stage, params };
+    if (stage == POST_HALO && !r->post_buffer) r->post_buffer = malloc(r->screen_width * r->screen_height * sizeof(uint32_t));
+    return 1;
+}
+
+void renderer_clear_post_passes(Renderer *r) { r->post_pass_count = 0; }
+
+static void temporal_invalidate(Renderer *r) {
+    if (r->temporal_cache) r->temporal_cache->prev_valid = r->temporal_cache->written = 0;
+}
+
+// Cached colours are in the format they were shaded in
+void renderer_set_hdr(Renderer *r, int enabled) { r->hdr = enabled; temporal_invalidate(r); }
+
+void renderer_set_tonemap(Renderer *r, float exposure, float white, float gamma) {
+    r->tonemap_exposure = exposure;
+    r->tonemap_white = white;
+    if (!r->tonemap_lut) r->tonemap_lut = malloc(TONEMAP_LUT_SIZE);
+    for (int i = 0; i < TONEMAP_LUT_SIZE; i++) {
+        r->tonemap_lut[i] = (uint8_t)(powf((float)i / (TONEMAP_LUT_SIZE - 1), 1.0f / gamma) * 255.0f + 0.5f);
+    }
+}
+
+void renderer_set_msaa(Renderer *r, int enabled) {
+    r->msaa = enabled;
+    if (!enabled || r->msaa_tiles) return;
+    size_t n = (size_t)r->tile_width * r->tile_height * MSAA_SAMPLES;
+    r->msaa_tiles = calloc(r->thread_count, sizeof(MsaaTile));
+    for (int i = 0; i < r->thread_count; i++) {
+        r->msaa_tiles[i].depth = malloc(n * sizeof(float));
+        r->msaa_tiles[i].color = malloc(n * sizeof(uint32_t));
+    }
+}
+
+void renderer_set_temporal_reuse(Renderer *r, int enabled) {
+    r->temporal = enabled;
+    if (enabled && !r->temporal_cache) {
+        size_t n = r->screen_width * r->screen_height;
+        r->temporal_cache = calloc(1, sizeof(TemporalCache));
+        for (int i = 0; i < 2; i++) {
+            TemporalFrame *f = &r->temporal_cache->frames[i];
+            f->color = malloc(n * sizeof(uint32_t));
+            f->key = calloc(n, sizeof(uint32_t));
+            f->prim = malloc(n * sizeof(uint32_t));
+            f->depth = malloc(n * sizeof(float));
+            f->age = malloc(n);
+        }
+    }
+    temporal_invalidate(r);
+}
+
+void renderer_set_draw_key(Renderer *r, uint32_t key) { r->draw_key = key; }
+
+void renderer_set_temporal_view(Renderer *r, mat4 view_proj) {
+    if (r->temporal_cache) r->temporal_cache->frames[r->temporal_cache->current].view_proj = view_proj;
+}
 
 /* --- 5. DRAW CALL RECORDING --- */
 void renderer_draw_mesh(Renderer *r, Mesh *mesh) {
-    if (!r->vertex_shader || !r->fragment_shader) return;
+    if (!r->vertex_shader) return;
 
     if (r->draw_call_count >= r->draw_call_capacity) {
         r->draw_call_capacity *= 2;
@@ -222,11 +544,51 @@ void renderer_draw_mesh(Renderer *r, Mesh *mesh) {
     dc->vertex_shader = r->vertex_shader;
     dc->fragment_shader = r->fragment_shader;
     dc->cull_mode = r->cull_mode;
+    dc->depth_mode = r->depth_mode;
+    dc->blend_mode = r->blend_mode;
+    dc->blend_constant = r->blend_constant;
+    // Transparent draws test against the opaque depth but never write it
+    if (dc->blend_mode == BLEND_ALPHA && dc->depth_mode == DEPTH_LESS) dc->depth_mode = DEPTH_LESS_NO_WRITE;
+    // and run after the MSAA resolve at one sample per pixel: their lists hold
+    // whole pixels, so partly covered pixels on shared edges would blend twice
+    int msaa = r->msaa && dc->blend_mode != BLEND_ALPHA;
+    dc->pipeline = pipeline_kernels_get(dc->cull_mode, dc->depth_mode, dc->blend_mode, dc->fragment_shader == NULL, msaa);
+    // Blended draws keep their own test: ADD over LESS sums every closer fragment
+    dc->prepass = NULL;
+    if (r->depth_prepass && dc->depth_mode == DEPTH_LESS && dc->blend_mode == BLEND_OPAQUE) {
+        dc->prepass = pipeline_kernels_get(dc->cull_mode, DEPTH_LESS, BLEND_OPAQUE, 1, r->msaa);
+        r->prepass_draws = 1;
+        if (dc->fragment_shader) dc->pipeline = pipeline_kernels_get(dc->cull_mode, DEPTH_EQUAL, BLEND_OPAQUE, 0, r->msaa);
+    }
+    // Cluster culling reads the matrices and camera from the draw's Uniforms
+    dc->cluster_cull = r->cluster_culling && mesh->meshlet_count > 0 && r->uniforms != NULL;
+    dc->batch_shader = r->batch_shading ? r->batch_shader : NULL;
+    dc->temporal_key = r->temporal ? r->draw_key : 0;
+
+#ifdef RENDERER_STATS
+    // Slots are assigned on first use; overflow shaders share the last slot.
+    int slot = 0;
+    while (slot < r->stats_shader_count && r->stats_shaders[slot] != dc->fragment_shader) slot++;
+    if (slot == r->stats_shader_count) {
+        if (r->stats_shader_count < STATS_MAX_SHADERS) r->stats_shaders[r->stats_shader_count++] = dc->fragment_shader;
+        else slot = STATS_MAX_SHADERS - 1;
+    }
+    dc->stats_shader_slot = slot;
+#endif
     
     dc->vertex_offset = r->total_vertex_count;
     r->total_vertex_count += mesh->vertex_count;
     r->total_max_triangles += mesh->index_count / 3;
 
+    if (dc->cluster_cull) {
+        dc->meshlet_offset = r->total_meshlet_count;
+        r->total_meshlet_count += mesh->meshlet_count;
+        if (r->total_meshlet_count > r->meshlet_visible_cap) {
+            r->meshlet_visible_cap = r->total_meshlet_count * 1.5;
+            r->meshlet_visible = realloc(r->meshlet_visible, r->meshlet_visible_cap);
+        }
+    }
+
     if (r->total_vertex_count > r->vertex_scratch_cap) {
         r->vertex_scratch_cap = r->total_vertex_count * 1.5;
         r->vertex_scratch = realloc(r->vertex_scratch, r->vertex_scratch_cap * sizeof(Vertex));
@@ -239,7 +601,9 @@ void renderer_draw_mesh(Renderer *r, Mesh *mesh) {
             r->uniform_pool = realloc(r->uniform_pool, r->uniform_pool_cap);
         }
         dc->uniform_offset = r->uniform_pool_ptr; 
-        memcpy((char*)r->uniform_pool + r->uniform_pool_ptr, r->uniforms, u_size);
+        Uniforms *pooled = (Uniforms*)((char*)r->uniform_pool + r->uniform_pool_ptr);
+        memcpy(pooled, r->uniforms, u_size);
+        pooled->hdr = r->hdr;   // Shaders pack for the current target whoever filled the uniforms
         r->uniform_pool_ptr += u_size;
     }
 }
@@ -247,6 +611,8 @@ void renderer_draw_mesh(Renderer *r, Mesh *mesh) {
 /* --- 6. BINNING & RASTERIZATION --- */
 void renderer_bin_triangles(Renderer *r) {
     renderer_execute_geometry(r);
+    STATS_TIMER_BEGIN(t_bin);
+    TRACE_BEGIN(tr_bin);
 
     size_t active_triangles = atomic_load(&r->triangle_count);
     if (active_triangles > r->bbox_scratch_cap) {
@@ -254,8 +620,10 @@ void renderer_bin_triangles(Renderer *r) {
         r->bbox_scratch = realloc(r->bbox_scratch, r->bbox_scratch_cap * sizeof(BoundingBox));
     }
 
+    // Transparent triangles get a second list per tile, rasterized after the opaque one
     size_t total_bins = 0;
     for (size_t i = 0; i < active_triangles; i++) {
+        int alpha = r->draw_calls[r->triangles[i].draw_id].blend_mode == BLEND_ALPHA;
         r->bbox_scratch[i] = calculate_triangle_bbox(&r->triangles[i]);
         int x0 = CLAMP(r->bbox_scratch[i].min.x / r->tile_width, 0, (int)r->tile_count_x - 1);
         int x1 = CLAMP(r->bbox_scratch[i].max.x / r->tile_width, 0, (int)r->tile_count_x - 1);
@@ -263,7 +631,8 @@ void renderer_bin_triangles(Renderer *r) {
         int y1 = CLAMP(r->bbox_scratch[i].max.y / r->tile_height, 0, (int)r->tile_count_y - 1);
         for (int y = y0; y <= y1; y++) {
             for (int x = x0; x <= x1; x++) {
-                r->tiles[y * r->tile_count_x + x].triangle_count++;
+                Tile *t = &r->tiles[y * r->tile_count_x + x];
+                if (alpha) t->alpha_count++; else t->triangle_count++;
                 total_bins++;
             }
         }
@@ -278,10 +647,13 @@ void renderer_bin_triangles(Renderer *r) {
     for (size_t i = 0; i < r->tile_count; i++) {
         r->tiles[i].tri_offset = current_offset;
         current_offset += r->tiles[i].triangle_count;
-        r->tiles[i].triangle_count = 0;
+        r->tiles[i].alpha_offset = current_offset;
+        current_offset += r->tiles[i].alpha_count;
+        r->tiles[i].triangle_count = r->tiles[i].alpha_count = 0;
     }
 
     for (size_t i = 0; i < active_triangles; i++) {
+        int alpha = r->draw_calls[r->triangles[i].draw_id].blend_mode == BLEND_ALPHA;
         int x0 = CLAMP(r->bbox_scratch[i].min.x / r->tile_width, 0, (int)r->tile_count_x - 1);
         int x1 = CLAMP(r->bbox_scratch[i].max.x / r->tile_width, 0, (int)r->tile_count_x - 1);
         int y0 = CLAMP(r->bbox_scratch[i].min.y / r->tile_height, 0, (int)r->tile_count_y - 1);
@@ -289,10 +661,15 @@ void renderer_bin_triangles(Renderer *r) {
         for (int y = y0; y <= y1; y++) {
             for (int x = x0; x <= x1; x++) {
                 Tile *t = &r->tiles[y * r->tile_count_x + x];
-                r->tile_tri_indices[t->tri_offset + t->triangle_count++] = (int)i;
+                if (alpha) r->tile_tri_indices[t->alpha_offset + t->alpha_count++] = (int)i;
+                else r->tile_tri_indices[t->tri_offset + t->triangle_count++] = (int)i;
             }
         }
     }
+
+    STATS_ADD(r, 0, bins_written, total_bins);
+    STATS_TIMER_END(r, 0, STAT_TIME_BIN, t_bin);
+    TRACE_END(r, 0, TRACE_BIN, 0, tr_bin);
 }
 
 static inline int is_top_left(int64_t xA, int64_t yA, int64_t xB, int64_t yB) {
@@ -302,14 +679,23 @@ static inline int is_top_left(int64_t xA, int64_t yA, int64_t xB, int64_t yB) {
     return (dy < 0) || (dy == 0 && dx > 0);
 }
 
-static void rasterize_triangle_in_tile(Renderer *r, Triangle *t, Tile *tile) {
-    DrawCall *dc = &r->draw_calls[t->draw_id];
-    void* uniforms = get_dc_uniforms(r, dc);
-    
+// Edge functions, depth and barycentric planes of one triangle, clipped to a tile
+struct RasterSetup {
+    int     min_x, max_x, min_y, max_y;
+    int     tile_x0, tile_x1, tile_y0, tile_y1;
+    int64_t w_row[3], step_x[3], step_y[3], bias[3];  // Edge functions at (min_x, min_y) and per pixel
+    float   inv_area;
+    float   b_row[3], db_dx[3], db_dy[3];             // Screen-space barycentric planes
+    float   z_row, z_step_x, z_step_y;
+};
+
+static int raster_setup(const Triangle *t, const Tile *tile, RasterSetup *s) {
     BoundingBox bbox = calculate_triangle_bbox(t);
-    int min_x = MAX(bbox.min.x, tile->x0), max_x = MIN(bbox.max.x, tile->x1 - 1);
-    int min_y = MAX(bbox.min.y, tile->y0), max_y = MIN(bbox.max.y, tile->y1 - 1);
-    if (min_x > max_x || min_y > max_y) return;
+    s->min_x = MAX(bbox.min.x, tile->x0); s->max_x = MIN(bbox.max.x, tile->x1 - 1);
+    s->min_y = MAX(bbox.min.y, tile->y0); s->max_y = MIN(bbox.max.y, tile->y1 - 1);
+    if (s->min_x > s->max_x || s->min_y > s->max_y) return 0;
+    s->tile_x0 = tile->x0; s->tile_x1 = tile->x1;
+    s->tile_y0 = tile->y0; s->tile_y1 = tile->y1;
 
     const int sub_pixel_bits = 8;
     const int sub_pixel_scale = 1 << sub_pixel_bits;
@@ -324,86 +710,752 @@ static void rasterize_triangle_in_tile(Renderer *r, Triangle *t, Tile *tile) {
 
     // FIX 1: Corrected area to match original winding (dx02 * dy01 - dy02 * dx01)
     int64_t area = (x2 - x0) * dy01 - (y2 - y0) * dx01;
-    if (area <= 0) return; 
-    float inv_area = 1.0f / (float)area;
+    if (area <= 0) return 0; 
+    s->inv_area = 1.0f / (float)area;
 
-    int64_t bias0 = is_top_left(x1, y1, x2, y2) ? 0 : -1;
-    int64_t bias1 = is_top_left(x2, y2, x0, y0) ? 0 : -1;
-    int64_t bias2 = is_top_left(x0, y0, x1, y1) ? 0 : -1;
+    s->bias[0] = is_top_left(x1, y1, x2, y2) ? 0 : -1;
+    s->bias[1] = is_top_left(x2, y2, x0, y0) ? 0 : -1;
+    s->bias[2] = is_top_left(x0, y0, x1, y1) ? 0 : -1;
 
-    int64_t p_start_x = ((int64_t)min_x << sub_pixel_bits) + (sub_pixel_scale >> 1);
-    int64_t p_start_y = ((int64_t)min_y << sub_pixel_bits) + (sub_pixel_scale >> 1);
+    int64_t p_start_x = ((int64_t)s->min_x << sub_pixel_bits) + (sub_pixel_scale >> 1);
+    int64_t p_start_y = ((int64_t)s->min_y << sub_pixel_bits) + (sub_pixel_scale >> 1);
 
-    int64_t w0_row = (p_start_x - x1) * dy12 - (p_start_y - y1) * dx12;
-    int64_t w1_row = (p_start_x - x2) * dy20 - (p_start_y - y2) * dx20;
-    int64_t w2_row = (p_start_x - x0) * dy01 - (p_start_y - y0) * dx01;
+    s->w_row[0] = (p_start_x - x1) * dy12 - (p_start_y - y1) * dx12;
+    s->w_row[1] = (p_start_x - x2) * dy20 - (p_start_y - y2) * dx20;
+    s->w_row[2] = (p_start_x - x0) * dy01 - (p_start_y - y0) * dx01;
 
     // FIX 2: Multiply steps by sub_pixel_scale (256) because the loop moves by whole pixels
-    int64_t step_x0 = dy12 << sub_pixel_bits, step_y0 = -dx12 << sub_pixel_bits;
-    int64_t step_x1 = dy20 << sub_pixel_bits, step_y1 = -dx20 << sub_pixel_bits;
-    int64_t step_x2 = dy01 << sub_pixel_bits, step_y2 = -dx01 << sub_pixel_bits;
+    s->step_x[0] = dy12 << sub_pixel_bits; s->step_y[0] = -dx12 << sub_pixel_bits;
+    s->step_x[1] = dy20 << sub_pixel_bits; s->step_y[1] = -dx20 << sub_pixel_bits;
+    s->step_x[2] = dy01 << sub_pixel_bits; s->step_y[2] = -dx01 << sub_pixel_bits;
 
     // FIX 3: More precise Z interpolation using barycentric steps
     float z0 = t->v[0].z, z1 = t->v[1].z, z2 = t->v[2].z;
-    float db0_dx = (float)step_x0 * inv_area, db0_dy = (float)step_y0 * inv_area;
-    float db1_dx = (float)step_x1 * inv_area, db1_dy = (float)step_y1 * inv_area;
-    float db2_dx = (float)step_x2 * inv_area, db2_dy = (float)step_y2 * inv_area;
+    for (int i = 0; i < 3; i++) {
+        s->db_dx[i] = (float)s->step_x[i] * s->inv_area;
+        s->db_dy[i] = (float)s->step_y[i] * s->inv_area;
+        s->b_row[i] = (float)s->w_row[i] * s->inv_area;
+    }
+    s->z_step_x = s->db_dx[0] * z0 + s->db_dx[1] * z1 + s->db_dx[2] * z2;
+    s->z_step_y = s->db_dy[0] * z0 + s->db_dy[1] * z1 + s->db_dy[2] * z2;
+    s->z_row    = s->b_row[0] * z0 + s->b_row[1] * z1 + s->b_row[2] * z2;
+    return 1;
+}
 
-    float z_step_x = db0_dx * z0 + db1_dx * z1 + db2_dx * z2;
-    float z_step_y = db0_dy * z0 + db1_dy * z1 + db2_dy * z2;
-    
-    float b0_row = (float)w0_row * inv_area;
-    float b1_row = (float)w1_row * inv_area;
-    float b2_row = (float)w2_row * inv_area;
-    float z_row  = b0_row * z0 + b1_row * z1 + b2_row * z2;
-
-    for (int y = min_y; y <= max_y; y++) {
-        int64_t w0 = w0_row, w1 = w1_row, w2 = w2_row;
-        float z = z_row;
-        int row_base = y * (int)r->screen_width;
-
-        for (int x = min_x; x <= max_x; x++) {
-            if (((w0 + bias0) | (w1 + bias1) | (w2 + bias2)) >= 0) {
-                int idx = row_base + x;
-                if (z < r->depth_buffer[idx]) {
-                    r->depth_buffer[idx] = z;
-                    float b0 = (float)w0 * inv_area;
-                    float b1 = (float)w1 * inv_area;
-                    float b2 = 1.0f - b0 - b1;
-                    r->color_buffer[idx] = dc->fragment_shader(t, b0, b1, b2, uniforms);
+// Attributes carried as screen-space planes; all but the barycentrics are
+// pre-divided by w in shade_vertex, so they are affine on screen
+enum { QA_B0, QA_B1, QA_INV_W, QA_WX, QA_WY, QA_WZ, QA_NX, QA_NY, QA_NZ, QA_U, QA_V, QA_COUNT };
+
+// Every per-pixel array of a FragmentBatch
+#define FRAGMENT_BATCH_ARRAYS(X) \
+    X(b0) X(b1) X(b2) X(z) X(w) X(world_x) X(world_y) X(world_z) X(nx) X(ny) X(nz) X(u) X(v)
+
+// Lane offsets inside a quad, in pixels
+#define QUAD_LANE_X ((f32x4){ 0.0f, 1.0f, 0.0f, 1.0f })
+#define QUAD_LANE_Y ((f32x4){ 0.0f, 0.0f, 1.0f, 1.0f })
+
+// The batch a thread fills while rasterizing one tile. It only ever holds
+// fragments of one draw call and is flushed in order, so later triangles
+// still overwrite earlier ones.
+struct BatchState {
+    FragmentBatch frags;
+    DrawCall     *dc;
+    uint32_t      colors[FRAGMENT_BATCH];
+    uint16_t      samples[FRAGMENT_BATCH_QUADS];   // MSAA only: bit 4 * lane + k, sample k passed
+    uint32_t      cached[FRAGMENT_BATCH];          // Temporal reuse only: colour and age of each reused lane,
+    uint8_t       age[FRAGMENT_BATCH];             // kept apart since batch shaders write whole SIMD groups
+};
+
+// Adapter for shaders without a batched variant: one call per written pixel
+static void shade_batch_per_pixel(const FragmentBatch *b, FragmentShader fs, void *uniforms, uint32_t *out) {
+    for (int i = 0; i < b->count; i++) {
+        if ((b->mask >> i) & 1) out[i] = fs(b->tri[i >> 2], b->b0[i], b->b1[i], b->b2[i], uniforms);
+    }
+}
+
+// Per-channel saturating add of two RGBA8888 colours, all four bytes at once
+static inline uint32_t color_add_saturate(uint32_t a, uint32_t b) {
+    uint32_t low = (a & 0x7F7F7F7Fu) + (b & 0x7F7F7F7Fu);   // Cannot carry across channels
+    uint32_t sum = low ^ ((a ^ b) & 0x80808080u);
+    uint32_t overflow = ((a & b) | ((a | b) & low)) & 0x80808080u;
+    return sum | (overflow >> 7) * 0xFFu;
+}
+
+// ADD blending in whichever format the colour buffer holds
+static inline uint32_t color_add(const Renderer *r, uint32_t dst, uint32_t src) {
+    if (!r->hdr) return color_add_saturate(dst, src);
+    return vec3_to_r11g11b10(vec3_add(r11g11b10_to_vec3(dst), r11g11b10_to_vec3(src)));
+}
+
+static void oit_begin(OitArena *a, const Tile *tile) {
+    a->x0 = tile->x0; a->y0 = tile->y0; a->width = tile->x1 - tile->x0;
+    a->count = 0;
+    for (int i = 0; i < a->width * (tile->y1 - tile->y0); i++) a->heads[i] = -1;
+}
+
+// Appends the written pixels with a non-zero alpha, returns how many. HDR
+// colours have no alpha of their own, so only the blend constant counts.
+static size_t oit_append(OitArena *a, const FragmentBatch *b, const uint32_t *colors, float blend_constant, int hdr) {
+    size_t appended = 0;
+    for (int i = 0; i < b->count; i++) {
+        if (!((b->mask >> i) & 1)) continue;
+        uint32_t alpha = MIN((uint32_t)((float)(hdr ? 0xFFu : colors[i] & 0xFFu) * blend_constant), 255u);
+        if (alpha == 0) continue;
+        if (a->count == a->capacity) {
+            a->capacity = a->capacity ? a->capacity * 2 : OIT_STARTING_FRAGS;
+            a->frags = realloc(a->frags, a->capacity * sizeof(OitFragment));
+        }
+        int x = b->x[i >> 2] + (i & 1), y = b->y[i >> 2] + ((i >> 1) & 1);
+        int32_t *head = &a->heads[(y - a->y0) * a->width + (x - a->x0)];
+        uint32_t color = hdr ? colors[i] : (colors[i] & ~0xFFu) | alpha;
+        a->frags[a->count] = (OitFragment){ b->z[i], color, *head, (uint8_t)alpha };
+        *head = (int32_t)a->count++;
+        appended++;
+    }
+    return appended;
+}
+
+// Composites every pixel's list over the opaque colour, back to front. Only
+// the OIT_MAX_LAYERS nearest fragments are kept, sorted by insertion.
+static void oit_resolve(Renderer *r, const OitArena *a, const Tile *tile, int thread) {
+    int width = (int)r->screen_width;
+    STATS_ONLY(uint64_t dropped = 0;)
+    for (int y = tile->y0; y < tile->y1; y++) {
+        const int32_t *heads = &a->heads[(y - a->y0) * a->width];
+        uint32_t *row = &r->color_buffer[y * width];
+        for (int x = tile->x0; x < tile->x1; x++) {
+            int32_t head = heads[x - a->x0];
+            if (head < 0) continue;
+            OitFragment layers[OIT_MAX_LAYERS];
+            int n = 0;
+            for (int32_t f = head; f >= 0; f = a->frags[f].next) {
+                OitFragment frag = a->frags[f];
+                if (n == OIT_MAX_LAYERS) {
+                    STATS_ONLY(dropped++;)
+                    if (frag.z >= layers[n - 1].z) continue;
+                    n--;
+                }
+                int k = n++;
+                while (k > 0 && layers[k - 1].z > frag.z) { layers[k] = layers[k - 1]; k--; }
+                layers[k] = frag;
+            }
+            uint32_t c = row[x];
+            for (int k = n - 1; k >= 0; k--) {
+                c = r->hdr ? blend_r11g11b10(layers[k].color, (float)layers[k].alpha / 255.0f, c) : blend_colors(layers[k].color, c);
+            }
+            row[x] = c;
+        }
+    }
+    STATS_ADD(r, thread, oit_fragments_dropped, dropped);
+    (void)thread;
+}
+
+static inline size_t msaa_index(const MsaaTile *m, int x, int y) {
+    return ((size_t)(y - m->y0) * m->width + (size_t)(x - m->x0)) * MSAA_SAMPLES;
+}
+
+// Every sample of a pixel starts as its framebuffer colour and depth
+static void msaa_begin(Renderer *r, MsaaTile *m, const Tile *tile) {
+    m->x0 = tile->x0; m->y0 = tile->y0; m->width = tile->x1 - tile->x0;
+    int width = (int)r->screen_width;
+    for (int y = tile->y0; y < tile->y1; y++) {
+        for (int x = tile->x0; x < tile->x1; x++) {
+            size_t i = msaa_index(m, x, y);
+            f32x4_store(&m->depth[i], f32x4_splat(r->depth_buffer[y * width + x]));
+            for (int k = 0; k < MSAA_SAMPLES; k++) m->color[i + k] = r->color_buffer[y * width + x];
+        }
+    }
+}
+
+// Box filter into the framebuffer, two channels per 32-bit add or in float for
+// HDR; depth keeps the nearest sample. Pixels inside one triangle have equal samples.
+static void msaa_resolve(Renderer *r, const MsaaTile *m, const Tile *tile) {
+    int width = (int)r->screen_width;
+    for (int y = tile->y0; y < tile->y1; y++) {
+        for (int x = tile->x0; x < tile->x1; x++) {
+            size_t i = msaa_index(m, x, y);
+            const uint32_t *c = &m->color[i];
+            uint32_t out = c[0];
+            if (r->hdr && (c[1] != out || c[2] != out || c[3] != out)) {
+                vec3 sum = r11g11b10_to_vec3(c[0]);
+                for (int k = 1; k < MSAA_SAMPLES; k++) sum = vec3_add(sum, r11g11b10_to_vec3(c[k]));
+                out = vec3_to_r11g11b10(vec3_mul(sum, 1.0f / MSAA_SAMPLES));
+            } else if (c[1] != out || c[2] != out || c[3] != out) {
+                uint32_t lo = 0x00020002u, hi = 0x00020002u;   // Round to nearest
+                for (int k = 0; k < MSAA_SAMPLES; k++) { lo += c[k] & 0x00FF00FFu; hi += (c[k] >> 8) & 0x00FF00FFu; }
+                out = ((lo >> 2) & 0x00FF00FFu) | (((hi >> 2) & 0x00FF00FFu) << 8);
+            }
+            const float *d = &m->depth[i];
+            r->color_buffer[y * width + x] = out;
+            r->depth_buffer[y * width + x] = MIN(MIN(d[0], d[1]), MIN(d[2], d[3]));
+        }
+    }
+}
+
+// Converts the finished tile from R11G11B10 to RGBA8888 in place, 8 pixels at
+// a time: exposure and extended Reinhard in SIMD, then the gamma LUT
+static void hdr_tonemap(Renderer *r, const Tile *tile) {
+    int width = (int)r->screen_width;
+    const uint8_t *lut = r->tonemap_lut;
+    float exposure = r->tonemap_exposure, inv_white_sq = 1.0f / (r->tonemap_white * r->tonemap_white);
+    for (int y = tile->y0; y < tile->y1; y++) {
+        uint32_t *row = &r->color_buffer[y * width];
+        for (int x = tile->x0; x < tile->x1; x += SIMD_WIDTH) {
+            int n = MIN(SIMD_WIDTH, tile->x1 - x);
+            u32x8 c = { 0 };
+            if (n == SIMD_WIDTH) c = u32x8_load(row + x);
+            else for (int i = 0; i < n; i++) c[i] = row[x + i];
+
+            f32x8 ch[3];
+            i32x8 idx[3];
+            f32x8_from_r11g11b10(c, &ch[0], &ch[1], &ch[2]);
+            for (int k = 0; k < 3; k++) {
+                f32x8 v = ch[k] * exposure;
+                v = f32x8_min(v * (1.0f + v * inv_white_sq) / (1.0f + v), f32x8_splat(1.0f));
+                idx[k] = __builtin_convertvector(v * (float)(TONEMAP_LUT_SIZE - 1) + 0.5f, i32x8);
+            }
+            for (int i = 0; i < n; i++) {
+                row[x + i] = (uint32_t)lut[idx[0][i]] << 24 | (uint32_t)lut[idx[1][i]] << 16 | (uint32_t)lut[idx[2][i]] << 8 | 0xFFu;
+            }
+        }
+    }
+}
+
+// Lanes of the batch whose surface point, reprojected into the last frame,
+// lands near the centre of a pixel that the same triangle of a draw with the
+// same key left at the same depth, so the point was visible there. Their colours are copied into
+// bs->cached. Pixels whose refresh slot is this frame always miss.
+static uint64_t temporal_fetch(const Renderer *r, BatchState *bs) {
+    const TemporalCache *tc = r->temporal_cache;
+    const FragmentBatch *b = &bs->frags;
+    uint32_t key = bs->dc->temporal_key;
+    if (!tc->prev_valid || key == 0) return 0;
+
+    const TemporalFrame *prev = &tc->frames[tc->current ^ 1];
+    const mat4 *m = &prev->view_proj;
+    float width = (float)r->screen_width, height = (float)r->screen_height;
+    uint64_t hits = 0;
+    for (int i = 0; i < b->count; i += SIMD_WIDTH) {
+        uint32_t lanes = batch_mask8(b, i);
+        if (!lanes) continue;
+        f32x8 x = f32x8_load(&b->world_x[i]), y = f32x8_load(&b->world_y[i]), z = f32x8_load(&b->world_z[i]);
+        f32x8 cx = m->m[0][0] * x + m->m[1][0] * y + m->m[2][0] * z + m->m[3][0];
+        f32x8 cy = m->m[0][1] * x + m->m[1][1] * y + m->m[2][1] * z + m->m[3][1];
+        f32x8 cw = m->m[0][3] * x + m->m[1][3] * y + m->m[2][3] * z + m->m[3][3];
+        f32x8 inv_w = 1.0f / f32x8_max(cw, f32x8_splat(NEAR_PLANE_W));
+        f32x8 px = (cx * inv_w + 1.0f) * 0.5f * width;
+        f32x8 py = (1.0f - cy * inv_w) * 0.5f * height;
+
+        // Clamped onto the screen, so points off it land too far from the centre
+        i32x8 ix = __builtin_convertvector(f32x8_min(f32x8_max(px, f32x8_splat(0.0f)), f32x8_splat(width - 1.0f)), i32x8);
+        i32x8 iy = __builtin_convertvector(f32x8_min(f32x8_max(py, f32x8_splat(0.0f)), f32x8_splat(height - 1.0f)), i32x8);
+        f32x8 dx = px - (__builtin_convertvector(ix, f32x8) + 0.5f);
+        f32x8 dy = py - (__builtin_convertvector(iy, f32x8) + 0.5f);
+        i32x8 ok = (cw >= NEAR_PLANE_W) & (dx >= -TEMPORAL_MAX_OFFSET) & (dx <= TEMPORAL_MAX_OFFSET) &
+                   (dy >= -TEMPORAL_MAX_OFFSET) & (dy <= TEMPORAL_MAX_OFFSET);
+
+        for (uint32_t cand = lanes & i32x8_bits(ok); cand; cand &= cand - 1) {
+            int l = __builtin_ctz(cand), n = i + l, q = n >> 2;
+            int sx = b->x[q] + (n & 1), sy = b->y[q] + ((n >> 1) & 1);
+            uint32_t slot = (uint32_t)((sx >> TEMPORAL_REFRESH_SHIFT) + 3 * (sy >> TEMPORAL_REFRESH_SHIFT));
+            if (slot % TEMPORAL_MAX_AGE == tc->frame % TEMPORAL_MAX_AGE) continue;
+            size_t p = (size_t)iy[l] * r->screen_width + (size_t)ix[l];
+            if (prev->key[p] != key || prev->prim[p] != b->tri[q]->prim_id || prev->age[p] + 1 >= TEMPORAL_MAX_AGE) continue;
+            if (fabsf(prev->depth[p] - cw[l]) > TEMPORAL_DEPTH_TOLERANCE * cw[l]) continue;
+            bs->cached[n] = prev->color[p];
+            bs->age[n] = (uint8_t)(prev->age[p] + 1);
+            hits |= 1ull << n;
+        }
+    }
+    return hits;
+}
+
+// Moves the reused colours into bs->colors once the rest are shaded, and
+// records every written lane's colour, key, triangle and depth for the next frame
+static void temporal_store(Renderer *r, BatchState *bs, uint64_t reused) {
+    TemporalFrame *cur = &r->temporal_cache->frames[r->temporal_cache->current];
+    const FragmentBatch *b = &bs->frags;
+    for (uint64_t m = b->mask; m; m &= m - 1) {
+        int n = __builtin_ctzll(m), q = n >> 2;
+        size_t p = (size_t)(b->y[q] + ((n >> 1) & 1)) * r->screen_width + (size_t)(b->x[q] + (n & 1));
+        if ((reused >> n) & 1) bs->colors[n] = bs->cached[n];
+        cur->color[p] = bs->colors[n];
+        cur->key[p] = bs->dc->temporal_key;
+        cur->prim[p] = b->tri[q]->prim_id;
+        cur->depth[p] = b->w[n];
+        cur->age[p] = (reused >> n) & 1 ? bs->age[n] : 0;
+    }
+}
+
+// Template for the write-out kernels; `blend` and `samples` are constants in every instantiation
+static inline __attribute__((always_inline)) void flush_batch(Renderer *r, BatchState *bs, int thread, const BlendMode blend,
+                                                              const int samples) {
+    FragmentBatch *b = &bs->frags;
+    if (b->count == 0) return;
+    DrawCall *dc = bs->dc;
+    void *uniforms = get_dc_uniforms(r, dc);
+
+    // Pad to whole SIMD groups with copies of the last quad, never written
+    while (b->count % SIMD_WIDTH) {
+        int src = b->count - 4, q = b->count >> 2;
+#define COPY_QUAD(name) memcpy(&b->name[b->count], &b->name[src], 4 * sizeof(float));
+        FRAGMENT_BATCH_ARRAYS(COPY_QUAD)
+#undef COPY_QUAD
+        b->tri[q] = b->tri[q - 1]; b->x[q] = b->x[q - 1]; b->y[q] = b->y[q - 1];
+        b->count += 4;
+    }
+
+    // Reused lanes leave the mask while the rest are shaded
+    uint64_t reused = 0, mask = b->mask;
+    if (blend == BLEND_OPAQUE && r->temporal) reused = temporal_fetch(r, bs);
+    STATS_ADD(r, thread, fs_invocations[dc->stats_shader_slot], __builtin_popcountll(mask & ~reused));
+    if (reused != mask) {
+        b->mask = mask & ~reused;
+        if (dc->batch_shader) dc->batch_shader(b, uniforms, bs->colors);
+        else shade_batch_per_pixel(b, dc->fragment_shader, uniforms, bs->colors);
+        b->mask = mask;
+    }
+    if (blend == BLEND_OPAQUE && r->temporal) {
+        temporal_store(r, bs, reused);
+        STATS_ADD(r, thread, temporal_reused, __builtin_popcountll(reused));
+        STATS_ADD(r, thread, temporal_shaded, __builtin_popcountll(mask & ~reused));
+    }
+
+    if (blend == BLEND_ALPHA) {
+        size_t appended = oit_append(&r->oit[thread], b, bs->colors, dc->blend_constant, r->hdr);
+        STATS_ADD(r, thread, oit_fragments, appended);
+        (void)appended;
+    } else if (samples > 1) {
+        // Each pixel's colour goes to the samples it covered
+        MsaaTile *m = &r->msaa_tiles[thread];
+        for (int q = 0; q < b->count >> 2; q++) {
+            uint32_t lanes = (uint32_t)(b->mask >> (q * 4)) & 0xFu;
+            for (int lane = 0; lane < 4; lane++) {
+                if (!(lanes & (1u << lane))) continue;
+                uint32_t covered = (bs->samples[q] >> (lane * 4)) & 0xFu, src = bs->colors[q * 4 + lane];
+                uint32_t *dst = &m->color[msaa_index(m, b->x[q] + (lane & 1), b->y[q] + (lane >> 1))];
+                for (int k = 0; k < MSAA_SAMPLES; k++) {
+                    if (covered & (1u << k)) dst[k] = blend == BLEND_ADD ? color_add(r, dst[k], src) : src;
                 }
             }
-            w0 += step_x0; w1 += step_x1; w2 += step_x2;
-            z += z_step_x;
         }
-        w0_row += step_y0; w1_row += step_y1; w2_row += step_y2;
-        z_row += z_step_y;
+    } else {
+        int width = (int)r->screen_width;
+        for (int q = 0; q < b->count >> 2; q++) {
+            uint32_t lanes = (uint32_t)(b->mask >> (q * 4)) & 0xFu;
+            if (!lanes) continue;
+            uint32_t *c0 = &r->color_buffer[b->y[q] * width + b->x[q]];
+            const uint32_t *src = &bs->colors[q * 4];
+            if (blend == BLEND_ADD) {
+                for (int lane = 0; lane < 4; lane++) {
+                    uint32_t *dst = &c0[(lane >> 1) * width + (lane & 1)];
+                    if (lanes & (1u << lane)) *dst = color_add(r, *dst, src[lane]);
+                }
+            } else if (lanes == 0xFu) {
+                memcpy(c0, src, 2 * sizeof(uint32_t));
+                memcpy(c0 + width, src + 2, 2 * sizeof(uint32_t));
+            } else {
+                for (int lane = 0; lane < 4; lane++) {
+                    if (lanes & (1u << lane)) c0[(lane >> 1) * width + (lane & 1)] = src[lane];
+                }
+            }
+        }
+    }
+
+    STATS_ADD(r, thread, batches_shaded, 1);
+    (void)thread;
+    b->count = 0;
+    b->mask = 0;
+}
+
+// Lane i is inside when all three edge functions are >= 0 there: OR them and test the sign once
+static inline uint32_t quad_coverage(int64_t e0, int64_t e1, int64_t e2, const int64_t sx[3], const int64_t sy[3]) {
+    int64_t l0 = e0 | e1 | e2;
+    int64_t l1 = (e0 + sx[0]) | (e1 + sx[1]) | (e2 + sx[2]);
+    int64_t l2 = (e0 + sy[0]) | (e1 + sy[1]) | (e2 + sy[2]);
+    int64_t l3 = (e0 + sx[0] + sy[0]) | (e1 + sx[1] + sy[1]) | (e2 + sx[2] + sy[2]);
+    return (uint32_t)(~(uint64_t)l0 >> 63) | (uint32_t)(~(uint64_t)l1 >> 63) << 1 |
+           (uint32_t)(~(uint64_t)l2 >> 63) << 2 | (uint32_t)(~(uint64_t)l3 >> 63) << 3;
+}
+
+// Bit 4 * lane + k: sample k of the lane is inside. `so` offsets each edge from
+// the pixel centre to the samples; the top-left bias in e0..e2 applies as is.
+static inline uint32_t quad_sample_coverage(int64_t e0, int64_t e1, int64_t e2, const int64_t sx[3], const int64_t sy[3],
+                                            const int64_t so[3][MSAA_SAMPLES]) {
+    uint32_t bits = 0;
+    for (int lane = 0; lane < 4; lane++) {
+        int64_t l0 = e0 + (lane & 1) * sx[0] + (lane >> 1) * sy[0];
+        int64_t l1 = e1 + (lane & 1) * sx[1] + (lane >> 1) * sy[1];
+        int64_t l2 = e2 + (lane & 1) * sx[2] + (lane >> 1) * sy[2];
+        for (int k = 0; k < MSAA_SAMPLES; k++) {
+            int64_t l = (l0 + so[0][k]) | (l1 + so[1][k]) | (l2 + so[2][k]);
+            bits |= (uint32_t)(~(uint64_t)l >> 63) << (lane * 4 + k);
+        }
     }
+    return bits;
 }
 
-void process_tile(Renderer *r, int tile_index) {
+// Lane mask to the sample bits of those lanes, and sample bits to the lanes with any
+static inline uint32_t msaa_lane_samples(uint32_t lanes) {
+    return (lanes & 1u) * 0xFu | (lanes & 2u) * 0x78u | (lanes & 4u) * 0x3C0u | (lanes & 8u) * 0x1E00u;
+}
+static inline uint32_t msaa_sample_lanes(uint32_t bits) {
+    bits |= bits >> 1;
+    bits |= bits >> 2;
+    return (bits & 1u) | ((bits >> 3) & 2u) | ((bits >> 6) & 4u) | ((bits >> 9) & 8u);
+}
+
+// Attribute planes of one triangle: lanes of the quad at the grid origin plus
+// the step to the next quad in x and y
+typedef struct {
+    f32x4 lanes[QA_COUNT];
+    float step_x[QA_COUNT], step_y[QA_COUNT];
+} QuadPlanes;
+
+// Returned by value: GCC 12.2 at -O1 and above deletes calls to an
+// out-parameter form that stores the f32x4 lanes through the pointer, leaving
+// the caller's planes uninitialised (a float-array member does not trigger it)
+static QuadPlanes quad_planes_setup(const Triangle *t, const RasterSetup *s, int ox, int oy) {
+    QuadPlanes p;
+    float vtx[QA_COUNT][3];
+    for (int k = 0; k < 3; k++) {
+        const Vertex *v = &t->v[k];
+        vtx[QA_B0][k] = k == 0; vtx[QA_B1][k] = k == 1;
+        vtx[QA_INV_W][k] = v->w;
+        vtx[QA_WX][k] = v->world_pos.x; vtx[QA_WY][k] = v->world_pos.y; vtx[QA_WZ][k] = v->world_pos.z;
+        vtx[QA_NX][k] = v->nx; vtx[QA_NY][k] = v->ny; vtx[QA_NZ][k] = v->nz;
+        vtx[QA_U][k] = v->u; vtx[QA_V][k] = v->v;
+    }
+    for (int a = 0; a < QA_COUNT; a++) {
+        float dx = s->db_dx[0] * vtx[a][0] + s->db_dx[1] * vtx[a][1] + s->db_dx[2] * vtx[a][2];
+        float dy = s->db_dy[0] * vtx[a][0] + s->db_dy[1] * vtx[a][1] + s->db_dy[2] * vtx[a][2];
+        float origin = s->b_row[0] * vtx[a][0] + s->b_row[1] * vtx[a][1] + s->b_row[2] * vtx[a][2] + ox * dx + oy * dy;
+        p.lanes[a] = origin + QUAD_LANE_X * dx + QUAD_LANE_Y * dy;
+        p.step_x[a] = 2.0f * dx;
+        p.step_y[a] = 2.0f * dy;
+    }
+    return p;
+}
+
+// Walks the triangle in 2x2 quads aligned to even pixels, so neighbouring
+// triangles agree on quad boundaries. Edges and depth step incrementally from
+// quad to quad. Attribute planes are only set up once a quad survives the depth
+// test (most triangles are a handful of pixels), then evaluated once per quad
+// rather than once per pixel, and the quad is appended to the thread's batch.
+// Template for the raster kernels; `depth`, `shade` and `samples` are constants
+// in every instantiation. Depth-only kernels (no fragment shader) stop after
+// the depth test: no planes, no batch, no colour. Multisampled kernels test
+// coverage and depth per sample against the thread's MsaaTile; a lane is
+// shaded once, at its centre, if any of its samples passed.
+static inline __attribute__((always_inline)) void rasterize_quads(Renderer *r, Triangle *t, BatchState *bs, const RasterSetup *s, int thread,
+                                                                  const DepthMode depth, const int shade, const int samples) {
+    int qx0 = s->min_x & ~1, qy0 = s->min_y & ~1;
+    int ox = qx0 - s->min_x, oy = qy0 - s->min_y;   // 0 or -1
+
+    // Edge functions with the top-left bias folded in, at the first quad's top-left pixel
+    int64_t e_row[3];
+    for (int i = 0; i < 3; i++) e_row[i] = s->w_row[i] + s->bias[i] + ox * s->step_x[i] + oy * s->step_y[i];
+    f32x4 z_row = (s->z_row + ox * s->z_step_x + oy * s->z_step_y) + QUAD_LANE_X * s->z_step_x + QUAD_LANE_Y * s->z_step_y;
+
+    // Edge and depth offsets from the pixel centre to each sample. Edge steps
+    // are whole pixels in 1/256 units, so sixteenths divide exactly.
+    MsaaTile *ms = samples > 1 ? &r->msaa_tiles[thread] : NULL;
+    int64_t so[3][MSAA_SAMPLES];
+    f32x4 zo = f32x4_splat(0.0f);
+    for (int k = 0; samples > 1 && k < MSAA_SAMPLES; k++) {
+        int px = msaa_positions[k][0], py = msaa_positions[k][1];
+        for (int i = 0; i < 3; i++) so[i][k] = (s->step_x[i] * px + s->step_y[i] * py) / 16;
+        zo[k] = (s->z_step_x * (float)px + s->z_step_y * (float)py) * (1.0f / 16.0f);
+    }
+
+    QuadPlanes planes;
+    int planes_ready = 0;
+    int width = (int)r->screen_width;
+    STATS_ONLY(uint64_t tested = 0, shaded = 0, quads = 0, helpers = 0;)
+
+    for (int qy = qy0; qy <= s->max_y; qy += 2) {
+        int64_t e0 = e_row[0], e1 = e_row[1], e2 = e_row[2];
+        f32x4 z = z_row;
+
+        // Rows outside the tile or bounding box never get written
+        uint32_t row_mask = (qy >= s->min_y ? 0x3u : 0u) | (qy + 1 <= s->max_y ? 0xCu : 0u);
+
+        for (int qx = qx0; qx <= s->max_x; qx += 2) {
+            uint32_t lanes = row_mask;
+            if (qx < s->min_x) lanes &= 0xAu;
+            if (qx + 1 > s->max_x) lanes &= 0x5u;
+
+            uint32_t mask, covered = 0;
+            if (samples > 1) {
+                covered = quad_sample_coverage(e0, e1, e2, s->step_x, s->step_y, so) & msaa_lane_samples(lanes);
+                mask = msaa_sample_lanes(covered);
+            } else {
+                mask = quad_coverage(e0, e1, e2, s->step_x, s->step_y) & lanes;
+            }
+
+            uint32_t passed = 0;
+            // Quads inside the tile load and store all four lanes (no other thread
+            // touches them); quads straddling an odd-sized tile edge go lane by lane
+            int inside = qx >= s->tile_x0 && qx + 1 < s->tile_x1 && qy >= s->tile_y0 && qy + 1 < s->tile_y1;
+            if (samples > 1) {
+                // Sample storage is tile-local, so straddling quads need no special case
+                for (int lane = 0; lane < 4 && depth != DEPTH_OFF; lane++) {
+                    uint32_t hit = (covered >> (lane * 4)) & 0xFu;
+                    if (!hit) continue;
+                    float *d = &ms->depth[msaa_index(ms, qx + (lane & 1), qy + (lane >> 1))];
+                    f32x4 zs = z[lane] + zo, stored = f32x4_load(d);
+                    uint32_t pass = hit & i32x4_bits(depth == DEPTH_EQUAL ? zs == stored : zs < stored);
+                    if (depth == DEPTH_LESS) f32x4_store(d, f32x4_select(i32x4_from_bits(pass), zs, stored));
+                    covered ^= (hit ^ pass) << (lane * 4);
+                }
+                passed = msaa_sample_lanes(covered);
+            } else if (depth == DEPTH_OFF) {
+                passed = mask;
+            } else if (mask && inside) {
+                float *d0 = &r->depth_buffer[qy * width + qx], *d1 = d0 + width;
+                f32x4 stored = { d0[0], d0[1], d1[0], d1[1] };
+                passed = mask & i32x4_bits(depth == DEPTH_EQUAL ? z == stored : z < stored);
+                if (depth == DEPTH_LESS) {
+                    stored = f32x4_select(i32x4_from_bits(passed), z, stored);
+                    d0[0] = stored[0]; d0[1] = stored[1]; d1[0] = stored[2]; d1[1] = stored[3];
+                }
+            } else if (mask) {
+                for (int lane = 0; lane < 4; lane++) {
+                    if (!(mask & (1u << lane))) continue;
+                    int idx = (qy + (lane >> 1)) * width + qx + (lane & 1);
+                    if (depth == DEPTH_EQUAL ? z[lane] == r->depth_buffer[idx] : z[lane] < r->depth_buffer[idx]) {
+                        if (depth == DEPTH_LESS) r->depth_buffer[idx] = z[lane];
+                        passed |= 1u << lane;
+                    }
+                }
+            }
+            STATS_ONLY(tested += __builtin_popcount(mask);)
+
+            if (!shade) {
+                STATS_ONLY(shaded += __builtin_popcount(passed);)
+            } else if (passed) {
+                if (!planes_ready) { planes = quad_planes_setup(t, s, ox, oy); planes_ready = 1; }
+                float i = (float)((qx - qx0) >> 1), j = (float)((qy - qy0) >> 1);
+                f32x4 a[QA_COUNT];
+                for (int k = 0; k < QA_COUNT; k++) a[k] = planes.lanes[k] + (planes.step_x[k] * i + planes.step_y[k] * j);
+
+                if (bs->frags.count == FRAGMENT_BATCH) bs->dc->pipeline->flush(r, bs, thread);
+                FragmentBatch *fb = &bs->frags;
+                int n = fb->count, qi = n >> 2;
+                f32x4 w = 1.0f / a[QA_INV_W];
+                f32x4_store(&fb->b0[n], a[QA_B0]);
+                f32x4_store(&fb->b1[n], a[QA_B1]);
+                f32x4_store(&fb->b2[n], 1.0f - a[QA_B0] - a[QA_B1]);
+                f32x4_store(&fb->z[n], z);
+                f32x4_store(&fb->w[n], w);
+                f32x4_store(&fb->world_x[n], a[QA_WX] * w);
+                f32x4_store(&fb->world_y[n], a[QA_WY] * w);
+                f32x4_store(&fb->world_z[n], a[QA_WZ] * w);
+                f32x4_store(&fb->nx[n], a[QA_NX] * w);
+                f32x4_store(&fb->ny[n], a[QA_NY] * w);
+                f32x4_store(&fb->nz[n], a[QA_NZ] * w);
+                f32x4_store(&fb->u[n], a[QA_U] * w);
+                f32x4_store(&fb->v[n], a[QA_V] * w);
+                fb->tri[qi] = t; fb->x[qi] = qx; fb->y[qi] = qy;
+                if (samples > 1) bs->samples[qi] = (uint16_t)covered;
+                fb->mask |= (uint64_t)passed << n;
+                fb->count = n + 4;
+                STATS_ONLY(quads++; shaded += __builtin_popcount(passed); helpers += 4 - __builtin_popcount(passed);)
+            }
+
+            e0 += 2 * s->step_x[0]; e1 += 2 * s->step_x[1]; e2 += 2 * s->step_x[2];
+            z += 2.0f * s->z_step_x;
+        }
+
+        for (int i = 0; i < 3; i++) e_row[i] += 2 * s->step_y[i];
+        z_row += 2.0f * s->z_step_y;
+    }
+
+    STATS_ADD(r, thread, pixels_tested, tested);
+    STATS_ADD(r, thread, pixels_shaded, shaded);
+    STATS_ADD(r, thread, pixels_depth_rejected, tested - shaded);
+    STATS_ADD(r, thread, quads_shaded, quads);
+    STATS_ADD(r, thread, quad_helper_lanes, helpers);
+    (void)thread;
+}
+
+static void rasterize_triangle_in_tile(Renderer *r, Triangle *t, Tile *tile, BatchState *bs, int thread) {
+    DrawCall *dc = &r->draw_calls[t->draw_id];
+    if (dc->prepass && !dc->fragment_shader) return;   // Nothing left to do after the prepass
+    RasterSetup s;
+    if (!raster_setup(t, tile, &s)) return;
+
+    if (bs->dc != dc) {
+        if (bs->dc) bs->dc->pipeline->flush(r, bs, thread);
+        bs->dc = dc;
+    }
+    dc->pipeline->raster(r, t, bs, &s, thread);
+}
+
+void process_tile(Renderer *r, int tile_index, int thread) {
+    TRACE_BEGIN(tr_tile);
     Tile *tile = &r->tiles[tile_index];
+    BatchState bs;
+    bs.frags.count = 0;
+    bs.frags.mask = 0;
+    bs.dc = NULL;
+    MsaaTile *ms = r->msaa ? &r->msaa_tiles[thread] : NULL;
+    if (ms) msaa_begin(r, ms, tile);
+    // Pixels no opaque draw reaches this frame have nothing to reuse next frame
+    if (r->temporal) {
+        uint32_t *keys = r->temporal_cache->frames[r->temporal_cache->current].key;
+        for (int y = tile->y0; y < tile->y1; y++) {
+            memset(&keys[(size_t)y * r->screen_width + tile->x0], 0, (size_t)(tile->x1 - tile->x0) * sizeof(uint32_t));
+        }
+    }
+
+    // Prepass: the tile's final depth first, so the loop below shades each
+    // pixel of these draws once. Both passes step z the same way per triangle,
+    // so DEPTH_EQUAL matches exactly. Draws chose it when they were recorded,
+    // so toggling renderer_set_depth_prepass mid-frame cannot strand them.
+    if (r->prepass_draws) {
+        for (int i = 0; i < tile->triangle_count; i++) {
+            Triangle *t = &r->triangles[r->tile_tri_indices[tile->tri_offset + i]];
+            const PipelineKernels *k = r->draw_calls[t->draw_id].prepass;
+            RasterSetup s;
+            if (k && raster_setup(t, tile, &s)) k->raster(r, t, &bs, &s, thread);
+        }
+    }
+
     for (int i = 0; i < tile->triangle_count; i++) {
         int tri_idx = r->tile_tri_indices[tile->tri_offset + i];
-        rasterize_triangle_in_tile(r, &r->triangles[tri_idx], tile);
+        rasterize_triangle_in_tile(r, &r->triangles[tri_idx], tile, &bs, thread);
+    }
+    if (bs.dc) bs.dc->pipeline->flush(r, &bs, thread);
+    if (ms) msaa_resolve(r, ms, tile);
+
+    // Transparent triangles, once the tile's opaque colour and depth are final
+    if (tile->alpha_count > 0) {
+        OitArena *a = &r->oit[thread];
+        oit_begin(a, tile);
+        bs.dc = NULL;
+        for (int i = 0; i < tile->alpha_count; i++) {
+            int tri_idx = r->tile_tri_indices[tile->alpha_offset + i];
+            rasterize_triangle_in_tile(r, &r->triangles[tri_idx], tile, &bs, thread);
+        }
+        if (bs.dc) bs.dc->pipeline->flush(r, &bs, thread);
+        oit_resolve(r, a, tile, thread);
+    }
+
+    if (r->hdr) hdr_tonemap(r, tile);
+
+    // Tile passes while the finished tile is still in cache
+    TileRange rect = { tile->x0, tile->x1, tile->y0, tile->y1 };
+    for (int i = 0; i < r->post_pass_count; i++) {
+        const PostPass *p = &r->post_passes[i];
+        if (p->stage == POST_TILE) p->kernel(r->color_buffer, r->color_buffer, (int)r->screen_width, (int)r->screen_height, rect, p->params);
     }
+    TRACE_END(r, thread, TRACE_TILE, tile_index, tr_tile);
+}
+
+// One tile of the current halo pass, from color_buffer into post_buffer
+static void post_process_tile(Renderer *r, int tile_index, int thread) {
+    TRACE_BEGIN(tr_post);
+    const Tile *tile = &r->tiles[tile_index];
+    const PostPass *p = &r->post_passes[r->post_current];
+    TileRange rect = { tile->x0, tile->x1, tile->y0, tile->y1 };
+    p->kernel(r->color_buffer, r->post_buffer, (int)r->screen_width, (int)r->screen_height, rect, p->params);
+    TRACE_END(r, thread, TRACE_POST, tile_index, tr_post);
+    (void)thread;
 }
 
 void renderer_rasterize(Renderer* r) {
     atomic_store(&r->next_tile, 0);
     signal_workers(r, STAGE_RASTER);
 
+    STATS_TIMER_BEGIN(t_raster);
     while (1) {
         int idx = atomic_fetch_add(&r->next_tile, 1);
         if (idx >= (int)r->tile_count) break;
-        process_tile(r, idx); 
+        process_tile(r, idx, 0); 
     }
+    STATS_TIMER_END(r, 0, STAT_TIME_RASTER, t_raster);
     wait_for_workers(r);
+    if (r->temporal) r->temporal_cache->written = 1;
+
+    // Each halo pass reads the whole frame the previous one left, so each is
+    // a stage of its own, ping-ponging between the two buffers
+    for (int i = 0; i < r->post_pass_count; i++) {
+        if (r->post_passes[i].stage != POST_HALO) continue;
+        r->post_current = i;
+        atomic_store(&r->next_tile, 0);
+        signal_workers(r, STAGE_POST);
+
+        STATS_TIMER_BEGIN(t_post);
+        while (1) {
+            int idx = atomic_fetch_add(&r->next_tile, 1);
+            if (idx >= (int)r->tile_count) break;
+            post_process_tile(r, idx, 0);
+        }
+        STATS_TIMER_END(r, 0, STAT_TIME_POST, t_post);
+        wait_for_workers(r);
+
+        uint32_t *finished = r->post_buffer;
+        r->post_buffer = r->color_buffer;
+        r->color_buffer = finished;
+    }
 }
 
-/* --- 7. WORKER THREAD IMPLEMENTATION --- */
+/* --- 7. PIPELINE KERNELS --- */
+// Every supported state, each expanded into its own kernel. Each list passes
+// its leading arguments through, so the lists nest into the full cross product.
+// Adding a mode means a new enum value, a branch on it in the templates above
+// and an entry here.
+#define PIPELINE_SAMPLE_COUNTS(X, ...) X(__VA_ARGS__, 1) X(__VA_ARGS__, 4)
+#define PIPELINE_CULL_MODES(X, ...)  X(__VA_ARGS__, CULL_NONE) X(__VA_ARGS__, CULL_BACK_CCW) X(__VA_ARGS__, CULL_BACK_CW)
+#define PIPELINE_DEPTH_MODES(X, ...) X(__VA_ARGS__, DEPTH_LESS) X(__VA_ARGS__, DEPTH_LESS_NO_WRITE) \
+                                     X(__VA_ARGS__, DEPTH_EQUAL) X(__VA_ARGS__, DEPTH_OFF)
+#define PIPELINE_BLEND_MODES(X, ...) X(__VA_ARGS__, BLEND_OPAQUE) X(__VA_ARGS__, BLEND_ADD) X(__VA_ARGS__, BLEND_ALPHA)
+
+#define DEFINE_ASSEMBLE(_, cull) \
+    static void assemble_##cull(Renderer *r, int dc_idx, int thread) { assemble_triangles(r, dc_idx, thread, cull); }
+#define DEFINE_FLUSH(samples, blend) \
+    static void flush_##blend##_##samples(Renderer *r, BatchState *bs, int thread) { flush_batch(r, bs, thread, blend, samples); }
+#define DEFINE_RASTER(samples, depth) \
+    static void raster_##depth##_##samples(Renderer *r, Triangle *t, BatchState *bs, const RasterSetup *s, int thread) { \
+        rasterize_quads(r, t, bs, s, thread, depth, 1, samples); \
+    } \
+    static void raster_##depth##_only_##samples(Renderer *r, Triangle *t, BatchState *bs, const RasterSetup *s, int thread) { \
+        rasterize_quads(r, t, bs, s, thread, depth, 0, samples); \
+    }
+#define DEFINE_SAMPLE_KERNELS(_, samples) PIPELINE_BLEND_MODES(DEFINE_FLUSH, samples) PIPELINE_DEPTH_MODES(DEFINE_RASTER, samples)
+
+PIPELINE_CULL_MODES(DEFINE_ASSEMBLE, _)
+PIPELINE_SAMPLE_COUNTS(DEFINE_SAMPLE_KERNELS, _)
+
+// [msaa][cull][depth][blend]
+#define PIPELINE_KERNELS(samples, cull, depth, blend) \
+    [samples > 1][cull][depth][blend] = { assemble_##cull, raster_##depth##_##samples, flush_##blend##_##samples },
+#define PIPELINE_KERNELS_DEPTH(samples, cull, depth) PIPELINE_BLEND_MODES(PIPELINE_KERNELS, samples, cull, depth)
+#define PIPELINE_KERNELS_CULL(samples, cull)         PIPELINE_DEPTH_MODES(PIPELINE_KERNELS_DEPTH, samples, cull)
+#define PIPELINE_KERNELS_SAMPLES(_, samples)         PIPELINE_CULL_MODES(PIPELINE_KERNELS_CULL, samples)
+static const PipelineKernels pipeline_kernels[2][CULL_BACK_CW + 1][DEPTH_OFF + 1][BLEND_ALPHA + 1] = {
+    PIPELINE_SAMPLE_COUNTS(PIPELINE_KERNELS_SAMPLES, _)
+};
+
+// [msaa][cull][depth] for draws without a fragment shader; their batch is never filled
+#define PIPELINE_DEPTH_KERNELS(samples, cull, depth) \
+    [samples > 1][cull][depth] = { assemble_##cull, raster_##depth##_only_##samples, flush_BLEND_OPAQUE_##samples },
+#define PIPELINE_DEPTH_KERNELS_CULL(samples, cull)   PIPELINE_DEPTH_MODES(PIPELINE_DEPTH_KERNELS, samples, cull)
+#define PIPELINE_DEPTH_KERNELS_SAMPLES(_, samples)   PIPELINE_CULL_MODES(PIPELINE_DEPTH_KERNELS_CULL, samples)
+static const PipelineKernels pipeline_depth_kernels[2][CULL_BACK_CW + 1][DEPTH_OFF + 1] = {
+    PIPELINE_SAMPLE_COUNTS(PIPELINE_DEPTH_KERNELS_SAMPLES, _)
+};
+
+static const PipelineKernels* pipeline_kernels_get(CullMode cull, DepthMode depth, BlendMode blend, int depth_only, int msaa) {
+    msaa = msaa != 0;
+    return depth_only ? &pipeline_depth_kernels[msaa][cull][depth] : &pipeline_kernels[msaa][cull][depth][blend];
+}
+
+/* --- 8. WORKER THREAD IMPLEMENTATION --- */
 static void* renderer_worker_thread(void* data) {
     Renderer* r = (Renderer*)data;
+    int thread = atomic_fetch_add(&r->next_worker_id, 1) + 1; // 0 is the main thread
     while (1) {
         pthread_mutex_lock(&r->lock);
         while (r->stage == STAGE_IDLE && !r->shutdown) {
@@ -416,32 +1468,44 @@ static void* renderer_worker_thread(void* data) {
         RenderStage current_stage = r->stage;
         pthread_mutex_unlock(&r->lock);
 
+        STATS_TIMER_BEGIN(t_stage);
         if (current_stage == STAGE_VERTEX) {
             while (1) {
                 int idx = atomic_fetch_add(&r->next_draw_call, 1);
                 if (idx >= (int)r->draw_call_count) break;
-                process_draw_call_vertices(r, idx);
+                process_draw_call_vertices(r, idx, thread);
             }
+            STATS_TIMER_END(r, thread, STAT_TIME_VERTEX, t_stage);
         } else if (current_stage == STAGE_ASSEMBLE) {
             while (1) {
                 int idx = atomic_fetch_add(&r->next_draw_call, 1);
                 if (idx >= (int)r->draw_call_count) break;
-                process_draw_call_triangles(r, idx);
+                process_draw_call_triangles(r, idx, thread);
             }
+            STATS_TIMER_END(r, thread, STAT_TIME_ASSEMBLE, t_stage);
         } else if (current_stage == STAGE_RASTER) {
             while (1) {
                 int idx = atomic_fetch_add(&r->next_tile, 1);
                 if (idx >= (int)r->tile_count) break;
-                process_tile(r, idx);
+                process_tile(r, idx, thread);
+            }
+            STATS_TIMER_END(r, thread, STAT_TIME_RASTER, t_stage);
+        } else if (current_stage == STAGE_POST) {
+            while (1) {
+                int idx = atomic_fetch_add(&r->next_tile, 1);
+                if (idx >= (int)r->tile_count) break;
+                post_process_tile(r, idx, thread);
             }
+            STATS_TIMER_END(r, thread, STAT_TIME_POST, t_stage);
         }
 
         pthread_mutex_lock(&r->lock);
         int vertex_done = (current_stage == STAGE_VERTEX && atomic_load(&r->next_draw_call) >= (int)r->draw_call_count);
         int assemble_done = (current_stage == STAGE_ASSEMBLE && atomic_load(&r->next_draw_call) >= (int)r->draw_call_count);
         int raster_done = (current_stage == STAGE_RASTER && atomic_load(&r->next_tile) >= (int)r->tile_count);
+        int post_done = (current_stage == STAGE_POST && atomic_load(&r->next_tile) >= (int)r->tile_count);
         
-        if (vertex_done || assemble_done || raster_done) {
+        if (vertex_done || assemble_done || raster_done || post_done) {
             if (r->stage != STAGE_IDLE) {
                 r->stage = STAGE_IDLE;
             }
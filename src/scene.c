@@ -1,47 +1,247 @@
 #include "scene.h"
+#include "frustum.h"
 #include <stdlib.h>
 #include <string.h>
+#include <stdio.h>
+
+// Every array of the store, for growing and freeing them together
+#define ENTITY_STORE_FIELDS(X) \
+    X(pos_x) X(pos_y) X(pos_z) X(rot_x) X(rot_y) X(rot_z) X(scale) X(color) \
+    X(opacity) X(visible) X(dirty) X(model) X(bounds_mesh) X(world_center) X(world_radius) \
+    X(world_min) X(world_max) X(mesh) X(asset) X(texture) X(vs) X(fs)
+
+static void entity_store_reserve(EntityStore *st, size_t capacity) {
+    if (capacity <= st->capacity) return;
+    st->capacity = capacity;
+#define GROW(f) st->f = realloc(st->f, capacity * sizeof(*st->f));
+    ENTITY_STORE_FIELDS(GROW)
+#undef GROW
+}
+
+static void entity_store_free(EntityStore *st) {
+#define FREE(f) free(st->f);
+    ENTITY_STORE_FIELDS(FREE)
+#undef FREE
+    memset(st, 0, sizeof(*st));
+}
 
 Scene* scene_create(size_t initial_capacity) {
     Scene *s = calloc(1, sizeof(Scene));
-    s->entity_capacity = initial_capacity > 0 ? initial_capacity : 16;
-    s->entities = malloc(s->entity_capacity * sizeof(Entity));
+    entity_store_reserve(&s->entities, initial_capacity > 0 ? initial_capacity : 16);
+    s->lod_error_pixels = 1.0f;
+    s->light_threshold = SCENE_LIGHT_THRESHOLD;
+    pthread_mutex_init(&s->streamer.lock, NULL);
+    pthread_cond_init(&s->streamer.wake, NULL);
+    pthread_cond_init(&s->streamer.idle, NULL);
     return s;
 }
 
+static void streamer_stop(MeshStreamer *st) {
+    if (!st->running) return;
+    pthread_mutex_lock(&st->lock);
+    st->shutdown = 1;
+    pthread_cond_signal(&st->wake);
+    pthread_mutex_unlock(&st->lock);
+    pthread_join(st->thread, NULL);
+    st->running = 0;
+}
+
 void scene_destroy(Scene* scene) {
     if (!scene) return;
-    
+
+    // The request in flight finishes; anything still queued is dropped
+    streamer_stop(&scene->streamer);
+
     for (size_t i = 0; i < scene->mesh_count; i++) {
-        free_mesh(&scene->meshes[i]);
+        SceneMesh *entry = scene->meshes[i];
+        if (atomic_load(&entry->state) == MESH_READY) {
+            mesh_free_lods(&entry->lods);
+            free_mesh(&entry->mesh);
+        }
+        free(entry->path);
+        free(entry);
     }
+    free(scene->meshes);
 
-    free(scene->entities);
+    for (size_t i = 0; i < scene->texture_count; i++) texture_destroy(scene->textures[i]);
+    free(scene->textures);
+
+    free(scene->cull.radius); free(scene->cull.meshes); free(scene->cull.result);
+    free(scene->cull.visible); free(scene->cull.mvps);
+    free(scene->cull.light_first); free(scene->cull.light_count);
+    free(scene->light_chunks);
+    bvh_free(&scene->entity_bvh);
+    bvh_free(&scene->light_bvh);
+
+    pthread_mutex_destroy(&scene->streamer.lock);
+    pthread_cond_destroy(&scene->streamer.wake);
+    pthread_cond_destroy(&scene->streamer.idle);
+    entity_store_free(&scene->entities);
     free(scene);
 }
 
+// --- Mesh Registry ---
+static SceneMesh* scene_add_mesh_entry(Scene* scene, const char* filepath, const Mesh* proxy, unsigned flags) {
+    if (scene->mesh_count >= scene->mesh_capacity) {
+        scene->mesh_capacity = scene->mesh_capacity ? scene->mesh_capacity * 2 : 16;
+        scene->meshes = realloc(scene->meshes, scene->mesh_capacity * sizeof(SceneMesh*));
+    }
+    SceneMesh *entry = calloc(1, sizeof(SceneMesh));
+    entry->path = strdup(filepath);
+    entry->proxy = proxy;
+    entry->flags = flags;
+    atomic_init(&entry->state, MESH_LOADING);
+    scene->meshes[scene->mesh_count++] = entry;
+    return entry;
+}
+
+static SceneMesh* scene_find_mesh_entry(const Scene* scene, const Mesh* mesh) {
+    for (size_t i = 0; i < scene->mesh_count; i++) {
+        if (&scene->meshes[i]->mesh == mesh) return scene->meshes[i];
+    }
+    return NULL;
+}
+
+static void scene_mesh_load_now(SceneMesh *entry) {
+    Mesh m = load_mesh(entry->path);
+    if (m.index_count == 0) {
+        free_mesh(&m);
+        atomic_store_explicit(&entry->state, MESH_FAILED, memory_order_release);
+        return;
+    }
+    if (entry->flags & MESH_LOAD_CENTER_ORIGIN) mesh_center_origin(&m);
+    if (entry->flags & MESH_LOAD_BUILD_LODS) mesh_build_lods(&m, &entry->lods);
+    entry->mesh = m;
+    atomic_store_explicit(&entry->state, MESH_READY, memory_order_release);
+}
+
+static void* streamer_main(void *arg) {
+    MeshStreamer *st = arg;
+    pthread_mutex_lock(&st->lock);
+    while (1) {
+        while (!st->head && !st->shutdown) pthread_cond_wait(&st->wake, &st->lock);
+        if (st->shutdown) break;
+
+        SceneMesh *entry = st->head;
+        st->head = entry->next_pending;
+        if (!st->head) st->tail = NULL;
+        st->busy = 1;
+        pthread_mutex_unlock(&st->lock);
+
+        scene_mesh_load_now(entry);
+
+        pthread_mutex_lock(&st->lock);
+        st->busy = 0;
+        if (!st->head) pthread_cond_broadcast(&st->idle);
+    }
+    pthread_cond_broadcast(&st->idle);
+    pthread_mutex_unlock(&st->lock);
+    return NULL;
+}
+
 Mesh* scene_load_mesh(Scene* scene, const char* filepath) {
-    if (scene->mesh_count >= MAX_SCENE_MESHES) return NULL;
-    Mesh m = load_mesh(filepath);
-    scene->meshes[scene->mesh_count] = m;
-    return &scene->meshes[scene->mesh_count++];
+    SceneMesh *entry = scene_add_mesh_entry(scene, filepath, NULL, 0);
+    scene_mesh_load_now(entry);
+    return &entry->mesh;
+}
+
+Mesh* scene_load_mesh_async(Scene* scene, const char* filepath, const Mesh* proxy, unsigned flags) {
+    MeshStreamer *st = &scene->streamer;
+    SceneMesh *entry = scene_add_mesh_entry(scene, filepath, proxy, flags);
+
+    pthread_mutex_lock(&st->lock);
+    if (!st->running) {
+        if (pthread_create(&st->thread, NULL, streamer_main, st) != 0) {
+            pthread_mutex_unlock(&st->lock);
+            fprintf(stderr, "Failed to start mesh loader, loading %s synchronously\n", filepath);
+            scene_mesh_load_now(entry);
+            return &entry->mesh;
+        }
+        st->running = 1;
+    }
+    if (st->tail) st->tail->next_pending = entry;
+    else st->head = entry;
+    st->tail = entry;
+    pthread_cond_signal(&st->wake);
+    pthread_mutex_unlock(&st->lock);
+    return &entry->mesh;
+}
+
+MeshLoadState scene_mesh_state(const Scene* scene, const Mesh* mesh) {
+    SceneMesh *entry = scene_find_mesh_entry(scene, mesh);
+    if (!entry) return mesh && mesh->index_count > 0 ? MESH_READY : MESH_FAILED;
+    return (MeshLoadState)atomic_load_explicit(&entry->state, memory_order_acquire);
+}
+
+void scene_wait_for_meshes(Scene* scene) {
+    MeshStreamer *st = &scene->streamer;
+    if (!st->running) return;
+    pthread_mutex_lock(&st->lock);
+    while (st->head || st->busy) pthread_cond_wait(&st->idle, &st->lock);
+    pthread_mutex_unlock(&st->lock);
 }
 
-Entity* scene_add_entity(Scene* scene, Mesh* mesh, vec3 pos, vec3 rot, float scale, vec3 color) {
-    if (scene->entity_count >= scene->entity_capacity) {
-        scene->entity_capacity *= 2;
-        scene->entities = realloc(scene->entities, scene->entity_capacity * sizeof(Entity));
+// For meshes loaded synchronously; call before the mesh is first rendered
+int scene_build_lods(Scene* scene, Mesh* mesh) {
+    SceneMesh *entry = scene_find_mesh_entry(scene, mesh);
+    if (!entry || atomic_load(&entry->state) != MESH_READY) return 0;
+    mesh_free_lods(&entry->lods);
+    return mesh_build_lods(&entry->mesh, &entry->lods);
+}
+
+Texture* scene_load_texture(Scene* scene, const char* filepath) {
+    Texture *tex = texture_load(filepath);
+    if (!tex) return NULL;
+    if (scene->texture_count >= scene->texture_capacity) {
+        scene->texture_capacity = scene->texture_capacity ? scene->texture_capacity * 2 : 8;
+        scene->textures = realloc(scene->textures, scene->texture_capacity * sizeof(Texture*));
+    }
+    scene->textures[scene->texture_count++] = tex;
+    return tex;
+}
+
+// Mesh an entity should draw this frame: the asset once loaded, else its proxy
+static const Mesh* entity_resolve_mesh(const EntityStore *st, EntityHandle h) {
+    const SceneMesh *asset = st->asset[h];
+    if (!asset) return st->mesh[h];
+    switch (atomic_load_explicit(&asset->state, memory_order_acquire)) {
+        case MESH_READY:   return &asset->mesh;
+        case MESH_LOADING: return asset->proxy;
+        default:           return NULL;
     }
-    Entity *e = &scene->entities[scene->entity_count++];
-    e->mesh = mesh;
-    e->position = pos;
-    e->rotation = rot;
-    e->scale = scale;
-    e->base_color = color;
-    e->vs = vs_default;
-    e->fs = fs_multi_light; 
-    e->visible = true;
-    return e;
+}
+
+// `nearest_depth` is the closest view depth of the bounding sphere;
+// `pixels_per_unit` is the screen-space size of one world unit at distance 1
+static const Mesh* entity_select_lod(const EntityStore *st, EntityHandle h, const Mesh *mesh, float nearest_depth, float pixels_per_unit, float max_error_px) {
+    const SceneMesh *asset = st->asset[h];
+    if (!asset || mesh != &asset->mesh || nearest_depth <= 0.0f) return mesh;
+    const MeshLODChain *lods = &asset->lods;
+    float px_per_error = st->scale[h] * pixels_per_unit / nearest_depth;
+    for (int i = lods->count - 1; i >= 0; i--) {
+        if (lods->rms_error[i] * px_per_error <= max_error_px) return &lods->levels[i];
+    }
+    return mesh;
+}
+
+EntityHandle scene_add_entity(Scene* scene, Mesh* mesh, vec3 pos, vec3 rot, float scale, vec3 color) {
+    EntityStore *st = &scene->entities;
+    if (st->count >= st->capacity) entity_store_reserve(st, st->capacity ? st->capacity * 2 : 16);
+    EntityHandle h = (EntityHandle)st->count++;
+    st->mesh[h] = mesh;
+    st->asset[h] = scene_find_mesh_entry(scene, mesh);
+    st->texture[h] = NULL;
+    st->pos_x[h] = pos.x; st->pos_y[h] = pos.y; st->pos_z[h] = pos.z;
+    st->rot_x[h] = rot.x; st->rot_y[h] = rot.y; st->rot_z[h] = rot.z;
+    st->scale[h] = scale;
+    st->color[h] = color;
+    st->opacity[h] = 1.0f;
+    st->vs[h] = vs_default;
+    st->fs[h] = fs_multi_light;
+    st->visible[h] = 1;
+    st->dirty[h] = 1;
+    st->bounds_mesh[h] = NULL;
+    return h;
 }
 
 PointLight* scene_add_light(Scene* scene, vec3 pos, vec3 color, float intensity) {
@@ -50,9 +250,392 @@ PointLight* scene_add_light(Scene* scene, vec3 pos, vec3 color, float intensity)
     l->position = pos;
     l->color = color;
     l->intensity = intensity;
+    l->radius = light_radius(intensity, scene->light_threshold);
     return l;
 }
 
+static void scene_reserve_cull(Scene* scene, size_t count) {
+    EntityCullScratch *c = &scene->cull;
+    if (count <= c->capacity) return;
+    c->capacity = count + count / 2;
+    c->radius = realloc(c->radius, c->capacity * sizeof(float));
+    c->meshes = realloc(c->meshes, c->capacity * sizeof(const Mesh*));
+    c->result = realloc(c->result, c->capacity);
+    c->visible = realloc(c->visible, c->capacity * sizeof(uint32_t));
+    c->mvps = realloc(c->mvps, c->capacity * sizeof(mat4));
+    c->light_first = realloc(c->light_first, c->capacity * sizeof(uint32_t));
+    c->light_count = realloc(c->light_count, c->capacity * sizeof(uint32_t));
+}
+
+// Rebuilds the model matrix of the dirty entities among `ids` and writes
+// view_proj * model for all of them, SIMD_WIDTH entities per iteration with
+// one vector per matrix element. M = T * Rz * Ry * Rx * S is expanded element
+// by element in mat4_mul's summation order, so it matches the composed product.
+static void entity_store_transform(EntityStore *st, const uint32_t *ids, size_t count, mat4 view_proj, mat4 *out_mvp) {
+    f32x8 vp[4][4];
+    for (int c = 0; c < 4; c++)
+        for (int r = 0; r < 4; r++) vp[c][r] = f32x8_splat(view_proj.m[c][r]);
+
+    for (size_t base = 0; base < count; base += SIMD_WIDTH) {
+        size_t n = MIN(count - base, (size_t)SIMD_WIDTH);
+        uint32_t id[SIMD_WIDTH];
+        int dirty = 0;
+        for (size_t l = 0; l < SIMD_WIDTH; l++) id[l] = ids[base + MIN(l, n - 1)]; // Tail lanes repeat the last entity
+        for (size_t l = 0; l < n; l++) dirty |= st->dirty[id[l]];
+
+        f32x8 m[4][4];
+        if (dirty) {
+            float sx[SIMD_WIDTH], cx[SIMD_WIDTH], sy[SIMD_WIDTH], cy[SIMD_WIDTH], sz[SIMD_WIDTH], cz[SIMD_WIDTH];
+            float scale[SIMD_WIDTH], px[SIMD_WIDTH], py[SIMD_WIDTH], pz[SIMD_WIDTH];
+            for (size_t l = 0; l < SIMD_WIDTH; l++) {
+                uint32_t h = id[l];
+                sx[l] = sinf(st->rot_x[h]); cx[l] = cosf(st->rot_x[h]);
+                sy[l] = sinf(st->rot_y[h]); cy[l] = cosf(st->rot_y[h]);
+                sz[l] = sinf(st->rot_z[h]); cz[l] = cosf(st->rot_z[h]);
+                scale[l] = st->scale[h];
+                px[l] = st->pos_x[h]; py[l] = st->pos_y[h]; pz[l] = st->pos_z[h];
+            }
+            f32x8 Sx = f32x8_load(sx), Cx = f32x8_load(cx), Sy = f32x8_load(sy), Cy = f32x8_load(cy);
+            f32x8 Sz = f32x8_load(sz), Cz = f32x8_load(cz), S = f32x8_load(scale), zero = f32x8_splat(0.0f);
+
+            // Columns of Ry * Rx, then of Rz * (Ry * Rx)
+            f32x8 a[3][3] = {
+                { Cy,       zero, Sy      },
+                { -Sy * Sx, Cx,   Cy * Sx },
+                { -Sy * Cx, -Sx,  Cy * Cx },
+            };
+            for (int c = 0; c < 3; c++) {
+                m[c][0] = (Cz * a[c][0] + -Sz * a[c][1]) * S;
+                m[c][1] = (Sz * a[c][0] + Cz * a[c][1]) * S;
+                m[c][2] = a[c][2] * S;
+                m[c][3] = zero;
+            }
+            m[3][0] = f32x8_load(px); m[3][1] = f32x8_load(py); m[3][2] = f32x8_load(pz);
+            m[3][3] = f32x8_splat(1.0f);
+
+            for (size_t l = 0; l < n; l++) {
+                uint32_t h = id[l];
+                for (int c = 0; c < 4; c++)
+                    for (int r = 0; r < 4; r++) st->model[h].m[c][r] = m[c][r][l];
+                st->dirty[h] = 0;
+                st->bounds_mesh[h] = NULL;
+            }
+        } else {
+            for (int c = 0; c < 4; c++)
+                for (int r = 0; r < 4; r++)
+                    for (size_t l = 0; l < SIMD_WIDTH; l++) m[c][r][l] = st->model[id[l]].m[c][r];
+        }
+
+        for (int c = 0; c < 4; c++) {
+            for (int r = 0; r < 4; r++) {
+                f32x8 v = vp[0][r] * m[c][0] + vp[1][r] * m[c][1] + vp[2][r] * m[c][2] + vp[3][r] * m[c][3];
+                for (size_t l = 0; l < n; l++) out_mvp[base + l].m[c][r] = v[l];
+            }
+        }
+    }
+}
+
+// World bounding sphere of `mesh` under the entity's current model matrix
+static void entity_update_bounds(EntityStore *st, EntityHandle h, const Mesh *mesh) {
+    if (st->bounds_mesh[h] == mesh) return;
+    vec4 c = mat4_mul_vec4(st->model[h], (vec4){mesh->bounds.center.x, mesh->bounds.center.y, mesh->bounds.center.z, 1.0f});
+    st->world_center[h] = (vec3){c.x, c.y, c.z};
+    st->world_radius[h] = mesh->bounds_radius * fabsf(st->scale[h]);
+
+    // Half extents of the rotated box: |M| applied to the local ones
+    const mat4 *m = &st->model[h];
+    vec3 e = vec3_mul(vec3_sub(mesh->bounds.max, mesh->bounds.min), 0.5f);
+    vec3 we = {
+        fabsf(m->m[0][0]) * e.x + fabsf(m->m[1][0]) * e.y + fabsf(m->m[2][0]) * e.z,
+        fabsf(m->m[0][1]) * e.x + fabsf(m->m[1][1]) * e.y + fabsf(m->m[2][1]) * e.z,
+        fabsf(m->m[0][2]) * e.x + fabsf(m->m[1][2]) * e.y + fabsf(m->m[2][2]) * e.z
+    };
+    st->world_min[h] = vec3_sub(st->world_center[h], we);
+    st->world_max[h] = vec3_add(st->world_center[h], we);
+    st->bounds_mesh[h] = mesh;
+}
+
+// Renderer tiles covered by the projection of a world box; every tile when the
+// box reaches behind the camera, an empty range when it is off screen
+static TileRange scene_tile_range(const Renderer *r, mat4 view_proj, vec3 lo, vec3 hi) {
+    TileRange all = { 0, (int)r->tile_count_x - 1, 0, (int)r->tile_count_y - 1 };
+    float min_x = 1.0f, max_x = -1.0f, min_y = 1.0f, max_y = -1.0f;
+    for (int c = 0; c < 8; c++) {
+        vec4 p = mat4_mul_vec4(view_proj, (vec4){ (c & 1) ? hi.x : lo.x, (c & 2) ? hi.y : lo.y, (c & 4) ? hi.z : lo.z, 1.0f });
+        if (p.w <= 1e-4f) return all;
+        float x = p.x / p.w, y = p.y / p.w;
+        if (c == 0) { min_x = max_x = x; min_y = max_y = y; continue; }
+        min_x = MIN(min_x, x); max_x = MAX(max_x, x);
+        min_y = MIN(min_y, y); max_y = MAX(max_y, y);
+    }
+    if (max_x < -1.0f || min_x > 1.0f || max_y < -1.0f || min_y > 1.0f) return (TileRange){ 0, -1, 0, -1 };
+
+    // Same NDC-to-pixel mapping as the vertex stage, y flipped
+    float sx = 0.5f * (float)r->screen_width, sy = 0.5f * (float)r->screen_height;
+    TileRange t = {
+        (int)((MAX(min_x, -1.0f) + 1.0f) * sx) / r->tile_width,  (int)((MIN(max_x, 1.0f) + 1.0f) * sx) / r->tile_width,
+        (int)((1.0f - MIN(max_y, 1.0f)) * sy) / r->tile_height, (int)((1.0f - MAX(min_y, -1.0f)) * sy) / r->tile_height
+    };
+    t.x1 = MIN(t.x1, all.x1); t.y1 = MIN(t.y1, all.y1);
+    return t;
+}
+
+static inline int tile_ranges_overlap(TileRange a, TileRange b) {
+    return a.x0 <= b.x1 && b.x0 <= a.x1 && a.y0 <= b.y1 && b.y0 <= a.y1;
+}
+
+// Radii follow the current intensities, so game logic may animate them freely
+static void light_buffer_build(Scene* scene, const Renderer *r, mat4 view_proj) {
+    LightBuffer *lb = &scene->light_buffer;
+    for (size_t i = 0; i < scene->light_count; i++) {
+        PointLight *l = &scene->lights[i];
+        l->radius = light_radius(l->intensity, scene->light_threshold);
+        lb->x[i] = l->position.x; lb->y[i] = l->position.y; lb->z[i] = l->position.z;
+        lb->r[i] = l->color.x; lb->g[i] = l->color.y; lb->b[i] = l->color.z;
+        lb->intensity[i] = l->intensity;
+        lb->radius[i] = l->radius;
+        vec3 extent = { l->radius, l->radius, l->radius };
+        lb->tiles[i] = scene_tile_range(r, view_proj, vec3_sub(l->position, extent), vec3_add(l->position, extent));
+        lb->shadow[i] = NULL;
+    }
+    lb->count = scene->light_count;
+}
+
+// Appends `count` lights to the frame's chunks, padded to whole chunks, and
+// returns the index of the first one
+static uint32_t scene_gather_lights(Scene* scene, const uint32_t *ids, size_t count) {
+    size_t chunks = (count + SIMD_WIDTH - 1) / SIMD_WIDTH;
+    if (scene->light_chunk_count + chunks > scene->light_chunk_capacity) {
+        scene->light_chunk_capacity = (scene->light_chunk_count + chunks) * 2;
+        scene->light_chunks = realloc(scene->light_chunks, scene->light_chunk_capacity * sizeof(LightChunk));
+    }
+
+    const LightBuffer *lb = &scene->light_buffer;
+    uint32_t first = (uint32_t)scene->light_chunk_count;
+    LightChunk *out = scene->light_chunks + first;
+    for (size_t i = 0; i < chunks * SIMD_WIDTH; i++) {
+        LightChunk *c = &out[i / SIMD_WIDTH];
+        size_t j = i % SIMD_WIDTH;
+        if (i < count) {
+            uint32_t id = ids[i];
+            c->x[j] = lb->x[id]; c->y[j] = lb->y[id]; c->z[j] = lb->z[id];
+            c->r[j] = lb->r[id]; c->g[j] = lb->g[id]; c->b[j] = lb->b[id];
+            c->intensity[j] = lb->intensity[id];
+            c->radius[j] = lb->radius[id];
+            c->shadow[j] = lb->shadow[id];
+        } else {
+            // Far enough to fail every range test, finite so fast-math stays valid
+            c->x[j] = c->y[j] = c->z[j] = 1e18f;
+            c->r[j] = c->g[j] = c->b[j] = 0.0f;
+            c->intensity[j] = 0.0f;
+            c->radius[j] = 1.0f;
+            c->shadow[j] = NULL;
+        }
+    }
+    scene->light_chunk_count += chunks;
+    return first;
+}
+
+// Whether a sphere at offset d from a cube's centre can reach face f. Each
+// face condition s * d_a >= |d_b| is Lipschitz with constant sqrt(2).
+static inline int cube_face_touches(int f, vec3 d, float radius) {
+    float v[3] = { d.x, d.y, d.z };
+    int a = f >> 1;
+    float along = (f & 1) ? -v[a] : v[a];
+    float side = MAX(fabsf(v[(a + 1) % 3]), fabsf(v[(a + 2) % 3]));
+    return along - side >= -1.415f * radius;
+}
+
+// Draws every shadow caster inside view_proj into `m` with the depth-only shaders
+static void scene_render_shadow_map(Scene* scene, ShadowMap *m, mat4 view_proj, float texel_world) {
+    EntityStore *st = &scene->entities;
+    EntityCullScratch *cull = &scene->cull;
+    Frustum frustum;
+    frustum_from_matrix(&frustum, view_proj);
+    memset(cull->result, FRUSTUM_OUTSIDE, st->count);
+    bvh_query_frustum(&scene->entity_bvh, &frustum, cull->result);
+    size_t count = 0;
+    for (size_t i = 0; i < st->count; i++) {
+        if (cull->result[i] != FRUSTUM_OUTSIDE) cull->visible[count++] = (uint32_t)i;
+    }
+    entity_store_transform(st, cull->visible, count, view_proj, cull->mvps);
+
+    Renderer *r = scene->shadows->renderer;
+    shadow_map_begin(scene->shadows, m, view_proj, texel_world);
+    renderer_set_shaders(r, vs_depth, NULL);
+    for (size_t k = 0; k < count; k++) {
+        EntityHandle h = cull->visible[k];
+        Uniforms u = {0};
+        u.model = st->model[h];
+        u.mvp = cull->mvps[k];
+        renderer_set_uniforms(r, &u);
+        renderer_draw_mesh(r, (Mesh*)cull->meshes[h]);
+    }
+    shadow_map_end(scene->shadows, m);
+}
+
+// Assigns cubes to shadowed lights, marks maps that movers or light changes
+// made stale, and re-renders as many as the budget allows: cascades first,
+// then cube faces round-robin. Runs after the entity hierarchy is refitted
+// and before the main pass, whose culling scratch it borrows.
+static void scene_update_shadows(Scene* scene, float aspect) {
+    ShadowSystem *sys = scene->shadows;
+    EntityStore *st = &scene->entities;
+    EntityCullScratch *cull = &scene->cull;
+    LightBuffer *lb = &scene->light_buffer;
+
+    // 1. Cubes follow casts_shadows; a light keeps its cube until it stops asking
+    for (int c = 0; c < SHADOW_MAX_CUBES; c++) {
+        ShadowCube *cube = &sys->cubes[c];
+        if (cube->light >= 0 && ((size_t)cube->light >= scene->light_count || !scene->lights[cube->light].casts_shadows)) {
+            shadow_cube_assign(cube, -1);
+        }
+        if (cube->light >= 0) lb->shadow[cube->light] = cube;
+    }
+    for (size_t i = 0; i < scene->light_count; i++) {
+        if (!scene->lights[i].casts_shadows || lb->shadow[i]) continue;
+        for (int c = 0; c < SHADOW_MAX_CUBES; c++) {
+            if (sys->cubes[c].light >= 0) continue;
+            shadow_cube_assign(&sys->cubes[c], (int)i);
+            lb->shadow[i] = &sys->cubes[c];
+            break;
+        }
+    }
+    for (int c = 0; c < SHADOW_MAX_CUBES; c++) {
+        ShadowCube *cube = &sys->cubes[c];
+        if (cube->light < 0) continue;
+        const PointLight *l = &scene->lights[cube->light];
+        if (l->radius <= 0.0f) { lb->shadow[cube->light] = NULL; continue; }
+        if (l->radius > cube->far || l->position.x != cube->position.x ||
+            l->position.y != cube->position.y || l->position.z != cube->position.z) {
+            cube->position = l->position;
+            cube->far = l->radius * 1.25f;   // Headroom, so a brightening light does not invalidate every frame
+            cube->pending = (1u << SHADOW_CUBE_FACES) - 1;
+        }
+    }
+
+    // 2. Cascades refit to the current camera and sun every frame; one whose
+    // texel-snapped bounds moved is stale as a whole
+    ShadowCascades *sun = &sys->sun;
+    int sun_active = scene->sun.intensity > 0.0f && scene->entity_bvh.node_count > 0;
+    mat4 cascade_vp[SHADOW_CASCADES];
+    Frustum cascade_box[SHADOW_CASCADES];
+    if (sun_active) {
+        sun->cam_pos = scene->camera.position;
+        sun->cam_forward = vec3_norm(vec3_sub(scene->camera.target, scene->camera.position));
+        sun->to_light = vec3_norm(vec3_mul(scene->sun.direction, -1.0f));
+        const BvhNode *root = &scene->entity_bvh.nodes[0];
+        for (int i = 0; i < SHADOW_CASCADES; i++) {
+            cascade_vp[i] = shadow_cascade_matrix(sun, i, sys, &scene->camera, aspect, root->min, root->max);
+            if (memcmp(&cascade_vp[i], &sun->maps[i].view_proj, sizeof(mat4)) != 0) sun->pending |= 1u << i;
+            frustum_from_matrix(&cascade_box[i], sun->maps[i].view_proj);
+        }
+    }
+
+    // 3. Movers dirty the cube faces and cascades their old and new spheres
+    // reach. They are transformed here, so each move invalidates once even if
+    // no view draws them.
+    size_t movers = 0;
+    for (size_t i = 0; i < st->count; i++) {
+        if (!st->dirty[i] || cull->radius[i] <= 0.0f) continue;
+        vec3 center[2] = { scene_entity_position(scene, (EntityHandle)i), { 0.0f, 0.0f, 0.0f } };
+        float radius[2] = { cull->radius[i], 0.0f };
+        if (st->bounds_mesh[i]) {
+            center[1] = vec3_mul(vec3_add(st->world_min[i], st->world_max[i]), 0.5f);
+            radius[1] = vec3_len(vec3_sub(st->world_max[i], center[1]));
+        }
+        for (int c = 0; c < SHADOW_MAX_CUBES; c++) {
+            ShadowCube *cube = &sys->cubes[c];
+            if (cube->light < 0) continue;
+            for (int s = 0; s < 2; s++) {
+                if (radius[s] <= 0.0f) continue;
+                vec3 d = vec3_sub(center[s], cube->position);
+                if (vec3_len(d) > cube->far + radius[s]) continue;
+                for (int f = 0; f < SHADOW_CUBE_FACES; f++) {
+                    if (cube_face_touches(f, d, radius[s])) cube->pending |= 1u << f;
+                }
+            }
+        }
+        for (int c = 0; sun_active && c < SHADOW_CASCADES; c++) {
+            for (int s = 0; s < 2; s++) {
+                if (radius[s] > 0.0f && frustum_test_sphere(&cascade_box[c], center[s], radius[s]) != FRUSTUM_OUTSIDE) sun->pending |= 1u << c;
+            }
+        }
+        cull->visible[movers++] = (uint32_t)i;
+    }
+    if (movers > 0) entity_store_transform(st, cull->visible, movers, mat4_identity(), cull->mvps);
+
+    // 4. Stale cascades
+    int budget = sys->budget;
+    if (sun_active && sun->pending) {
+        for (int i = 0; i < SHADOW_CASCADES && budget > 0; i++) {
+            if (!(sun->pending & (1u << i))) continue;
+            scene_render_shadow_map(scene, &sun->maps[i], cascade_vp[i], sun->maps[i].texel_world);
+            sun->pending &= ~(1u << i);
+            budget--;
+        }
+    }
+
+    // 5. Cube faces, resuming after the last cube served
+    for (int n = 0; n < SHADOW_MAX_CUBES && budget > 0; n++) {
+        int c = (sys->next_cube + n) % SHADOW_MAX_CUBES;
+        ShadowCube *cube = &sys->cubes[c];
+        if (cube->light < 0 || !lb->shadow[cube->light]) continue;
+        for (int f = 0; f < SHADOW_CUBE_FACES && budget > 0; f++) {
+            if (!(cube->pending & (1u << f))) continue;
+            mat4 vp = shadow_cube_face_matrix(cube->position, f, cube->far);
+            scene_render_shadow_map(scene, &cube->faces[f], vp, 2.0f / (float)sys->size);
+            cube->pending &= ~(1u << f);
+            budget--;
+        }
+        sys->next_cube = (c + 1) % SHADOW_MAX_CUBES;
+    }
+}
+
+// FNV-1a over 32-bit words; every input is made of floats, ints and pointers
+static uint32_t hash_words(uint32_t h, const void *data, size_t size) {
+    const uint8_t *p = data;
+    for (size_t i = 0; i + 4 <= size; i += 4) {
+        uint32_t w;
+        memcpy(&w, p + i, 4);
+        h = (h ^ w) * 16777619u;
+    }
+    return h;
+}
+
+// Temporal reuse key of a draw: changes with anything its shading reads
+// except the camera, shadow maps included. Never 0, which disables reuse.
+static uint32_t scene_draw_key(const Uniforms *u, const Mesh *mesh, VertexShader vs, FragmentShader fs) {
+    uint32_t h = 2166136261u;
+    h = hash_words(h, &mesh, sizeof(mesh));
+    h = hash_words(h, &vs, sizeof(vs));
+    h = hash_words(h, &fs, sizeof(fs));
+    h = hash_words(h, &u->model, sizeof(u->model));
+    h = hash_words(h, &u->base_color, sizeof(u->base_color));
+    h = hash_words(h, &u->texture, sizeof(u->texture));
+    h = hash_words(h, &u->sun, sizeof(u->sun));
+    if (shader_uses_time(fs)) h = hash_words(h, &u->dt, sizeof(u->dt));
+
+    int chunks = (u->light_count + SIMD_WIDTH - 1) / SIMD_WIDTH;
+    h = hash_words(h, u->lights, (size_t)chunks * sizeof(LightChunk));
+    for (int c = 0; c < chunks; c++) {
+        for (int j = 0; j < SIMD_WIDTH; j++) {
+            const ShadowCube *cube = u->lights[c].shadow[j];
+            if (!cube) continue;
+            for (int f = 0; f < SHADOW_CUBE_FACES; f++) h = hash_words(h, &cube->faces[f].version, sizeof(uint32_t));
+        }
+    }
+    if (u->sun_shadow) {
+        for (int i = 0; i < SHADOW_CASCADES; i++) h = hash_words(h, &u->sun_shadow->maps[i].version, sizeof(uint32_t));
+    }
+    return h ? h : 1;
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
 void scene_render(Scene* scene, Renderer* renderer, Uniforms* base_uniforms) {
     float aspect = base_uniforms->screen_width / base_uniforms->screen_height;
     mat4 view, proj;
@@ -63,60 +646,120 @@ void scene_render(Scene* scene, Renderer* renderer, Uniforms* base_uniforms) {
     base_uniforms->projection = proj;
     base_uniforms->view_proj = view_proj;
     base_uniforms->cam_pos = scene->camera.position;
-    base_uniforms->scene_lights = scene->lights; 
-
-    for (size_t i = 0; i < scene->entity_count; i++) {
-        Entity *e = &scene->entities[i];
-
-        if (!e->visible) continue;
-
-        mat4 m_scale = mat4_scale(e->scale);
-        mat4 m_rot_x = mat4_rotate_x(e->rotation.x);
-        mat4 m_rot_y = mat4_rotate_y(e->rotation.y);
-        mat4 m_rot_z = mat4_rotate_z(e->rotation.z);
-        mat4 m_rot = mat4_mul(m_rot_z, mat4_mul(m_rot_y, m_rot_x));
-        mat4 m_trans = mat4_translate(e->position.x, e->position.y, e->position.z);
-
-        mat4 model = mat4_mul(m_trans, mat4_mul(m_rot, m_scale));
-        mat4 mvp = mat4_mul(view_proj, model);
-
-        vec4 center_clip = mat4_mul_vec4(mvp, (vec4){0.0f, 0.0f, 0.0f, 1.0f});
-        if (center_clip.w < -3.0f) continue; 
-        if (center_clip.w > 0.0f) { 
-            float w = center_clip.w;
-            float margin = 4.0f * e->scale; 
-            if (center_clip.x < -w - margin || center_clip.x > w + margin ||
-                center_clip.y < -w - margin || center_clip.y > w + margin) {
-                continue; 
-            }
-        }
+    renderer_set_temporal_view(renderer, view_proj);
 
-        Uniforms local_uniforms = *base_uniforms; 
-        local_uniforms.light_count = 0; 
+    float pixels_per_unit = proj.m[1][1] * base_uniforms->screen_height * 0.5f;
 
-        vec4 center_world = mat4_mul_vec4(model, (vec4){0.0f, 0.0f, 0.0f, 1.0f});
-        vec3 cw = {center_world.x, center_world.y, center_world.z};
-        float max_dist_sq = 58.0f * 58.0f; 
+    // 1. Bounding spheres centred on the entity origin, so no model matrix is
+    // built for entities the hierarchy rejects; nothing to draw gets a zero radius
+    EntityStore *st = &scene->entities;
+    scene_reserve_cull(scene, st->count);
+    EntityCullScratch *cull = &scene->cull;
+    for (size_t i = 0; i < st->count; i++) {
+        const Mesh *mesh = st->visible[i] ? entity_resolve_mesh(st, (EntityHandle)i) : NULL;
+        cull->meshes[i] = mesh;
+        cull->radius[i] = (mesh && mesh->index_count > 0)
+            ? (vec3_len(mesh->bounds.center) + mesh->bounds_radius) * fabsf(st->scale[i]) : 0.0f;
+    }
 
-        for (size_t l = 0; l < scene->light_count; l++) {
-            vec3 diff = vec3_sub(scene->lights[l].position, cw);
-            if (vec3_dot(diff, diff) < max_dist_sq) {
-                local_uniforms.active_lights[local_uniforms.light_count++] = (uint16_t)l;
-            }
+    LightBuffer *lb = &scene->light_buffer;
+    light_buffer_build(scene, renderer, view_proj);
+
+    // 2. Refit both hierarchies and walk the entity one against the frustum
+    bvh_update(&scene->entity_bvh, st->pos_x, st->pos_y, st->pos_z, cull->radius, st->count);
+    bvh_update(&scene->light_bvh, lb->x, lb->y, lb->z, lb->radius, lb->count);
+
+    base_uniforms->sun = scene->sun;
+    base_uniforms->sun_shadow = NULL;
+    if (scene->shadows) {
+        scene_update_shadows(scene, aspect);
+        if (scene->sun.intensity > 0.0f) base_uniforms->sun_shadow = &scene->shadows->sun;
+    }
+
+    Frustum frustum;
+    frustum_from_matrix(&frustum, view_proj);
+    memset(cull->result, FRUSTUM_OUTSIDE, st->count);
+    bvh_query_frustum(&scene->entity_bvh, &frustum, cull->result);
+
+    // 3. Model and MVP matrices for the survivors, in submission order
+    size_t visible_count = 0;
+    for (size_t i = 0; i < st->count; i++) {
+        if (cull->result[i] != FRUSTUM_OUTSIDE) cull->visible[visible_count++] = (uint32_t)i;
+    }
+    entity_store_transform(st, cull->visible, visible_count, view_proj, cull->mvps);
+
+    // 4. Spheres straddling a plane get the tighter box test; the rest gather
+    // the lights whose sphere touches their world box on a tile they cover,
+    // in index order so shading sums the same way every frame. Done before
+    // any draw: the chunk array may move.
+    uint32_t lights[MAX_LIGHTS];
+    scene->light_chunk_count = 0;
+    for (size_t k = 0; k < visible_count; k++) {
+        EntityHandle h = cull->visible[k];
+        const Mesh *mesh = cull->meshes[h];
+        if (cull->result[h] == FRUSTUM_INTERSECT && frustum_test_obb(&frustum, &st->model[h], mesh->bounds) == FRUSTUM_OUTSIDE) {
+            cull->result[h] = FRUSTUM_OUTSIDE;
+            continue;
+        }
+
+        entity_update_bounds(st, h, mesh);
+        vec3 lo = st->world_min[h], hi = st->world_max[h];
+        TileRange tiles = scene_tile_range(renderer, view_proj, lo, hi);
+        vec3 center = vec3_mul(vec3_add(lo, hi), 0.5f);
+        size_t candidates = bvh_query_sphere(&scene->light_bvh, center, vec3_len(vec3_sub(hi, center)), lights, MAX_LIGHTS);
+
+        size_t light_count = 0;
+        for (size_t c = 0; c < candidates; c++) {
+            uint32_t id = lights[c];
+            if (lb->radius[id] <= 0.0f) continue;
+            float dx = MAX(MAX(lo.x - lb->x[id], lb->x[id] - hi.x), 0.0f);
+            float dy = MAX(MAX(lo.y - lb->y[id], lb->y[id] - hi.y), 0.0f);
+            float dz = MAX(MAX(lo.z - lb->z[id], lb->z[id] - hi.z), 0.0f);
+            if (dx * dx + dy * dy + dz * dz > lb->radius[id] * lb->radius[id]) continue;
+            if (!tile_ranges_overlap(tiles, lb->tiles[id])) continue;
+            lights[light_count++] = id;
         }
+        qsort(lights, light_count, sizeof(uint32_t), compare_u32);
+        cull->light_first[k] = scene_gather_lights(scene, lights, light_count);
+        cull->light_count[k] = (uint32_t)light_count;
+    }
+
+    // 5. Draw; translucent entities switch to BLEND_ALPHA, so the renderer
+    // composites them after the opaque ones in any submission order
+    BlendMode blend = renderer->blend_mode;
+    float blend_constant = renderer->blend_constant;
+    for (size_t k = 0; k < visible_count; k++) {
+        EntityHandle h = cull->visible[k];
+        if (cull->result[h] == FRUSTUM_OUTSIDE) continue;
+        const Mesh *mesh = cull->meshes[h];
+        const mat4 *model = &st->model[h];
 
-        local_uniforms.model = model;
-        local_uniforms.mvp = mvp;
-        local_uniforms.base_color = e->base_color;
+        vec3 wc = st->world_center[h];
+        vec4 sphere_clip = mat4_mul_vec4(view_proj, (vec4){wc.x, wc.y, wc.z, 1.0f});
+        mesh = entity_select_lod(st, h, mesh, sphere_clip.w - st->world_radius[h], pixels_per_unit, scene->lod_error_pixels);
+
+        Uniforms local_uniforms = *base_uniforms; 
+
+        local_uniforms.lights = scene->light_chunks + cull->light_first[k];
+        local_uniforms.light_count = (int)cull->light_count[k];
+
+        local_uniforms.model = *model;
+        local_uniforms.mvp = cull->mvps[k];
+        local_uniforms.base_color = st->color[h];
+        local_uniforms.texture = st->texture[h];
 
         renderer_set_uniforms(renderer, &local_uniforms);
-        renderer_set_shaders(renderer, e->vs, e->fs);
-        renderer_draw_mesh(renderer, e->mesh);
+        renderer_set_draw_key(renderer, renderer->temporal ? scene_draw_key(&local_uniforms, mesh, st->vs[h], st->fs[h]) : 0);
+        renderer_set_shaders(renderer, st->vs[h], st->fs[h]);
+        renderer_set_batch_shader(renderer, shader_get_batch(st->fs[h]));
+        renderer_set_blend_mode(renderer, st->opacity[h] < 1.0f ? BLEND_ALPHA : blend);
+        renderer_set_blend_constant(renderer, blend_constant * st->opacity[h]);
+        renderer_draw_mesh(renderer, (Mesh*)mesh);
     }
+    renderer_set_blend_mode(renderer, blend);
+    renderer_set_blend_constant(renderer, blend_constant);
 }
 
-extern void apply_post_processing(uint32_t* buffer, int width, int height, float time);
-
 void scene_render_frame(Scene* scene, Renderer* renderer, Platform* platform, Uniforms* uniforms, uint32_t clear_color) {
     renderer_reset(renderer);
     renderer_clear(renderer, clear_color, 1.0f);
@@ -124,10 +767,8 @@ void scene_render_frame(Scene* scene, Renderer* renderer, Platform* platform, Un
     scene_render(scene, renderer, uniforms);
 
     renderer_bin_triangles(renderer);      
-    renderer_rasterize(renderer); 
-    
-    apply_post_processing(renderer->color_buffer, (int)uniforms->screen_width, (int)uniforms->screen_height, uniforms->dt);
-    
+    renderer_rasterize(renderer);   // Runs the post-processing passes too
+
     // Swap buffers
     platform_update_window(platform, renderer->color_buffer, (int)uniforms->screen_width, (int)uniforms->screen_height);
 }
\ No newline at end of file
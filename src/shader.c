@@ -18,6 +18,50 @@ void vs_default(int idx, const Mesh *mesh, Vertex *out, void *uniforms) {
     out->nx = n_world.x;
     out->ny = n_world.y;
     out->nz = n_world.z;
+
+    out->u = mesh->u[idx];
+    out->v = mesh->v[idx];
+}
+
+void vs_depth(int idx, const Mesh *mesh, Vertex *out, void *uniforms) {
+    Uniforms *u = (Uniforms*)uniforms;
+    vec4 pos_clip = mat4_mul_vec4(u->mvp, (vec4){ mesh->p_x[idx], mesh->p_y[idx], mesh->p_z[idx], 1.0f });
+    *out = (Vertex){0};
+    out->x = pos_clip.x;
+    out->y = pos_clip.y;
+    out->z = pos_clip.z;
+    out->w = pos_clip.w;
+}
+
+// -------------------------------------------------------------
+// Shadows and the sun
+// -------------------------------------------------------------
+
+// Per-lane visibility of the shadowed lights among `lit`, 1 elsewhere
+static inline f32x8 chunk_shadow(const LightChunk *l, i32x8 lit, vec3 pos, vec3 normal) {
+    f32x8 vis = f32x8_splat(1.0f);
+    for (uint32_t bits = i32x8_bits(lit); bits; bits &= bits - 1) {
+        const int j = __builtin_ctz(bits);
+        if (l->shadow[j]) vis[j] = shadow_cube_visibility(l->shadow[j], pos, normal);
+    }
+    return vis;
+}
+
+// Diffuse factor of the sun at one point, with its Blinn-Phong term in *spec.
+// Both carry the intensity and shadow; 0 while the sun is off or behind the surface.
+static inline float sun_factors(const Uniforms *u, vec3 pos, vec3 normal, vec3 view_dir, float *spec) {
+    *spec = 0.0f;
+    if (u->sun.intensity <= 0.0f) return 0.0f;
+    vec3 to_sun = vec3_mul(u->sun.direction, -1.0f);
+    float n_dot_l = vec3_dot(normal, to_sun);
+    if (n_dot_l <= 0.0f) return 0.0f;
+
+    float k = u->sun.intensity;
+    if (u->sun_shadow) k *= shadow_cascades_visibility(u->sun_shadow, pos, normal);
+    float p = MAX(vec3_dot(normal, vec3_norm(vec3_add(to_sun, view_dir))), 0.0f);
+    p *= p; p *= p; p *= p; p *= p; p *= p; p *= p;
+    *spec = p * k;
+    return n_dot_l * k;
 }
 
 // -------------------------------------------------------------
@@ -45,47 +89,48 @@ uint32_t fs_multi_light(Triangle *t, float b0, float b1, float b2, void *uniform
     
     vec3 view_dir = vec3_norm(vec3_sub(u->cam_pos, world_pos));
 
-    vec3 diffuse_acc = {0.0f, 0.0f, 0.0f};
-    vec3 specular_acc = {0.0f, 0.0f, 0.0f};
-
-    for(int i = 0; i < u->light_count; i++) {
-        uint16_t light_idx = u->active_lights[i];
-        const PointLight *l = &u->scene_lights[light_idx];
-
-        vec3 L_vec = vec3_sub(l->position, world_pos);
-        float dist_sq = vec3_dot(L_vec, L_vec);
-        if (dist_sq > 2500.0f) continue;
-
-        float inv_dist = 1.0f / sqrtf(dist_sq);
-        float dist = dist_sq * inv_dist; 
-        vec3 L = vec3_mul(L_vec, inv_dist); 
-
-        float fade = 1.0f - (dist / 50.0f);
-
-        float att = l->intensity / (1.0f + 0.1f * dist + 0.7f * dist_sq);
-        att *= fade; 
-        
-        float NdotL = vec3_dot(normal, L);
-        if(NdotL > 0.0f) {
-            float diff_factor = NdotL * att;
-            diffuse_acc.x += l->color.x * diff_factor;
-            diffuse_acc.y += l->color.y * diff_factor;
-            diffuse_acc.z += l->color.z * diff_factor;
-
-            vec3 H = vec3_norm(vec3_add(L, view_dir));
-            float NdotH = vec3_dot(normal, H);
-            
-            if(NdotH > 0.0f) {
-                float p = NdotH;
-                p *= p; p *= p; p *= p; p *= p; p *= p; p *= p; 
-                
-                float spec = p * att;
-                specular_acc.x += l->color.x * spec;
-                specular_acc.y += l->color.y * spec;
-                specular_acc.z += l->color.z * spec;
-            }
-        }
+    // SIMD_WIDTH lights per iteration; lanes out of reach or facing away add nothing
+    f32x8 diff_r = f32x8_splat(0.0f), diff_g = diff_r, diff_b = diff_r;
+    f32x8 spec_r = diff_r, spec_g = diff_r, spec_b = diff_r;
+    for (int c = 0; c < u->light_count; c += SIMD_WIDTH) {
+        const LightChunk *l = &u->lights[c / SIMD_WIDTH];
+        f32x8 lx = f32x8_load(l->x) - world_pos.x;
+        f32x8 ly = f32x8_load(l->y) - world_pos.y;
+        f32x8 lz = f32x8_load(l->z) - world_pos.z;
+        f32x8 dist_sq = lx * lx + ly * ly + lz * lz;
+        f32x8 radius = f32x8_load(l->radius);
+        i32x8 near = (dist_sq <= radius * radius) & (radius > 0.0f);
+        if (!i32x8_any(near)) continue;
+
+        f32x8 inv_dist = f32x8_rsqrt(dist_sq);
+        f32x8 dist = dist_sq * inv_dist;
+        lx *= inv_dist; ly *= inv_dist; lz *= inv_dist;
+
+        f32x8 n_dot_l = normal.x * lx + normal.y * ly + normal.z * lz;
+        i32x8 lit = near & (n_dot_l > 0.0f);
+        if (!i32x8_any(lit)) continue;
+
+        f32x8 fade = 1.0f - dist / radius;
+        f32x8 att = f32x8_load(l->intensity) / (1.0f + 0.1f * dist + 0.7f * dist_sq) * fade;
+
+        f32x8 hx = lx + view_dir.x, hy = ly + view_dir.y, hz = lz + view_dir.z;
+        f32x8 n_dot_h = (normal.x * hx + normal.y * hy + normal.z * hz) * f32x8_rsqrt(hx * hx + hy * hy + hz * hz);
+        f32x8 p = f32x8_max(n_dot_h, f32x8_splat(0.0f));
+        p *= p; p *= p; p *= p; p *= p; p *= p; p *= p;
+
+        att *= chunk_shadow(l, lit, world_pos, normal);
+
+        f32x8 kd = f32x8_select(lit, n_dot_l * att, f32x8_splat(0.0f));
+        f32x8 ks = f32x8_select(lit, p * att, f32x8_splat(0.0f));
+        f32x8 cr = f32x8_load(l->r), cg = f32x8_load(l->g), cb = f32x8_load(l->b);
+        diff_r += cr * kd; diff_g += cg * kd; diff_b += cb * kd;
+        spec_r += cr * ks; spec_g += cg * ks; spec_b += cb * ks;
     }
+    vec3 diffuse_acc = { f32x8_hsum(diff_r), f32x8_hsum(diff_g), f32x8_hsum(diff_b) };
+    vec3 specular_acc = { f32x8_hsum(spec_r), f32x8_hsum(spec_g), f32x8_hsum(spec_b) };
+    float sun_spec, sun_diff = sun_factors(u, world_pos, normal, view_dir, &sun_spec);
+    diffuse_acc = vec3_add(diffuse_acc, vec3_mul(u->sun.color, sun_diff));
+    specular_acc = vec3_add(specular_acc, vec3_mul(u->sun.color, sun_spec));
 
     vec3 final_rgb = {
         u->base_color.x * (0.01f + diffuse_acc.x) + specular_acc.x,
@@ -93,11 +138,56 @@ uint32_t fs_multi_light(Triangle *t, float b0, float b1, float b2, void *uniform
         u->base_color.z * (0.01f + diffuse_acc.z) + specular_acc.z
     };
 
-    final_rgb.x = fminf(final_rgb.x, 1.0f);
-    final_rgb.y = fminf(final_rgb.y, 1.0f);
-    final_rgb.z = fminf(final_rgb.z, 1.0f);
+    return shader_pack_color(u, final_rgb);
+}
+
+// Ambient plus every active light, with the smooth falloff
+static inline vec3 smooth_light_sum(const Uniforms *u, vec3 world_pos, vec3 normal) {
+    vec3 view_dir = vec3_norm(vec3_sub(u->cam_pos, world_pos));
+    f32x8 acc_r = f32x8_splat(0.0f), acc_g = acc_r, acc_b = acc_r;
+
+    for (int c = 0; c < u->light_count; c += SIMD_WIDTH) {
+        const LightChunk *l = &u->lights[c / SIMD_WIDTH];
+        f32x8 lx = f32x8_load(l->x) - world_pos.x;
+        f32x8 ly = f32x8_load(l->y) - world_pos.y;
+        f32x8 lz = f32x8_load(l->z) - world_pos.z;
+        f32x8 dist_sq = lx * lx + ly * ly + lz * lz;
+        f32x8 radius = f32x8_load(l->radius);
+        i32x8 near = (dist_sq <= radius * radius) & (radius > 0.0f);
+        if (!i32x8_any(near)) continue;
+
+        f32x8 inv_dist = f32x8_rsqrt(dist_sq);
+        f32x8 dist = dist_sq * inv_dist;       // dist = dist^2 * (1/dist)
+        lx *= inv_dist; ly *= inv_dist; lz *= inv_dist;
+
+        f32x8 n_dot_l = normal.x * lx + normal.y * ly + normal.z * lz;
+        i32x8 lit = near & (n_dot_l > 0.0f);
+        if (!i32x8_any(lit)) continue;
+
+        f32x8 fade = 1.0f - dist / radius;
+        f32x8 att = 1.0f / (1.0f + 0.1f * dist + 0.4f * dist_sq);
+        att *= f32x8_load(l->intensity) * fade;
+
+        f32x8 hx = lx + view_dir.x, hy = ly + view_dir.y, hz = lz + view_dir.z;
+        f32x8 n_dot_h = (normal.x * hx + normal.y * hy + normal.z * hz) * f32x8_rsqrt(hx * hx + hy * hy + hz * hz);
+        f32x8 spec = f32x8_max(n_dot_h, f32x8_splat(0.0f));
+        spec *= spec; spec *= spec; spec *= spec; spec *= spec; spec *= spec; spec *= spec;
+
+        att *= chunk_shadow(l, lit, world_pos, normal);
+
+        f32x8 k = f32x8_select(lit, (n_dot_l + spec) * att, f32x8_splat(0.0f));
+        acc_r += f32x8_load(l->r) * k;
+        acc_g += f32x8_load(l->g) * k;
+        acc_b += f32x8_load(l->b) * k;
+    }
+    vec3 total_light = { 0.01f + f32x8_hsum(acc_r), 0.01f + f32x8_hsum(acc_g), 0.01f + f32x8_hsum(acc_b) };
+    float sun_spec, sun_diff = sun_factors(u, world_pos, normal, view_dir, &sun_spec);
+    return vec3_add(total_light, vec3_mul(u->sun.color, sun_diff + sun_spec));
+}
 
-    return vec3_to_color(final_rgb);
+static inline uint32_t shade_smooth(const Uniforms *u, vec3 albedo, vec3 world_pos, vec3 normal) {
+    vec3 final_rgb = vec3_mul_vec3(albedo, smooth_light_sum(u, world_pos, normal));
+    return shader_pack_color(u, final_rgb);
 }
 
 uint32_t fs_multi_light_smooth(Triangle *t, float b0, float b1, float b2, void *uniforms) {
@@ -118,61 +208,39 @@ uint32_t fs_multi_light_smooth(Triangle *t, float b0, float b1, float b2, void *
     };
     normal = vec3_norm(normal); 
 
-    vec3 view_dir = vec3_norm(vec3_sub(u->cam_pos, world_pos));
-    vec3 total_light = {0.01f, 0.01f, 0.01f}; 
-
-    for(int i = 0; i < u->light_count; i++) {
-        uint16_t light_idx = u->active_lights[i];
-        const PointLight *l = &u->scene_lights[light_idx];
-
-        vec3 L_vec = vec3_sub(l->position, world_pos);
-        
-        float dist_sq = vec3_len_sq(L_vec);
-        if (dist_sq > 2500.0f) continue; // 50^2 = 2500
-        
-        float inv_dist = 1 / sqrtf(dist_sq);
-        float dist = dist_sq * inv_dist;       // dist = dist^2 * (1/dist)
-        vec3 L = vec3_mul(L_vec, inv_dist);    // normalize L_vec without division
-
-        float fade = 1.0f - (dist * 0.02f); // x / 50.0f is same as x * 0.02f
-
-        float att = 1.0f / (1.0f + 0.1f * dist + 0.4f * dist_sq);
-        att *= l->intensity * fade;
-
-        float NdotL = vec3_dot(normal, L);
-        
-        if(NdotL <= 0.0f) continue;
-
-        float spec = 0.0f;
-        vec3 H = vec3_norm(vec3_add(L, view_dir));
-        float NdotH = vec3_dot(normal, H);
-        
-        if(NdotH > 0.0f) {
-            float p = NdotH;
-            p *= p; p *= p; p *= p; p *= p; p *= p; p *= p; 
-            spec = p; 
-        }
+    return shade_smooth(u, u->base_color, world_pos, normal);
+}
 
-        vec3 light_color = l->color;
-        float diff_factor = NdotL * att;
-        float spec_factor = spec * att;
+uint32_t fs_textured(Triangle *t, float b0, float b1, float b2, void *uniforms) {
+    Uniforms *u = (Uniforms*)uniforms;
 
-        total_light.x += light_color.x * (diff_factor + spec_factor);
-        total_light.y += light_color.y * (diff_factor + spec_factor);
-        total_light.z += light_color.z * (diff_factor + spec_factor);
-    }
+    float w_true = 1.0f / (b0 * t->v[0].w + b1 * t->v[1].w + b2 * t->v[2].w);
 
-    vec3 final_rgb = vec3_mul_vec3(u->base_color, total_light);
+    vec3 world_pos = {
+        (b0 * t->v[0].world_pos.x + b1 * t->v[1].world_pos.x + b2 * t->v[2].world_pos.x) * w_true,
+        (b0 * t->v[0].world_pos.y + b1 * t->v[1].world_pos.y + b2 * t->v[2].world_pos.y) * w_true,
+        (b0 * t->v[0].world_pos.z + b1 * t->v[1].world_pos.z + b2 * t->v[2].world_pos.z) * w_true
+    };
 
-    final_rgb.x = final_rgb.x > 1.0f ? 1.0f : final_rgb.x;
-    final_rgb.y = final_rgb.y > 1.0f ? 1.0f : final_rgb.y;
-    final_rgb.z = final_rgb.z > 1.0f ? 1.0f : final_rgb.z;
+    vec3 normal = vec3_norm((vec3){
+        (b0 * t->v[0].nx + b1 * t->v[1].nx + b2 * t->v[2].nx) * w_true,
+        (b0 * t->v[0].ny + b1 * t->v[1].ny + b2 * t->v[2].ny) * w_true,
+        (b0 * t->v[0].nz + b1 * t->v[1].nz + b2 * t->v[2].nz) * w_true
+    });
 
-    return vec3_to_color(final_rgb);
+    // A lone pixel has no derivatives: sample the base level (bs_textured filters properly)
+    vec3 albedo = u->base_color;
+    if (u->texture) {
+        float tu = (b0 * t->v[0].u + b1 * t->v[1].u + b2 * t->v[2].u) * w_true;
+        float tv = (b0 * t->v[0].v + b1 * t->v[1].v + b2 * t->v[2].v) * w_true;
+        f32x4 texel = texture_sample_bilinear(u->texture, 0, tu, tv);
+        albedo = (vec3){ albedo.x * texel[0], albedo.y * texel[1], albedo.z * texel[2] };
+    }
+    return shade_smooth(u, albedo, world_pos, normal);
 }
 
 uint32_t fs_normals(Triangle *t, float b0, float b1, float b2, void *uniforms) {
-    (void)uniforms;
+    const Uniforms *u = (const Uniforms*)uniforms;
     float w_true = 1.0f / (b0 * t->v[0].w + b1 * t->v[1].w + b2 * t->v[2].w);
     vec3 normal = {
         (b0 * t->v[0].nx + b1 * t->v[1].nx + b2 * t->v[2].nx) * w_true,
@@ -182,23 +250,24 @@ uint32_t fs_normals(Triangle *t, float b0, float b1, float b2, void *uniforms) {
     normal = vec3_norm(normal);
     vec3 color;
     color.x = normal.x * 0.5f + 0.5f; color.y = normal.y * 0.5f + 0.5f; color.z = normal.z * 0.5f + 0.5f;
-    return vec3_to_color(color);
+    return shader_pack_color(u, color);
 }
 
 uint32_t fs_pure_color(Triangle *t, float b0, float b1, float b2, void *uniforms) {
     (void)b0; (void)b1; (void)b2; (void)t;
     Uniforms *u = (Uniforms*)uniforms;
-    return vec3_to_color(u->base_color);
+    return shader_pack_color(u, u->base_color);
 }
 
 uint32_t fs_wireframe(Triangle *t, float b0, float b1, float b2, void *uniforms) {
-    (void)t; (void)uniforms;
+    (void)t;
+    const Uniforms *u = (const Uniforms*)uniforms;
     float threshold = 0.02f; 
     float min_dist = b0;
     if (b1 < min_dist) min_dist = b1;
     if (b2 < min_dist) min_dist = b2;
     vec3 final_color = (min_dist < threshold) ? (vec3){0.0f, 1.0f, 0.0f} : (vec3){0.1f, 0.0f, 0.2f};
-    return vec3_to_color(final_color);
+    return shader_pack_color(u, final_color);
 }
 
 uint32_t fs_plasma_glow(Triangle *t, float b0, float b1, float b2, void *uniforms) {
@@ -220,7 +289,7 @@ uint32_t fs_plasma_glow(Triangle *t, float b0, float b1, float b2, void *uniform
         float dist = vec3_len(world_pos) * 0.01f;
         color = vec3_mul((vec3){0.1f, 0.05f, 0.2f}, 1.0f / (1.0f + dist));
     }
-    return vec3_to_color(color);
+    return shader_pack_color(u, color);
 }
 
 uint32_t fs_cyber_neon(Triangle *t, float b0, float b1, float b2, void *uniforms) {
@@ -240,31 +309,39 @@ uint32_t fs_cyber_neon(Triangle *t, float b0, float b1, float b2, void *uniforms
     });
 
     vec3 view_dir = vec3_norm(vec3_sub(u->cam_pos, world_pos));
-    vec3 total_light = {0.05f, 0.05f, 0.08f}; 
-
-    for(int i = 0; i < u->light_count; i++) {
-        // FIX: Lookup light using new array indexing
-        uint16_t light_idx = u->active_lights[i];
-        const PointLight *l = &u->scene_lights[light_idx];
-        
-        vec3 L_vec = vec3_sub(l->position, world_pos);
-        float dist = vec3_len(L_vec);
-        vec3 L = vec3_div(L_vec, dist);
-
-        float att = 1.0f / (1.0f + 0.1f * dist + 0.02f * dist * dist);
-        att *= l->intensity;
-
-        float NdotL = MAX(vec3_dot(normal, L), 0.0f);
-        vec3 H = vec3_norm(vec3_add(L, view_dir));
-        
-        float ndoth = MAX(vec3_dot(normal, H), 0.0f);
-        ndoth *= ndoth; ndoth *= ndoth; ndoth *= ndoth; ndoth *= ndoth; ndoth *= ndoth; // 32
-        float spec = ndoth;
-
-        vec3 diff_comp = vec3_mul(l->color, NdotL);
-        vec3 spec_comp = vec3_mul(l->color, spec);
-        total_light = vec3_add(total_light, vec3_mul(vec3_add(diff_comp, spec_comp), att));
+    f32x8 acc_r = f32x8_splat(0.0f), acc_g = acc_r, acc_b = acc_r;
+
+    for (int c = 0; c < u->light_count; c += SIMD_WIDTH) {
+        const LightChunk *l = &u->lights[c / SIMD_WIDTH];
+        f32x8 lx = f32x8_load(l->x) - world_pos.x;
+        f32x8 ly = f32x8_load(l->y) - world_pos.y;
+        f32x8 lz = f32x8_load(l->z) - world_pos.z;
+        f32x8 dist_sq = lx * lx + ly * ly + lz * lz;
+        f32x8 radius = f32x8_load(l->radius);
+        i32x8 near = (dist_sq <= radius * radius) & (radius > 0.0f);
+        if (!i32x8_any(near)) continue;
+
+        f32x8 inv_dist = f32x8_rsqrt(dist_sq);
+        f32x8 dist = dist_sq * inv_dist;
+        lx *= inv_dist; ly *= inv_dist; lz *= inv_dist;
+
+        // Faded to zero at the radius like the other lighting shaders; the radius
+        // comes from the steeper smooth falloff, so the fade hides the cut
+        f32x8 fade = 1.0f - dist / radius;
+        f32x8 att = f32x8_select(near, f32x8_load(l->intensity) * fade / (1.0f + 0.1f * dist + 0.02f * dist_sq), f32x8_splat(0.0f));
+
+        f32x8 n_dot_l = f32x8_max(normal.x * lx + normal.y * ly + normal.z * lz, f32x8_splat(0.0f));
+        f32x8 hx = lx + view_dir.x, hy = ly + view_dir.y, hz = lz + view_dir.z;
+        f32x8 n_dot_h = (normal.x * hx + normal.y * hy + normal.z * hz) * f32x8_rsqrt(hx * hx + hy * hy + hz * hz);
+        f32x8 spec = f32x8_max(n_dot_h, f32x8_splat(0.0f));
+        spec *= spec; spec *= spec; spec *= spec; spec *= spec; spec *= spec; // 32
+
+        f32x8 k = (n_dot_l + spec) * att;
+        acc_r += f32x8_load(l->r) * k;
+        acc_g += f32x8_load(l->g) * k;
+        acc_b += f32x8_load(l->b) * k;
     }
+    vec3 total_light = { 0.05f + f32x8_hsum(acc_r), 0.05f + f32x8_hsum(acc_g), 0.08f + f32x8_hsum(acc_b) };
 
     vec3 base = vec3_mul_vec3(u->base_color, total_light);
     float edge_threshold = 0.05f;
@@ -274,5 +351,327 @@ uint32_t fs_cyber_neon(Triangle *t, float b0, float b1, float b2, void *uniforms
         vec3 neon_color = {0.0f, 0.8f, 1.0f}; 
         base = vec3_add(base, vec3_mul(neon_color, pulse));
     }
-    return vec3_to_color(base);
-}
\ No newline at end of file
+    return shader_pack_color(u, base);
+}
+
+// -------------------------------------------------------------
+// Batched shaders: a FragmentBatch is shaded SIMD_WIDTH pixels per
+// instruction with the lights in the outer loop, so each light is
+// fetched once per batch instead of once per pixel
+// -------------------------------------------------------------
+
+// Unit normal and unit direction to the camera for every pixel of a batch
+typedef struct {
+    _Alignas(32) float nx[FRAGMENT_BATCH], ny[FRAGMENT_BATCH], nz[FRAGMENT_BATCH];
+    _Alignas(32) float vx[FRAGMENT_BATCH], vy[FRAGMENT_BATCH], vz[FRAGMENT_BATCH];
+} BatchSurface;
+
+static void batch_view_dirs(const FragmentBatch *b, const Uniforms *u, BatchSurface *s) {
+    for (int p = 0; p < b->count; p += SIMD_WIDTH) {
+        f32x8 vx = u->cam_pos.x - f32x8_load(&b->world_x[p]);
+        f32x8 vy = u->cam_pos.y - f32x8_load(&b->world_y[p]);
+        f32x8 vz = u->cam_pos.z - f32x8_load(&b->world_z[p]);
+        f32x8 inv_len = f32x8_rsqrt(vx * vx + vy * vy + vz * vz);
+        f32x8_store(&s->vx[p], vx * inv_len);
+        f32x8_store(&s->vy[p], vy * inv_len);
+        f32x8_store(&s->vz[p], vz * inv_len);
+    }
+}
+
+// Interpolated vertex normals, renormalised
+static void batch_smooth_normals(const FragmentBatch *b, BatchSurface *s) {
+    for (int p = 0; p < b->count; p += SIMD_WIDTH) {
+        f32x8 nx = f32x8_load(&b->nx[p]), ny = f32x8_load(&b->ny[p]), nz = f32x8_load(&b->nz[p]);
+        f32x8 inv_len = f32x8_rsqrt(nx * nx + ny * ny + nz * nz);
+        f32x8_store(&s->nx[p], nx * inv_len);
+        f32x8_store(&s->ny[p], ny * inv_len);
+        f32x8_store(&s->nz[p], nz * inv_len);
+    }
+}
+
+// Face normals of each quad's triangle, as fs_multi_light reconstructs them
+static void batch_face_normals(const FragmentBatch *b, BatchSurface *s) {
+    const Triangle *last = NULL;
+    vec3 normal = {0.0f, 0.0f, 0.0f};
+    for (int q = 0; q < b->count >> 2; q++) {
+        const Triangle *t = b->tri[q];
+        if (t != last) {
+            vec3 v0 = vec3_mul(t->v[0].world_pos, 1.0f / t->v[0].w);
+            vec3 v1 = vec3_mul(t->v[1].world_pos, 1.0f / t->v[1].w);
+            vec3 v2 = vec3_mul(t->v[2].world_pos, 1.0f / t->v[2].w);
+            normal = vec3_norm(vec3_cross(vec3_sub(v1, v0), vec3_sub(v2, v0)));
+            last = t;
+        }
+        f32x4_store(&s->nx[q * 4], f32x4_splat(normal.x));
+        f32x4_store(&s->ny[q * 4], f32x4_splat(normal.y));
+        f32x4_store(&s->nz[q * 4], f32x4_splat(normal.z));
+    }
+}
+
+// World-space box around every lane of a batch, so lights out of reach are skipped whole
+typedef struct { vec3 lo, hi; } BatchBounds;
+
+static BatchBounds batch_bounds(const FragmentBatch *b) {
+    f32x8 lo_x = f32x8_load(b->world_x), lo_y = f32x8_load(b->world_y), lo_z = f32x8_load(b->world_z);
+    f32x8 hi_x = lo_x, hi_y = lo_y, hi_z = lo_z;
+    for (int p = SIMD_WIDTH; p < b->count; p += SIMD_WIDTH) {
+        f32x8 x = f32x8_load(&b->world_x[p]), y = f32x8_load(&b->world_y[p]), z = f32x8_load(&b->world_z[p]);
+        lo_x = f32x8_min(lo_x, x); lo_y = f32x8_min(lo_y, y); lo_z = f32x8_min(lo_z, z);
+        hi_x = f32x8_max(hi_x, x); hi_y = f32x8_max(hi_y, y); hi_z = f32x8_max(hi_z, z);
+    }
+    BatchBounds bb = { { lo_x[0], lo_y[0], lo_z[0] }, { hi_x[0], hi_y[0], hi_z[0] } };
+    for (int i = 1; i < SIMD_WIDTH; i++) {
+        bb.lo.x = MIN(bb.lo.x, lo_x[i]); bb.lo.y = MIN(bb.lo.y, lo_y[i]); bb.lo.z = MIN(bb.lo.z, lo_z[i]);
+        bb.hi.x = MAX(bb.hi.x, hi_x[i]); bb.hi.y = MAX(bb.hi.y, hi_y[i]); bb.hi.z = MAX(bb.hi.z, hi_z[i]);
+    }
+    return bb;
+}
+
+// Bit j is set when light j of the chunk comes within its radius of the box;
+// lights with a zero radius reach nothing
+static inline uint32_t batch_lights_reaching(const BatchBounds *bb, const LightChunk *l) {
+    const f32x8 zero = f32x8_splat(0.0f);
+    f32x8 x = f32x8_load(l->x), y = f32x8_load(l->y), z = f32x8_load(l->z);
+    f32x8 dx = f32x8_max(f32x8_max(bb->lo.x - x, x - bb->hi.x), zero);
+    f32x8 dy = f32x8_max(f32x8_max(bb->lo.y - y, y - bb->hi.y), zero);
+    f32x8 dz = f32x8_max(f32x8_max(bb->lo.z - z, z - bb->hi.z), zero);
+    f32x8 radius = f32x8_load(l->radius);
+    return i32x8_bits((dx * dx + dy * dy + dz * dz <= radius * radius) & (radius > 0.0f));
+}
+
+// Cube-map visibility for the written pixels among `lit` in the group at p.
+// Lookups are gathers, so they run pixel by pixel.
+static inline f32x8 batch_shadow(const ShadowCube *c, const FragmentBatch *b, const BatchSurface *s, int p, i32x8 lit) {
+    f32x8 vis = f32x8_splat(1.0f);
+    for (uint32_t bits = i32x8_bits(lit) & batch_mask8(b, p); bits; bits &= bits - 1) {
+        const int i = __builtin_ctz(bits);
+        vis[i] = shadow_cube_visibility(c, (vec3){ b->world_x[p + i], b->world_y[p + i], b->world_z[p + i] },
+                                        (vec3){ s->nx[p + i], s->ny[p + i], s->nz[p + i] });
+    }
+    return vis;
+}
+
+// sun_factors for every written pixel, SIMD_WIDTH at a time; false while the sun is off
+static int batch_sun(const FragmentBatch *b, const Uniforms *u, const BatchSurface *s, float *kd, float *ks) {
+    if (u->sun.intensity <= 0.0f) return 0;
+    const vec3 to_sun = vec3_mul(u->sun.direction, -1.0f);
+    for (int p = 0; p < b->count; p += SIMD_WIDTH) {
+        f32x8 nx = f32x8_load(&s->nx[p]), ny = f32x8_load(&s->ny[p]), nz = f32x8_load(&s->nz[p]);
+        f32x8 n_dot_l = nx * to_sun.x + ny * to_sun.y + nz * to_sun.z;
+        i32x8 lit = n_dot_l > 0.0f;
+        f32x8 k = f32x8_splat(u->sun.intensity);
+        if (u->sun_shadow) {
+            for (uint32_t bits = i32x8_bits(lit) & batch_mask8(b, p); bits; bits &= bits - 1) {
+                const int i = __builtin_ctz(bits);
+                k[i] *= shadow_cascades_visibility(u->sun_shadow, (vec3){ b->world_x[p + i], b->world_y[p + i], b->world_z[p + i] },
+                                                   (vec3){ s->nx[p + i], s->ny[p + i], s->nz[p + i] });
+            }
+        }
+        f32x8 hx = to_sun.x + f32x8_load(&s->vx[p]), hy = to_sun.y + f32x8_load(&s->vy[p]), hz = to_sun.z + f32x8_load(&s->vz[p]);
+        f32x8 n_dot_h = (nx * hx + ny * hy + nz * hz) * f32x8_rsqrt(hx * hx + hy * hy + hz * hz);
+        f32x8 spec = f32x8_max(n_dot_h, f32x8_splat(0.0f));
+        spec *= spec; spec *= spec; spec *= spec; spec *= spec; spec *= spec; spec *= spec;
+        f32x8_store(&kd[p], f32x8_select(lit, n_dot_l * k, f32x8_splat(0.0f)));
+        f32x8_store(&ks[p], f32x8_select(lit, spec * k, f32x8_splat(0.0f)));
+    }
+    return 1;
+}
+
+// Every point light reaching the batch, attenuated by intensity / (1 + 0.1 d + falloff d^2)
+// and faded out at its radius. Diffuse terms add to `diff`; specular ones to
+// `spec`, or to `diff` as well when it is NULL.
+static inline void batch_point_lights(const FragmentBatch *b, const Uniforms *u, const BatchSurface *s, float falloff,
+                                      float *const diff[3], float *const spec[3]) {
+    BatchBounds bb = batch_bounds(b);
+    for (int c = 0; c < u->light_count; c += SIMD_WIDTH) {
+        const LightChunk *chunk = &u->lights[c / SIMD_WIDTH];
+        for (uint32_t bits = batch_lights_reaching(&bb, chunk); bits; bits &= bits - 1) {
+            const int j = __builtin_ctz(bits);
+            const float radius = chunk->radius[j];
+            for (int p = 0; p < b->count; p += SIMD_WIDTH) {
+                if (!batch_mask8(b, p)) continue;
+                f32x8 lx = chunk->x[j] - f32x8_load(&b->world_x[p]);
+                f32x8 ly = chunk->y[j] - f32x8_load(&b->world_y[p]);
+                f32x8 lz = chunk->z[j] - f32x8_load(&b->world_z[p]);
+                f32x8 dist_sq = lx * lx + ly * ly + lz * lz;
+                i32x8 near = dist_sq <= radius * radius;
+                if (!i32x8_any(near)) continue;
+                f32x8 inv_dist = f32x8_rsqrt(dist_sq);
+                f32x8 dist = dist_sq * inv_dist;
+                lx *= inv_dist; ly *= inv_dist; lz *= inv_dist;
+
+                f32x8 nx = f32x8_load(&s->nx[p]), ny = f32x8_load(&s->ny[p]), nz = f32x8_load(&s->nz[p]);
+                f32x8 n_dot_l = nx * lx + ny * ly + nz * lz;
+                i32x8 lit = near & (n_dot_l > 0.0f);
+                if (!i32x8_any(lit)) continue;
+
+                f32x8 fade = 1.0f - dist * (1.0f / radius);
+                f32x8 att = chunk->intensity[j] * fade / (1.0f + 0.1f * dist + falloff * dist_sq);
+                if (chunk->shadow[j]) att *= batch_shadow(chunk->shadow[j], b, s, p, lit);
+
+                f32x8 hx = lx + f32x8_load(&s->vx[p]), hy = ly + f32x8_load(&s->vy[p]), hz = lz + f32x8_load(&s->vz[p]);
+                f32x8 n_dot_h = (nx * hx + ny * hy + nz * hz) * f32x8_rsqrt(hx * hx + hy * hy + hz * hz);
+                f32x8 spec_k = f32x8_max(n_dot_h, f32x8_splat(0.0f));
+                spec_k *= spec_k; spec_k *= spec_k; spec_k *= spec_k; spec_k *= spec_k; spec_k *= spec_k; spec_k *= spec_k;
+
+                const f32x8 zero = f32x8_splat(0.0f);
+                f32x8 kd = f32x8_select(lit, spec ? n_dot_l * att : (n_dot_l + spec_k) * att, zero);
+                f32x8 ks = f32x8_select(lit, spec_k * att, zero);
+                f32x8_store(&diff[0][p], f32x8_load(&diff[0][p]) + chunk->r[j] * kd);
+                f32x8_store(&diff[1][p], f32x8_load(&diff[1][p]) + chunk->g[j] * kd);
+                f32x8_store(&diff[2][p], f32x8_load(&diff[2][p]) + chunk->b[j] * kd);
+                if (!spec) continue;
+                f32x8_store(&spec[0][p], f32x8_load(&spec[0][p]) + chunk->r[j] * ks);
+                f32x8_store(&spec[1][p], f32x8_load(&spec[1][p]) + chunk->g[j] * ks);
+                f32x8_store(&spec[2][p], f32x8_load(&spec[2][p]) + chunk->b[j] * ks);
+            }
+        }
+    }
+}
+
+// Ambient plus every active light with the smooth falloff, 8 pixels at a time
+static void batch_light_smooth(const FragmentBatch *b, const Uniforms *u, float *acc_r, float *acc_g, float *acc_b) {
+    BatchSurface s;
+    batch_smooth_normals(b, &s);
+    batch_view_dirs(b, u, &s);
+    for (int p = 0; p < b->count; p += SIMD_WIDTH) {
+        f32x8_store(&acc_r[p], f32x8_splat(0.01f));
+        f32x8_store(&acc_g[p], f32x8_splat(0.01f));
+        f32x8_store(&acc_b[p], f32x8_splat(0.01f));
+    }
+
+    float *const acc[3] = { acc_r, acc_g, acc_b };
+    batch_point_lights(b, u, &s, 0.4f, acc, NULL);
+
+    _Alignas(32) float sun_kd[FRAGMENT_BATCH], sun_ks[FRAGMENT_BATCH];
+    if (!batch_sun(b, u, &s, sun_kd, sun_ks)) return;
+    for (int p = 0; p < b->count; p += SIMD_WIDTH) {
+        f32x8 k = f32x8_load(&sun_kd[p]) + f32x8_load(&sun_ks[p]);
+        f32x8_store(&acc_r[p], f32x8_load(&acc_r[p]) + u->sun.color.x * k);
+        f32x8_store(&acc_g[p], f32x8_load(&acc_g[p]) + u->sun.color.y * k);
+        f32x8_store(&acc_b[p], f32x8_load(&acc_b[p]) + u->sun.color.z * k);
+    }
+}
+
+void bs_multi_light_smooth(const FragmentBatch *b, void *uniforms, uint32_t *out) {
+    const Uniforms *u = (const Uniforms*)uniforms;
+    _Alignas(32) float acc_r[FRAGMENT_BATCH], acc_g[FRAGMENT_BATCH], acc_b[FRAGMENT_BATCH];
+    batch_light_smooth(b, u, acc_r, acc_g, acc_b);
+
+    for (int p = 0; p < b->count; p += SIMD_WIDTH) {
+        u32x8_store(&out[p], shader_pack_color8(u, u->base_color.x * f32x8_load(&acc_r[p]),
+                                                   u->base_color.y * f32x8_load(&acc_g[p]),
+                                                   u->base_color.z * f32x8_load(&acc_b[p])));
+    }
+}
+
+void bs_textured(const FragmentBatch *b, void *uniforms, uint32_t *out) {
+    const Uniforms *u = (const Uniforms*)uniforms;
+    _Alignas(32) float acc_r[FRAGMENT_BATCH], acc_g[FRAGMENT_BATCH], acc_b[FRAGMENT_BATCH];
+    _Alignas(32) float alb_r[FRAGMENT_BATCH], alb_g[FRAGMENT_BATCH], alb_b[FRAGMENT_BATCH];
+    batch_light_smooth(b, u, acc_r, acc_g, acc_b);
+
+    // Texel fetches are gathers: one mip level per quad with any written pixel, one sample per written pixel
+    for (int q = 0; q < b->count; q += 4) {
+        uint32_t quad = u->texture ? (uint32_t)(b->mask >> q) & 0xFu : 0;
+        float lod = quad ? texture_lod(u->texture, batch_ddx(b->u, q), batch_ddx(b->v, q), batch_ddy(b->u, q), batch_ddy(b->v, q)) : 0.0f;
+        for (int i = q; i < q + 4; i++) {
+            vec3 albedo = u->base_color;
+            if ((quad >> (i - q)) & 1) {
+                f32x4 texel = texture_sample_trilinear(u->texture, b->u[i], b->v[i], lod);
+                albedo = (vec3){ albedo.x * texel[0], albedo.y * texel[1], albedo.z * texel[2] };
+            }
+            alb_r[i] = albedo.x; alb_g[i] = albedo.y; alb_b[i] = albedo.z;
+        }
+    }
+
+    for (int p = 0; p < b->count; p += SIMD_WIDTH) {
+        u32x8_store(&out[p], shader_pack_color8(u, f32x8_load(&alb_r[p]) * f32x8_load(&acc_r[p]),
+                                                   f32x8_load(&alb_g[p]) * f32x8_load(&acc_g[p]),
+                                                   f32x8_load(&alb_b[p]) * f32x8_load(&acc_b[p])));
+    }
+}
+
+void bs_multi_light(const FragmentBatch *b, void *uniforms, uint32_t *out) {
+    const Uniforms *u = (const Uniforms*)uniforms;
+    BatchSurface s;
+    _Alignas(32) float diff_r[FRAGMENT_BATCH], diff_g[FRAGMENT_BATCH], diff_b[FRAGMENT_BATCH];
+    _Alignas(32) float spec_r[FRAGMENT_BATCH], spec_g[FRAGMENT_BATCH], spec_b[FRAGMENT_BATCH];
+    batch_face_normals(b, &s);
+    batch_view_dirs(b, u, &s);
+    memset(diff_r, 0, sizeof(diff_r)); memset(diff_g, 0, sizeof(diff_g)); memset(diff_b, 0, sizeof(diff_b));
+    memset(spec_r, 0, sizeof(spec_r)); memset(spec_g, 0, sizeof(spec_g)); memset(spec_b, 0, sizeof(spec_b));
+
+    float *const diff[3] = { diff_r, diff_g, diff_b }, *const spec[3] = { spec_r, spec_g, spec_b };
+    batch_point_lights(b, u, &s, 0.7f, diff, spec);
+
+    _Alignas(32) float sun_kd[FRAGMENT_BATCH], sun_ks[FRAGMENT_BATCH];
+    if (batch_sun(b, u, &s, sun_kd, sun_ks)) {
+        for (int p = 0; p < b->count; p += SIMD_WIDTH) {
+            f32x8 kd = f32x8_load(&sun_kd[p]), ks = f32x8_load(&sun_ks[p]);
+            f32x8_store(&diff_r[p], f32x8_load(&diff_r[p]) + u->sun.color.x * kd);
+            f32x8_store(&diff_g[p], f32x8_load(&diff_g[p]) + u->sun.color.y * kd);
+            f32x8_store(&diff_b[p], f32x8_load(&diff_b[p]) + u->sun.color.z * kd);
+            f32x8_store(&spec_r[p], f32x8_load(&spec_r[p]) + u->sun.color.x * ks);
+            f32x8_store(&spec_g[p], f32x8_load(&spec_g[p]) + u->sun.color.y * ks);
+            f32x8_store(&spec_b[p], f32x8_load(&spec_b[p]) + u->sun.color.z * ks);
+        }
+    }
+
+    for (int p = 0; p < b->count; p += SIMD_WIDTH) {
+        u32x8_store(&out[p], shader_pack_color8(u,
+            u->base_color.x * (0.01f + f32x8_load(&diff_r[p])) + f32x8_load(&spec_r[p]),
+            u->base_color.y * (0.01f + f32x8_load(&diff_g[p])) + f32x8_load(&spec_g[p]),
+            u->base_color.z * (0.01f + f32x8_load(&diff_b[p])) + f32x8_load(&spec_b[p])));
+    }
+}
+
+void bs_normals(const FragmentBatch *b, void *uniforms, uint32_t *out) {
+    const Uniforms *u = (const Uniforms*)uniforms;
+    for (int p = 0; p < b->count; p += SIMD_WIDTH) {
+        f32x8 nx = f32x8_load(&b->nx[p]), ny = f32x8_load(&b->ny[p]), nz = f32x8_load(&b->nz[p]);
+        f32x8 inv_len = f32x8_rsqrt(nx * nx + ny * ny + nz * nz);
+        u32x8_store(&out[p], shader_pack_color8(u, nx * inv_len * 0.5f + 0.5f, ny * inv_len * 0.5f + 0.5f, nz * inv_len * 0.5f + 0.5f));
+    }
+}
+
+void bs_pure_color(const FragmentBatch *b, void *uniforms, uint32_t *out) {
+    const Uniforms *u = (const Uniforms*)uniforms;
+    uint32_t c = shader_pack_color(u, u->base_color);
+    for (int i = 0; i < b->count; i++) out[i] = c;
+}
+
+// Shaders without a SIMD port still get a batch kernel: the per-pixel call
+// is direct, so the shader body is inlined into the loop
+#define DEFINE_BATCH_LOOP(name) \
+    void bs_##name(const FragmentBatch *b, void *uniforms, uint32_t *out) { \
+        for (int i = 0; i < b->count; i++) { \
+            if ((b->mask >> i) & 1) out[i] = fs_##name(b->tri[i >> 2], b->b0[i], b->b1[i], b->b2[i], uniforms); \
+        } \
+    }
+DEFINE_BATCH_LOOP(wireframe)
+DEFINE_BATCH_LOOP(plasma_glow)
+DEFINE_BATCH_LOOP(cyber_neon)
+
+// Every built-in fragment shader with its batched kernel
+#define SHADER_TABLE(X) \
+    X(multi_light) X(multi_light_smooth) X(pure_color) X(wireframe) \
+    X(normals) X(plasma_glow) X(cyber_neon) X(textured)
+
+BatchShader shader_get_batch(FragmentShader fs) {
+#define SHADER_BATCH(name) if (fs == fs_##name) return bs_##name;
+    SHADER_TABLE(SHADER_BATCH)
+#undef SHADER_BATCH
+    return NULL;
+}
+
+int shader_uses_time(FragmentShader fs) {
+    return fs == fs_plasma_glow || fs == fs_cyber_neon;
+}
+
+const char* shader_get_name(FragmentShader fs) {
+#define SHADER_NAME(name) if (fs == fs_##name) return "fs_" #name;
+    SHADER_TABLE(SHADER_NAME)
+#undef SHADER_NAME
+    return NULL;
+}
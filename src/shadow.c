@@ -0,0 +1,183 @@
+#include "shadow.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SHADOW_TILE        64
+#define SHADOW_CUBE_NEAR   0.5f
+#define SHADOW_SPLIT_BLEND 0.6f   // 0 splits the cascades evenly, 1 logarithmically
+
+static void shadow_clear_depth(ShadowMap *m) {
+    for (size_t i = 0; i < (size_t)m->size * m->size; i++) m->depth[i] = 1.0f;   // Lit until rendered
+    m->version++;
+}
+
+static float* shadow_alloc_depth(int size) {
+    float *d = malloc((size_t)size * size * sizeof(float));
+    if (!d) { fprintf(stderr, "Out of memory\n"); exit(1); }
+    return d;
+}
+
+/* --- 1. LIFECYCLE --- */
+
+ShadowSystem* shadow_system_create(int size, int threads) {
+    if (size <= 0 || threads <= 0) return NULL;
+    ShadowSystem *s = calloc(1, sizeof(ShadowSystem));
+    s->size = size;
+    s->budget = SHADOW_DEFAULT_BUDGET;
+    s->sun_distance = 150.0f;
+    s->renderer = renderer_create(size, size, threads, SHADOW_TILE, SHADOW_TILE);
+    // Casters are drawn two-sided: meshes need not be closed, and acne is
+    // handled by the normal offset at lookup
+    renderer_set_cull_mode(s->renderer, CULL_NONE);
+    renderer_set_depth_mode(s->renderer, DEPTH_LESS);
+
+    for (int c = 0; c < SHADOW_MAX_CUBES; c++) {
+        s->cubes[c].light = -1;
+        for (int f = 0; f < SHADOW_CUBE_FACES; f++) {
+            s->cubes[c].faces[f].size = size;
+            s->cubes[c].faces[f].depth = shadow_alloc_depth(size);
+            shadow_clear_depth(&s->cubes[c].faces[f]);
+        }
+    }
+    for (int i = 0; i < SHADOW_CASCADES; i++) {
+        s->sun.maps[i].size = size;
+        s->sun.maps[i].depth = shadow_alloc_depth(size);
+        shadow_clear_depth(&s->sun.maps[i]);
+    }
+    s->sun.pending = (1u << SHADOW_CASCADES) - 1;
+    return s;
+}
+
+void shadow_system_destroy(ShadowSystem *s) {
+    if (!s) return;
+    for (int c = 0; c < SHADOW_MAX_CUBES; c++) {
+        for (int f = 0; f < SHADOW_CUBE_FACES; f++) free(s->cubes[c].faces[f].depth);
+    }
+    for (int i = 0; i < SHADOW_CASCADES; i++) free(s->sun.maps[i].depth);
+    renderer_destroy(s->renderer);
+    free(s);
+}
+
+void shadow_cube_assign(ShadowCube *c, int light) {
+    c->light = light;
+    c->far = 0.0f;
+    c->pending = light >= 0 ? (1u << SHADOW_CUBE_FACES) - 1 : 0;
+    if (light < 0) return;
+    for (int f = 0; f < SHADOW_CUBE_FACES; f++) shadow_clear_depth(&c->faces[f]);
+}
+
+/* --- 2. VIEWS --- */
+
+mat4 shadow_cube_face_matrix(vec3 position, int face, float far) {
+    static const vec3 dirs[SHADOW_CUBE_FACES] = { {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1} };
+    static const vec3 ups[SHADOW_CUBE_FACES]  = { {0, 1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}, {0, 1, 0}, {0, 1, 0} };
+    mat4 view = mat4_lookat(position, vec3_add(position, dirs[face]), ups[face]);
+    return mat4_mul(mat4_perspective(TO_RAD(90.0f), 1.0f, SHADOW_CUBE_NEAR, far), view);
+}
+
+mat4 shadow_cascade_matrix(ShadowCascades *c, int i, const ShadowSystem *s, const Camera *cam, float aspect,
+                           vec3 scene_min, vec3 scene_max) {
+    // Practical split scheme: a blend of even and logarithmic slices
+    float near = cam->znear, far = MIN(cam->zfar, s->sun_distance);
+    for (int k = 0; k < SHADOW_CASCADES; k++) {
+        float t = (float)(k + 1) / SHADOW_CASCADES;
+        float even = near + (far - near) * t, logarithmic = near * powf(far / near, t);
+        c->split_far[k] = even + (logarithmic - even) * SHADOW_SPLIT_BLEND;
+    }
+    float slice_near = i == 0 ? near : c->split_far[i - 1], slice_far = c->split_far[i];
+
+    // A sphere around the slice keeps the map size constant as the camera turns
+    float tan_half = tanf(TO_RAD(cam->fov) * 0.5f);
+    float spread = tan_half * tan_half * (1.0f + aspect * aspect);
+    float mid = (slice_near + slice_far) * 0.5f;
+    float radius = sqrtf(MAX((slice_far - mid) * (slice_far - mid) + slice_far * slice_far * spread,
+                             (slice_near - mid) * (slice_near - mid) + slice_near * slice_near * spread));
+    vec3 center = vec3_add(cam->position, vec3_mul(c->cam_forward, mid));
+
+    // Snap the centre to whole texels in light space, so static shadows do not
+    // crawl and a camera that stays within a texel reproduces the same matrix
+    vec3 to_light = c->to_light;
+    vec3 up = fabsf(to_light.y) > 0.99f ? (vec3){0.0f, 0.0f, 1.0f} : (vec3){0.0f, 1.0f, 0.0f};
+    mat4 view = mat4_lookat((vec3){0.0f, 0.0f, 0.0f}, vec3_mul(to_light, -1.0f), up);
+    float texel = 2.0f * radius / (float)s->size;
+    vec4 lc = mat4_mul_vec4(view, (vec4){center.x, center.y, center.z, 1.0f});
+    lc.x = floorf(lc.x / texel) * texel;
+    lc.y = floorf(lc.y / texel) * texel;
+    lc.z = floorf(lc.z / texel) * texel;
+
+    // Reach back towards the light far enough to catch every caster in the scene
+    float back = 0.0f;
+    for (int k = 0; k < 8; k++) {
+        vec3 corner = { (k & 1) ? scene_max.x : scene_min.x, (k & 2) ? scene_max.y : scene_min.y, (k & 4) ? scene_max.z : scene_min.z };
+        back = MAX(back, vec3_dot(vec3_sub(corner, center), to_light));
+    }
+    back = ceilf(back / texel) * texel;
+    float depth = -lc.z;   // Distance along the light direction
+    mat4 proj = mat4_ortho(lc.x - radius, lc.x + radius, lc.y - radius, lc.y + radius, depth - radius - back, depth + radius);
+    c->maps[i].texel_world = texel;
+    return mat4_mul(proj, view);
+}
+
+/* --- 3. RENDERING --- */
+
+void shadow_map_begin(ShadowSystem *s, ShadowMap *m, mat4 view_proj, float texel_world) {
+    m->view_proj = view_proj;
+    m->texel_world = texel_world;
+    renderer_reset(s->renderer);
+    renderer_clear_depth(s->renderer, 1.0f);
+}
+
+void shadow_map_end(ShadowSystem *s, ShadowMap *m) {
+    renderer_bin_triangles(s->renderer);
+    renderer_rasterize(s->renderer);
+    memcpy(m->depth, s->renderer->depth_buffer, (size_t)m->size * m->size * sizeof(float));
+    m->version++;
+}
+
+/* --- 4. LOOKUP --- */
+
+// 3x3 percentage-closer filter around the texel holding `p`
+static float shadow_map_pcf(const ShadowMap *m, vec3 p) {
+    vec4 c = mat4_mul_vec4(m->view_proj, (vec4){p.x, p.y, p.z, 1.0f});
+    if (c.w <= 0.0f) return 1.0f;
+    float inv_w = 1.0f / c.w;
+    float z = c.z * inv_w * 0.5f + 0.5f;
+    if (z >= 1.0f) return 1.0f;   // Beyond the far plane: nothing was rendered there
+
+    // Same NDC-to-pixel mapping as the vertex stage
+    int size = m->size;
+    int x = (int)floorf((c.x * inv_w + 1.0f) * 0.5f * (float)size);
+    int y = (int)floorf((1.0f - c.y * inv_w) * 0.5f * (float)size);
+    int lit = 0;
+    for (int dy = -1; dy <= 1; dy++) {
+        const float *row = &m->depth[(size_t)CLAMP(y + dy, 0, size - 1) * size];
+        for (int dx = -1; dx <= 1; dx++) lit += z <= row[CLAMP(x + dx, 0, size - 1)];
+    }
+    return (float)lit * (1.0f / 9.0f);
+}
+
+float shadow_cube_visibility(const ShadowCube *c, vec3 pos, vec3 normal) {
+    vec3 d = vec3_sub(pos, c->position);
+    float ax = fabsf(d.x), ay = fabsf(d.y), az = fabsf(d.z);
+    int face = (ax >= ay && ax >= az) ? (d.x < 0.0f) : (ay >= az) ? 2 + (d.y < 0.0f) : 4 + (d.z < 0.0f);
+    const ShadowMap *m = &c->faces[face];
+
+    // Offset by the texel footprint at this distance: along the normal, then towards the light
+    float texel = m->texel_world * MAX(ax, MAX(ay, az));
+    float len = vec3_len(d);
+    vec3 p = vec3_add(pos, vec3_mul(normal, 1.5f * texel));
+    if (len > 0.0f) p = vec3_sub(p, vec3_mul(d, texel / len));
+    return shadow_map_pcf(m, p);
+}
+
+float shadow_cascades_visibility(const ShadowCascades *c, vec3 pos, vec3 normal) {
+    float depth = vec3_dot(vec3_sub(pos, c->cam_pos), c->cam_forward);
+    for (int i = 0; i < SHADOW_CASCADES; i++) {
+        if (depth > c->split_far[i]) continue;
+        const ShadowMap *m = &c->maps[i];
+        vec3 p = vec3_add(pos, vec3_mul(normal, 1.5f * m->texel_world));
+        return shadow_map_pcf(m, vec3_add(p, vec3_mul(c->to_light, m->texel_world)));
+    }
+    return 1.0f;
+}
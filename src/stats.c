@@ -0,0 +1,152 @@
+#include "renderer.h"
+#include "shader.h"
+#include <string.h>
+
+#ifdef RENDERER_STATS
+static const char *timer_names[STAT_TIME_COUNT] = {
+    "clear_ms", "vertex_ms", "assemble_ms", "bin_ms", "raster_ms", "post_ms", "wait_ms"
+};
+
+static void stats_accumulate(RenderStats *dst, const RenderStats *src) {
+    dst->vertices_shaded            += src->vertices_shaded;
+    dst->meshlets_culled_frustum    += src->meshlets_culled_frustum;
+    dst->meshlets_culled_backface   += src->meshlets_culled_backface;
+    dst->triangles_assembled        += src->triangles_assembled;
+    dst->triangles_culled_near      += src->triangles_culled_near;
+    dst->triangles_culled_backface  += src->triangles_culled_backface;
+    dst->triangles_culled_zero_area += src->triangles_culled_zero_area;
+    dst->triangles_culled_offscreen += src->triangles_culled_offscreen;
+    dst->bins_written               += src->bins_written;
+    dst->pixels_tested              += src->pixels_tested;
+    dst->pixels_depth_rejected      += src->pixels_depth_rejected;
+    dst->pixels_shaded              += src->pixels_shaded;
+    dst->quads_shaded               += src->quads_shaded;
+    dst->quad_helper_lanes          += src->quad_helper_lanes;
+    dst->batches_shaded             += src->batches_shaded;
+    dst->oit_fragments              += src->oit_fragments;
+    dst->oit_fragments_dropped      += src->oit_fragments_dropped;
+    dst->temporal_reused            += src->temporal_reused;
+    dst->temporal_shaded            += src->temporal_shaded;
+    for (int i = 0; i < STATS_MAX_SHADERS; i++) dst->fs_invocations[i] += src->fs_invocations[i];
+    for (int i = 0; i < STAT_TIME_COUNT; i++) dst->stage_ms[i] += src->stage_ms[i];
+}
+
+static const char* stats_shader_name(const Renderer *r, int slot, char *buf, size_t len) {
+    if (!r->stats_shaders[slot]) return "depth_only";
+    const char *name = shader_get_name(r->stats_shaders[slot]);
+    if (name) return name;
+    snprintf(buf, len, "shader_%d", slot);
+    return buf;
+}
+
+static void stats_write_csv_row(const Renderer *r, FILE *f, const char *thread, const RenderStats *s) {
+    fprintf(f, "%llu,%s,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu",
+        (unsigned long long)r->stats_frame, thread,
+        (unsigned long long)s->vertices_shaded,
+        (unsigned long long)s->meshlets_culled_frustum, (unsigned long long)s->meshlets_culled_backface,
+        (unsigned long long)s->triangles_assembled,
+        (unsigned long long)s->triangles_culled_near, (unsigned long long)s->triangles_culled_backface,
+        (unsigned long long)s->triangles_culled_zero_area, (unsigned long long)s->triangles_culled_offscreen,
+        (unsigned long long)s->bins_written, (unsigned long long)s->pixels_tested,
+        (unsigned long long)s->pixels_depth_rejected, (unsigned long long)s->pixels_shaded,
+        (unsigned long long)s->quads_shaded, (unsigned long long)s->quad_helper_lanes,
+        (unsigned long long)s->batches_shaded,
+        (unsigned long long)s->oit_fragments, (unsigned long long)s->oit_fragments_dropped,
+        (unsigned long long)s->temporal_reused, (unsigned long long)s->temporal_shaded);
+    for (int i = 0; i < STAT_TIME_COUNT; i++) fprintf(f, ",%.4f", s->stage_ms[i]);
+    for (int i = 0; i < r->stats_shader_count; i++) fprintf(f, ",%llu", (unsigned long long)s->fs_invocations[i]);
+    fputc('\n', f);
+}
+
+static void stats_write_json_object(const Renderer *r, FILE *f, const RenderStats *s) {
+    char buf[32];
+    fprintf(f, "{\"vertices_shaded\":%llu,\"meshlets_culled_frustum\":%llu,\"meshlets_culled_backface\":%llu,"
+               "\"triangles_assembled\":%llu,"
+               "\"culled_near\":%llu,\"culled_backface\":%llu,\"culled_zero_area\":%llu,\"culled_offscreen\":%llu,"
+               "\"bins_written\":%llu,\"pixels_tested\":%llu,\"pixels_depth_rejected\":%llu,\"pixels_shaded\":%llu,"
+               "\"quads_shaded\":%llu,\"quad_helper_lanes\":%llu,\"batches_shaded\":%llu,"
+               "\"oit_fragments\":%llu,\"oit_fragments_dropped\":%llu,\"temporal_reused\":%llu,\"temporal_shaded\":%llu",
+        (unsigned long long)s->vertices_shaded,
+        (unsigned long long)s->meshlets_culled_frustum, (unsigned long long)s->meshlets_culled_backface,
+        (unsigned long long)s->triangles_assembled,
+        (unsigned long long)s->triangles_culled_near, (unsigned long long)s->triangles_culled_backface,
+        (unsigned long long)s->triangles_culled_zero_area, (unsigned long long)s->triangles_culled_offscreen,
+        (unsigned long long)s->bins_written, (unsigned long long)s->pixels_tested,
+        (unsigned long long)s->pixels_depth_rejected, (unsigned long long)s->pixels_shaded,
+        (unsigned long long)s->quads_shaded, (unsigned long long)s->quad_helper_lanes,
+        (unsigned long long)s->batches_shaded,
+        (unsigned long long)s->oit_fragments, (unsigned long long)s->oit_fragments_dropped,
+        (unsigned long long)s->temporal_reused, (unsigned long long)s->temporal_shaded);
+    for (int i = 0; i < STAT_TIME_COUNT; i++) fprintf(f, ",\"%s\":%.4f", timer_names[i], s->stage_ms[i]);
+    fprintf(f, ",\"fs_invocations\":{");
+    for (int i = 0; i < r->stats_shader_count; i++) {
+        fprintf(f, "%s\"%s\":%llu", i ? "," : "", stats_shader_name(r, i, buf, sizeof(buf)),
+            (unsigned long long)s->fs_invocations[i]);
+    }
+    fprintf(f, "}}");
+}
+#endif
+
+void renderer_stats_collect(const Renderer *r, RenderStats *out_total) {
+    memset(out_total, 0, sizeof(*out_total));
+#ifdef RENDERER_STATS
+    for (int t = 0; t < r->thread_count; t++) stats_accumulate(out_total, &r->thread_stats[t]);
+#else
+    (void)r;
+#endif
+}
+
+const RenderStats* renderer_stats_thread(const Renderer *r, int thread) {
+#ifdef RENDERER_STATS
+    if (thread < 0 || thread >= r->thread_count) return NULL;
+    return &r->thread_stats[thread];
+#else
+    (void)r; (void)thread;
+    return NULL;
+#endif
+}
+
+// One row per thread plus a "total" row; timings are summed thread time.
+void renderer_stats_dump_csv(const Renderer *r, FILE *f, int write_header) {
+#ifdef RENDERER_STATS
+    if (write_header) {
+        char buf[32];
+        fprintf(f, "frame,thread,vertices_shaded,meshlets_culled_frustum,meshlets_culled_backface,triangles_assembled,culled_near,culled_backface,"
+                   "culled_zero_area,culled_offscreen,bins_written,pixels_tested,pixels_depth_rejected,pixels_shaded,"
+                   "quads_shaded,quad_helper_lanes,batches_shaded,oit_fragments,oit_fragments_dropped,"
+                   "temporal_reused,temporal_shaded");
+        for (int i = 0; i < STAT_TIME_COUNT; i++) fprintf(f, ",%s", timer_names[i]);
+        for (int i = 0; i < r->stats_shader_count; i++) fprintf(f, ",%s", stats_shader_name(r, i, buf, sizeof(buf)));
+        fputc('\n', f);
+    }
+
+    char name[16];
+    for (int t = 0; t < r->thread_count; t++) {
+        snprintf(name, sizeof(name), "%d", t);
+        stats_write_csv_row(r, f, name, &r->thread_stats[t]);
+    }
+    RenderStats total;
+    renderer_stats_collect(r, &total);
+    stats_write_csv_row(r, f, "total", &total);
+#else
+    (void)r; (void)f; (void)write_header;
+#endif
+}
+
+void renderer_stats_dump_json(const Renderer *r, FILE *f) {
+#ifdef RENDERER_STATS
+    RenderStats total;
+    renderer_stats_collect(r, &total);
+
+    fprintf(f, "{\"frame\":%llu,\"total\":", (unsigned long long)r->stats_frame);
+    stats_write_json_object(r, f, &total);
+    fprintf(f, ",\"threads\":[");
+    for (int t = 0; t < r->thread_count; t++) {
+        if (t) fputc(',', f);
+        stats_write_json_object(r, f, &r->thread_stats[t]);
+    }
+    fprintf(f, "]}\n");
+#else
+    (void)r; (void)f;
+#endif
+}
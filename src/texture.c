@@ -0,0 +1,205 @@
+#include "texture.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void* texture_alloc(size_t bytes) {
+    void *ptr = malloc(bytes ? bytes : 1);
+    if (!ptr) { fprintf(stderr, "Out of memory\n"); exit(1); }
+    return ptr;
+}
+
+/* --- 1. STORAGE & MIP CHAIN --- */
+
+// Copies row-major pixels into the tiled layout; edge tiles are padded with
+// the nearest pixel so they never hold garbage
+static void level_store(TextureLevel *l, int width, int height, const uint32_t *pixels) {
+    l->width = width;
+    l->height = height;
+    l->tiles_x = (width + TEXTURE_TILE - 1) >> TEXTURE_TILE_SHIFT;
+    int tiles_y = (height + TEXTURE_TILE - 1) >> TEXTURE_TILE_SHIFT;
+    l->texels = texture_alloc((size_t)l->tiles_x * tiles_y * TEXTURE_TILE * TEXTURE_TILE * sizeof(uint32_t));
+
+    for (int y = 0; y < tiles_y * TEXTURE_TILE; y++) {
+        const uint32_t *row = pixels + (size_t)MIN(y, height - 1) * width;
+        for (int x = 0; x < l->tiles_x * TEXTURE_TILE; x++) {
+            int tile = (y >> TEXTURE_TILE_SHIFT) * l->tiles_x + (x >> TEXTURE_TILE_SHIFT);
+            l->texels[(tile << (2 * TEXTURE_TILE_SHIFT)) | ((y & (TEXTURE_TILE - 1)) << TEXTURE_TILE_SHIFT) | (x & (TEXTURE_TILE - 1))] = row[MIN(x, width - 1)];
+        }
+    }
+}
+
+// 2x2 box filter; odd sizes fold the last row/column into the previous texel
+static void level_downsample(const uint32_t *src, int sw, int sh, uint32_t *dst, int dw, int dh) {
+    for (int y = 0; y < dh; y++) {
+        int y0 = MIN(y * 2, sh - 1), y1 = MIN(y * 2 + 1, sh - 1);
+        for (int x = 0; x < dw; x++) {
+            int x0 = MIN(x * 2, sw - 1), x1 = MIN(x * 2 + 1, sw - 1);
+            f32x4 sum = f32x4_from_rgba8(src[y0 * sw + x0]) + f32x4_from_rgba8(src[y0 * sw + x1]) +
+                        f32x4_from_rgba8(src[y1 * sw + x0]) + f32x4_from_rgba8(src[y1 * sw + x1]);
+            sum = sum * 0.25f + 0.5f;
+            dst[y * dw + x] = ((uint32_t)sum[0] << 24) | ((uint32_t)sum[1] << 16) | ((uint32_t)sum[2] << 8) | (uint32_t)sum[3];
+        }
+    }
+}
+
+Texture* texture_create(int width, int height, const uint32_t *pixels) {
+    if (width <= 0 || height <= 0 || !pixels) return NULL;
+    Texture *tex = calloc(1, sizeof(Texture));
+
+    // Mips are filtered from the row-major level above, then tiled
+    uint32_t *scratch[2] = { texture_alloc((size_t)width * height * sizeof(uint32_t)), NULL };
+    scratch[1] = texture_alloc((size_t)MAX(width / 2, 1) * MAX(height / 2, 1) * sizeof(uint32_t));
+    memcpy(scratch[0], pixels, (size_t)width * height * sizeof(uint32_t));
+
+    int w = width, h = height;
+    while (tex->level_count < TEXTURE_MAX_LEVELS) {
+        level_store(&tex->levels[tex->level_count++], w, h, scratch[0]);
+        if (w == 1 && h == 1) break;
+        int nw = MAX(w / 2, 1), nh = MAX(h / 2, 1);
+        level_downsample(scratch[0], w, h, scratch[1], nw, nh);
+        uint32_t *t = scratch[0]; scratch[0] = scratch[1]; scratch[1] = t;
+        w = nw; h = nh;
+    }
+
+    free(scratch[0]);
+    free(scratch[1]);
+    return tex;
+}
+
+void texture_destroy(Texture *tex) {
+    if (!tex) return;
+    for (int i = 0; i < tex->level_count; i++) free(tex->levels[i].texels);
+    free(tex);
+}
+
+/* --- 2. FILE LOADING --- */
+
+static int ppm_read_int(FILE *f, int *out) {
+    int c = fgetc(f);
+    while (c == '#' || (c != EOF && (c == ' ' || c == '\t' || c == '\n' || c == '\r'))) {
+        if (c == '#') while (c != EOF && c != '\n') c = fgetc(f);
+        c = fgetc(f);
+    }
+    if (c == EOF) return 0;
+    ungetc(c, f);
+    return fscanf(f, "%d", out) == 1;
+}
+
+static uint32_t* load_ppm(FILE *f, int *w, int *h) {
+    int maxval;
+    if (!ppm_read_int(f, w) || !ppm_read_int(f, h) || !ppm_read_int(f, &maxval) || maxval != 255) return NULL;
+    if (*w <= 0 || *h <= 0) return NULL;
+    fgetc(f); // Single whitespace before the raster
+
+    size_t count = (size_t)*w * *h;
+    uint8_t *rgb = texture_alloc(count * 3);
+    uint32_t *pixels = NULL;
+    if (fread(rgb, 3, count, f) == count) {
+        pixels = texture_alloc(count * sizeof(uint32_t));
+        for (size_t i = 0; i < count; i++) {
+            pixels[i] = ((uint32_t)rgb[i * 3] << 24) | ((uint32_t)rgb[i * 3 + 1] << 16) | ((uint32_t)rgb[i * 3 + 2] << 8) | 0xFF;
+        }
+    }
+    free(rgb);
+    return pixels;
+}
+
+static uint32_t* load_tga(FILE *f, int *w, int *h) {
+    uint8_t hdr[18];
+    if (fread(hdr, 1, sizeof(hdr), f) != sizeof(hdr)) return NULL;
+    int bpp = hdr[16];
+    if (hdr[1] != 0 || hdr[2] != 2 || (bpp != 24 && bpp != 32)) return NULL; // Uncompressed true-colour only
+    *w = hdr[12] | (hdr[13] << 8);
+    *h = hdr[14] | (hdr[15] << 8);
+    if (*w <= 0 || *h <= 0) return NULL;
+    int top_first = (hdr[17] & 0x20) != 0;
+    fseek(f, hdr[0], SEEK_CUR); // Image ID
+
+    size_t count = (size_t)*w * *h, stride = bpp / 8;
+    uint8_t *bgra = texture_alloc(count * stride);
+    uint32_t *pixels = NULL;
+    if (fread(bgra, stride, count, f) == count) {
+        pixels = texture_alloc(count * sizeof(uint32_t));
+        for (int y = 0; y < *h; y++) {
+            const uint8_t *src = bgra + (size_t)(top_first ? y : *h - 1 - y) * *w * stride;
+            for (int x = 0; x < *w; x++, src += stride) {
+                uint32_t a = stride == 4 ? src[3] : 0xFF;
+                pixels[(size_t)y * *w + x] = ((uint32_t)src[2] << 24) | ((uint32_t)src[1] << 16) | ((uint32_t)src[0] << 8) | a;
+            }
+        }
+    }
+    free(bgra);
+    return pixels;
+}
+
+Texture* texture_load(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Failed to open texture: %s\n", path);
+        return NULL;
+    }
+
+    int w = 0, h = 0;
+    uint32_t *pixels = NULL;
+    char magic[2];
+    if (fread(magic, 1, 2, f) == 2 && magic[0] == 'P' && magic[1] == '6') {
+        pixels = load_ppm(f, &w, &h);
+    } else {
+        rewind(f);
+        pixels = load_tga(f, &w, &h);
+    }
+    fclose(f);
+
+    if (!pixels) {
+        fprintf(stderr, "Unsupported or corrupt texture: %s\n", path);
+        return NULL;
+    }
+    Texture *tex = texture_create(w, h, pixels);
+    free(pixels);
+    printf("Texture Loaded: %dx%d, %d levels\n", w, h, tex->level_count);
+    return tex;
+}
+
+/* --- 3. SAMPLING --- */
+
+float texture_lod(const Texture *tex, float du_dx, float dv_dx, float du_dy, float dv_dy) {
+    float w = (float)tex->levels[0].width, h = (float)tex->levels[0].height;
+    float dx = (du_dx * w) * (du_dx * w) + (dv_dx * h) * (dv_dx * h);
+    float dy = (du_dy * w) * (du_dy * w) + (dv_dy * h) * (dv_dy * h);
+    float rho_sq = MAX(dx, dy);
+    if (rho_sq <= 1.0f) return 0.0f;
+    return MIN(0.5f * log2f(rho_sq), (float)(tex->level_count - 1));
+}
+
+static inline int wrap_coord(int c, int size) {
+    c %= size;
+    return c < 0 ? c + size : c;
+}
+
+f32x4 texture_sample_bilinear(const Texture *tex, int level, float u, float v) {
+    const TextureLevel *l = &tex->levels[level];
+    float fx = (u - floorf(u)) * l->width - 0.5f;
+    float fy = (1.0f - (v - floorf(v))) * l->height - 0.5f;
+    float x0f = floorf(fx), y0f = floorf(fy);
+    float tx = fx - x0f, ty = fy - y0f;
+
+    int x0 = wrap_coord((int)x0f, l->width), x1 = wrap_coord((int)x0f + 1, l->width);
+    int y0 = wrap_coord((int)y0f, l->height), y1 = wrap_coord((int)y0f + 1, l->height);
+
+    f32x4 c00 = f32x4_from_rgba8(texture_fetch(l, x0, y0)), c10 = f32x4_from_rgba8(texture_fetch(l, x1, y0));
+    f32x4 c01 = f32x4_from_rgba8(texture_fetch(l, x0, y1)), c11 = f32x4_from_rgba8(texture_fetch(l, x1, y1));
+    f32x4 top = c00 + (c10 - c00) * tx;
+    f32x4 bottom = c01 + (c11 - c01) * tx;
+    return (top + (bottom - top) * ty) * (1.0f / 255.0f);
+}
+
+f32x4 texture_sample_trilinear(const Texture *tex, float u, float v, float lod) {
+    lod = CLAMP(lod, 0.0f, (float)(tex->level_count - 1));
+    int level = (int)lod;
+    float frac = lod - (float)level;
+    f32x4 a = texture_sample_bilinear(tex, level, u, v);
+    if (frac <= 0.0f || level + 1 >= tex->level_count) return a;
+    f32x4 b = texture_sample_bilinear(tex, level + 1, u, v);
+    return a + (b - a) * frac;
+}
@@ -0,0 +1,61 @@
+#include "renderer.h"
+#include <stdio.h>
+
+#ifdef RENDERER_TRACE
+static const char *trace_event_names[TRACE_EVENT_COUNT] = {
+    "clear", "vertex", "assemble", "bin", "tile", "post", "wait_for_workers", "frame"
+};
+#endif
+
+void renderer_trace_enable(Renderer *r, int enabled) {
+#ifdef RENDERER_TRACE
+    r->trace_enabled = enabled;
+#else
+    (void)r; (void)enabled;
+#endif
+}
+
+// Writes the Chrome trace event format (chrome://tracing, ui.perfetto.dev).
+// Returns 0 on success, -1 if the file could not be written or tracing is compiled out.
+int renderer_trace_dump(const Renderer *r, const char *path) {
+#ifdef RENDERER_TRACE
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Failed to open trace file: %s\n", path);
+        return -1;
+    }
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    int first = 1;
+    for (int t = 0; t < r->thread_count; t++) {
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}}",
+            first ? "" : ",\n", t, t == 0 ? "main" : "worker", t);
+        first = 0;
+    }
+
+    for (int t = 0; t < r->thread_count; t++) {
+        const TraceRing *ring = &r->trace_rings[t];
+        uint_fast64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        uint_fast64_t start = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+
+        for (uint_fast64_t i = start; i < head; i++) {
+            const TraceEvent *e = &ring->events[i & (TRACE_RING_SIZE - 1)];
+            const char *name = trace_event_names[e->type];
+            if (e->type == TRACE_FRAME) {
+                fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":%d,\"ts\":%.3f}",
+                    name, t, e->begin_us);
+            } else {
+                fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"renderer\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,"
+                           "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"id\":%d}}",
+                    name, t, e->begin_us, e->end_us - e->begin_us, (int)e->arg);
+            }
+        }
+    }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+    return 0;
+#else
+    (void)r; (void)path;
+    return -1;
+#endif
+}